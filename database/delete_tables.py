@@ -21,6 +21,9 @@ def main():
     cur.execute("""
         DROP TABLE terms;
     """)
+    cur.execute("""
+        DROP TABLE IF EXISTS segments;
+    """)
     conn.close()
 
 
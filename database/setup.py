@@ -15,6 +15,8 @@ def main():
     args = parse_input()
     conn = sqlite3.connect(args.database_path)
     cur = conn.cursor()
+    # Write-ahead logging lets the searcher read consistent snapshots while new transcripts are written
+    cur.execute("PRAGMA journal_mode=WAL")
     cur.execute("""
         CREATE TABLE IF NOT EXISTS documents (
             file varchar(255),
@@ -29,6 +31,15 @@ def main():
             documents text
         )
     """)
+    # Timed segments of each transcript (times in seconds), for passage-level search
+    cur.execute("""
+        CREATE TABLE IF NOT EXISTS segments (
+            file varchar(255),
+            start real,
+            end real,
+            transcription text
+        )
+    """)
     conn.close()
 
 
@@ -19,6 +19,9 @@ def main():
     for entry in result.fetchall():
         print(entry)
     result = cur.execute("SELECT * FROM terms")
+    for entry in result.fetchall():
+        print(entry)
+    result = cur.execute("SELECT * FROM segments")
     for entry in result.fetchall():
         print(entry)
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * An occurrence of a pattern found by an AhoCorasickAutomaton.
+*/
+struct pattern_match {
+    // Position of the first symbol of the occurrence
+    uint32_t start;
+    // Number of symbols in the pattern
+    uint32_t length;
+    // Identifier the pattern was added with
+    uint32_t pattern;
+};
+
+/**
+ * Finds every occurrence of a set of patterns in a single pass over a text, however many patterns there are.
+ *
+ * Symbols are 32-bit integers rather than characters, so that patterns can be sequences of token ids
+ * (words and whole phrases) matched against a ForwardIndex. Transitions are kept as sorted arrays per node,
+ * since the alphabet is the whole vocabulary but each node has few children.
+*/
+class AhoCorasickAutomaton {
+    public:
+        // Start with only the root node
+        AhoCorasickAutomaton();
+
+        // Remove copy constructor and copy assignment
+        AhoCorasickAutomaton(const AhoCorasickAutomaton&) = delete;
+        AhoCorasickAutomaton& operator= (const AhoCorasickAutomaton&) = delete;
+
+        /**
+         * Adds a pattern to search for. All patterns must be added before `build()`.
+         *
+         * @param symbols Non-empty sequence of symbols
+         * @param pattern Identifier reported with each occurrence of the pattern
+        */
+        void addPattern(const std::vector<uint32_t>& symbols, const uint32_t pattern);
+
+        // Computes the failure links, after which the automaton can search
+        void build();
+
+        /**
+         * Finds every occurrence of every pattern in a text, overlapping occurrences included
+         *
+         * @param text Symbols to search
+         * @param matches Set to the occurrences found, ordered by their end position
+        */
+        void findMatches(std::span<const uint32_t> text, std::vector<pattern_match>& matches) const;
+
+    private:
+        // A state of the automaton: the longest pattern prefix matching the end of the text read so far
+        struct node {
+            // Transitions on each symbol, sorted by symbol
+            std::vector<std::pair<uint32_t, uint32_t>> children;
+            // Node of the longest proper suffix which is also a pattern prefix
+            uint32_t failure = 0;
+            // Node of the longest proper suffix which is a whole pattern, or 0 if none
+            uint32_t output_link = 0;
+            // Whether a pattern ends at this node, and its identifier
+            bool is_pattern = false;
+            uint32_t pattern = 0;
+            // Number of symbols from the root to this node
+            uint32_t depth = 0;
+        };
+
+        /**
+         * Looks up a node's transition on a symbol
+         *
+         * @param state Node to move from
+         * @param symbol Symbol to move on
+         * @return Child node, or 0 if the node has no transition on the symbol
+        */
+        uint32_t findChild(const uint32_t state, const uint32_t symbol) const;
+
+        // Next state after reading a symbol, following failure links as needed
+        uint32_t step(uint32_t state, const uint32_t symbol) const;
+
+        // All nodes, the root first
+        std::vector<node> nodes;
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "coroutine_scheduler.h"
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Reads byte ranges of a file for coroutines, which `co_await` each read: the coroutine is suspended while the read is
+ * in flight, and resumed on a CoroutineScheduler's worker thread once it completes.
+ *
+ * Reads are submitted to an io_uring when the kernel allows one (set up directly through its system calls), so a
+ * single thread waits for all their completions, submitting the rest of any read which completes short. Otherwise
+ * they are served by a pool of threads calling `pread`, as many reads in flight at once as there are threads. Errors
+ * of the io_uring itself fail the reads they affect (and every later read, if the completions can no longer be waited
+ * for), rather than the thread.
+ *
+ * The reader must outlive every read in flight, and be destroyed before the scheduler it resumes coroutines on.
+*/
+class AsyncFileReader {
+    public:
+        // Remove default constructor
+        AsyncFileReader() = delete;
+
+        // Remove copy constructor and copy assignment
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator= (const AsyncFileReader&) = delete;
+
+        /**
+         * Opens a file for asynchronous reads
+         *
+         * @param path Path of the file
+         * @param scheduler Scheduler to resume the reading coroutines on
+         * @param num_io_threads Number of threads serving reads when io_uring is unavailable
+         * @param use_io_uring Whether to submit reads to an io_uring if possible, rather than to threads
+         * @param direct_io Whether to read with O_DIRECT, bypassing the page cache, in which case reads must be
+         * aligned (offset, size and buffer) to the file system's block size
+        */
+        AsyncFileReader(
+            const std::string& path,
+            CoroutineScheduler& scheduler,
+            const unsigned int num_io_threads,
+            const bool use_io_uring = true,
+            const bool direct_io = false
+        );
+
+        // A read in flight, living in the awaiting coroutine's frame
+        struct read_request {
+            uint64_t offset;
+            void* buffer;
+            size_t size;
+            std::coroutine_handle<> handle;
+            // Number of bytes read, or minus the error number
+            ssize_t result;
+            // Number of bytes read so far, by the completions of a read which came short
+            size_t done;
+        };
+
+        // Awaiting the result suspends the coroutine until its read completes, and returns the number of bytes read
+        struct read_awaiter {
+            AsyncFileReader& reader;
+            read_request request;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                request.handle = handle;
+                reader.submit(&request);
+            }
+            size_t await_resume() const;
+        };
+
+        /**
+         * Reads a byte range of the file
+         *
+         * @param offset Offset of the range in the file
+         * @param buffer Where to read the range to, which must stay valid until the read completes
+         * @param size Size of the range in bytes
+         * @return Awaitable of the number of bytes read, fewer than `size` only at the end of the file
+        */
+        read_awaiter read(const uint64_t offset, void* buffer, const size_t size) { return {*this, {offset, buffer, size, {}, 0, 0}}; }
+
+        // `true` if reads are submitted to an io_uring, `false` if they are served by threads
+        bool usesIoUring() const { return ring_descriptor >= 0; }
+
+        // Path of the file
+        const std::string& getPath() const { return path; }
+
+        // Finish the reads in flight and close the file
+        ~AsyncFileReader();
+
+    private:
+        // Starts a read, resuming its coroutine once it completes
+        void submit(read_request* request);
+
+        /**
+         * Sets up the io_uring
+         *
+         * @return `true` if the kernel allowed one
+        */
+        bool setUpRing();
+
+        /**
+         * Adds a request's read (of the part not read yet) to the submission queue of the io_uring, guarded by
+         * `submit_mutex`
+         *
+         * @param request Read to submit (`nullptr` for a no-op waking the completion thread)
+         * @return `false` if the kernel refused the submission, with `errno` set
+        */
+        bool pushSubmission(read_request* request);
+
+        /**
+         * Submits a read to the io_uring, or fails it if the kernel refuses it, guarded by `submit_mutex`
+         *
+         * @param request Read to submit, already counted in `in_flight`
+         * @param failed Appended the request if it failed, to be resumed once the mutex is released
+        */
+        void submitToRing(read_request* request, std::vector<read_request*>& failed);
+
+        // Main loop of the thread collecting the completions of the io_uring
+        void reapCompletions();
+
+        // Main loop of each thread serving reads with `pread`
+        void serveReads();
+
+        // Path and descriptor of the file
+        std::string path;
+        int descriptor = -1;
+        CoroutineScheduler& scheduler;
+
+        // Descriptor of the io_uring (-1 if reads are served by threads) and its mapped rings
+        int ring_descriptor = -1;
+        void* submission_ring = nullptr;
+        size_t submission_ring_size = 0;
+        void* completion_ring = nullptr;
+        size_t completion_ring_size = 0;
+        void* submission_entries = nullptr;
+        size_t submission_entries_size = 0;
+        // Fields of the rings, pointing into their mappings
+        unsigned* submission_tail = nullptr;
+        unsigned submission_mask = 0;
+        unsigned* submission_array = nullptr;
+        unsigned* completion_head = nullptr;
+        unsigned* completion_tail = nullptr;
+        unsigned completion_mask = 0;
+        void* completions = nullptr;
+        unsigned ring_entries = 0;
+        // Reads waiting for room in the io_uring, those in it (and their number), and the error which stopped the
+        // completion thread (0 while it runs), guarded by `submit_mutex`
+        std::deque<read_request*> overflow;
+        std::unordered_set<read_request*> submitted;
+        unsigned in_flight = 0;
+        int ring_error = 0;
+        std::mutex submit_mutex;
+
+        // Reads waiting for a thread, guarded by `mutex`
+        std::deque<read_request*> requests;
+        std::mutex mutex;
+        std::condition_variable requests_available;
+        bool stopping = false;
+
+        std::vector<std::thread> threads;
+};
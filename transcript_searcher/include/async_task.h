@@ -0,0 +1,80 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/**
+ * The result of a coroutine (e.g. a search) which may suspend while it waits for data, to be `co_await`ed by
+ * another coroutine or started on a CoroutineScheduler.
+ *
+ * Tasks are lazy: the coroutine only starts once awaited, and when it finishes it resumes its awaiter directly
+ * (by symmetric transfer) on whichever thread it finished on, so that chains of tasks cost no scheduling.
+*/
+template <typename T>
+class AsyncTask {
+    public:
+        struct promise_type {
+            std::optional<T> value;
+            std::exception_ptr exception;
+            // Coroutine awaiting the task, resumed once it finishes
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+
+            AsyncTask get_return_object() { return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            // Hands over to the awaiting coroutine once the task finishes
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    return handle.promise().continuation;
+                }
+                void await_resume() noexcept {}
+            };
+            final_awaiter final_suspend() noexcept { return {}; }
+
+            void return_value(T result) { value.emplace(std::move(result)); }
+
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        // Remove default constructor
+        AsyncTask() = delete;
+
+        // Remove copy constructor and copy assignment
+        AsyncTask(const AsyncTask&) = delete;
+        AsyncTask& operator= (const AsyncTask&) = delete;
+
+        // Move constructor, leaving the moved from task empty
+        AsyncTask(AsyncTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        // Destroys the coroutine's frame
+        ~AsyncTask() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        // Starts the coroutine, to resume `awaiting` once it finishes
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        // Result of the coroutine, rethrowing the exception it ended with if any
+        T await_resume() {
+            if (handle.promise().exception) {
+                std::rethrow_exception(handle.promise().exception);
+            }
+            return std::move(*handle.promise().value);
+        }
+
+    private:
+        explicit AsyncTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        std::coroutine_handle<promise_type> handle;
+};
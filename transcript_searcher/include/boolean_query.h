@@ -0,0 +1,86 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * A node of a parsed boolean query: a term, or an operator over other nodes.
+*/
+struct boolean_query_node {
+    enum node_type { TERM, AND, OR, NOT };
+    node_type type;
+    // Index of the term in the query's terms (TERM nodes only)
+    size_t term = 0;
+    // Operands of an operator (a NOT has exactly one)
+    std::vector<boolean_query_node> children;
+};
+
+/**
+ * A search parsed as a boolean expression over terms (or phrases).
+ *
+ * `AND`, `OR` and `NOT` (in upper case) combine terms, parentheses group them, and `-term` is short for `NOT term`.
+ * Terms next to each other are OR'ed, as in plain searches, and `AND` binds tighter than `OR`. A NOT excludes
+ * documents from the clause it appears in, e.g. `ice hockey -fight` matches transcripts containing ice or hockey
+ * but not fight, while a NOT on its own matches nothing.
+*/
+struct boolean_query {
+    // Root of the expression
+    boolean_query_node root;
+    // Terms (or phrases) of the query, in order of appearance
+    std::vector<std::string> terms;
+    // Whether each term is excluded (appears under a NOT), and so only filters documents rather than scoring them
+    std::vector<bool> excluded;
+};
+
+/**
+ * Checks whether search terms use any boolean operator, parenthesis or exclusion
+ *
+ * @param search_terms Vector of search terms, as entered (operators and parentheses may be their own elements or attached to terms)
+ * @return `true` if the search terms must be parsed as a boolean query, `false` for a plain search
+*/
+bool isBooleanQuery(const std::vector<std::string>& search_terms);
+
+/**
+ * Parses search terms as a boolean query
+ *
+ * A search term containing whitespace (e.g. a quoted phrase) is always a single term.
+ *
+ * @param search_terms Vector of search terms, as entered
+ * @return The parsed query
+ * @throws std::runtime_error If the query is malformed (e.g. unbalanced parentheses or a missing operand)
+*/
+boolean_query parseBooleanQuery(const std::vector<std::string>& search_terms);
+
+/**
+ * Lists the terms which should be scored and highlighted for a search, i.e. every term of a plain search,
+ * or only the terms of a boolean query which are not excluded
+ *
+ * @param search_terms Vector of search terms, as entered
+ * @return Terms (or phrases) to score
+ * @throws std::runtime_error If the search terms are a malformed boolean query
+*/
+std::vector<std::string> getIncludedTerms(const std::vector<std::string>& search_terms);
+
+/**
+ * Finds the documents matching a boolean query.
+ *
+ * Works on sorted document id lists: each AND intersects its operands rarest first, and each exclusion is
+ * subtracted from its clause, always walking the shorter list while galloping through the longer one, so that
+ * a rare term skips most of a frequent term's postings. ORs are merged.
+ *
+ * Terms with a bitmap of their documents (see InvertedIndex::getDocumentBitmap) are combined as bitmaps instead:
+ * word by word with other bitmaps, and by probing one bit per posting against a posting list. Unions with such a
+ * term are built as bitmaps, which is where frequent terms gain the most over merging posting lists.
+ *
+ * @param query Parsed query
+ * @param term_postings Posting list of each of the query's terms (sorted by document id, empty if it matches nothing)
+ * @param term_bitmaps Bitmap of the documents of each of the query's terms, or `nullptr` (or none at all) for a term without one
+ * @return Matching documents, in increasing id order
+*/
+std::vector<document_id> evaluateBooleanQuery(
+    const boolean_query& query,
+    const std::vector<std::span<const posting>>& term_postings,
+    const std::vector<const RoaringBitmap*>& term_bitmaps = {}
+);
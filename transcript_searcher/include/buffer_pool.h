@@ -0,0 +1,209 @@
+#pragma once
+
+#include "async_file_reader.h"
+#include "async_task.h"
+#include "coroutine_scheduler.h"
+#include "transcript_search_algorithm.h"
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Settings of a BufferPool.
+*/
+struct buffer_pool_options {
+    // Number of pages of the pool (0 for no pool)
+    size_t num_pages = 16384;
+    // Number of blocks following a missed one which are read along with it, as far as the caller expects to need
+    unsigned int readahead_blocks = 4;
+    // Whether blocks are read with O_DIRECT, bypassing the operating system's page cache
+    bool direct_io = false;
+};
+
+class BufferPool;
+
+/**
+ * A block pinned in a BufferPool, which cannot be evicted until the PinnedBlock is destroyed (or reassigned).
+*/
+class PinnedBlock {
+    public:
+        // An empty PinnedBlock, pinning nothing
+        PinnedBlock() = default;
+
+        // Remove copy constructor and copy assignment
+        PinnedBlock(const PinnedBlock&) = delete;
+        PinnedBlock& operator= (const PinnedBlock&) = delete;
+
+        // Move constructor and move assignment, the moved from PinnedBlock pinning nothing
+        PinnedBlock(PinnedBlock&& other) noexcept;
+        PinnedBlock& operator= (PinnedBlock&& other) noexcept;
+
+        // Contents of the block
+        const uint8_t* getData() const { return data; }
+
+        // Number of bytes of the block, fewer than the block size only at the end of the file
+        size_t getSize() const { return size; }
+
+        // Unpins the block
+        ~PinnedBlock();
+
+    private:
+        friend class BufferPool;
+
+        PinnedBlock(BufferPool* pool, const size_t page, const uint8_t* data, const size_t size)
+            : pool(pool), page(page), data(data), size(size) {}
+
+        BufferPool* pool = nullptr;
+        size_t page = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+};
+
+/**
+ * A fixed number of pages holding blocks of a file, so that the memory spent on caching an index stays the same
+ * however the operating system's page cache is shared (e.g. with O_DIRECT reads, which bypass it).
+ *
+ * Coroutines `co_await` a block (see pin): a block already in the pool is pinned without suspending, and a block
+ * already being read is waited for. Otherwise a page is taken from the block which has gone unused the longest, as
+ * approximated by CLOCK eviction: a hand sweeps the pages, sparing (once) those used since it last passed, and never
+ * taking a pinned page. The following blocks the caller expects to need are read ahead at the same time, into pages
+ * of their own.
+ *
+ * A coroutine which finds every page pinned or being read waits for one to be unpinned, so the pool must have more
+ * pages than blocks are pinned at once.
+*/
+class BufferPool {
+    public:
+        // Remove default constructor
+        BufferPool() = delete;
+
+        // Remove copy constructor and copy assignment
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator= (const BufferPool&) = delete;
+
+        /**
+         * Allocates the pages of the pool
+         *
+         * @param reader Reader of the file the blocks are read from, which must outlive the pool
+         * @param scheduler Scheduler resuming the coroutines waiting for a block, which must outlive the pool
+         * @param base_offset Offset of the first block within the file, a multiple of the block size
+         * @param block_size Size of a block (and a page) in bytes, a multiple of the file system's block size
+         * @param options Number of pages and read ahead blocks of the pool
+        */
+        BufferPool(
+            AsyncFileReader& reader,
+            CoroutineScheduler& scheduler,
+            const uint64_t base_offset,
+            const size_t block_size,
+            const buffer_pool_options& options
+        );
+
+        /**
+         * Pins a block in the pool, reading it (and the blocks following it) if it is not there yet
+         *
+         * @param block Index of the block
+         * @param last_block Index of the last block the caller expects to need after it, which bounds read ahead
+         * @return Task of the pinned block
+        */
+        AsyncTask<PinnedBlock> pin(const uint64_t block, const uint64_t last_block);
+
+        // Statistics of the pool since it was created
+        buffer_pool_statistics getStatistics() const;
+
+        // Waits for the blocks still being read ahead
+        ~BufferPool();
+
+    private:
+        friend class PinnedBlock;
+
+        // States of a page
+        enum page_state {
+            PAGE_EMPTY,
+            PAGE_LOADING,
+            PAGE_READY
+        };
+
+        /**
+         * A page of the pool and the block it holds.
+        */
+        struct page {
+            uint64_t block = 0;
+            page_state state = PAGE_EMPTY;
+            uint32_t pins = 0;
+            // Whether the page was used since the clock hand last passed it
+            bool referenced = false;
+            // Number of bytes read into the page
+            size_t size = 0;
+            // Coroutines waiting for the page's block to be read
+            std::vector<std::coroutine_handle<>> waiters;
+        };
+
+        // Awaiting the result releases `mutex` and suspends the coroutine in `waiters`, and takes `mutex` back on resuming
+        struct wait_awaiter {
+            std::mutex& mutex;
+            std::vector<std::coroutine_handle<>>& waiters;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                waiters.push_back(handle);
+                mutex.unlock();
+            }
+            void await_resume() { mutex.lock(); }
+        };
+
+        /**
+         * Finds a page to hold another block, advancing the clock hand, guarded by `mutex`
+         *
+         * @param victim Set to the page, emptied of its block
+         * @return `false` if every page is pinned or being read
+        */
+        bool takePage(size_t& victim);
+
+        /**
+         * Gives a page taken by `takePage` to a block, in the loading state, guarded by `mutex`
+         *
+         * @param index Index of the page
+         * @param block Index of the block
+        */
+        void assignPage(const size_t index, const uint64_t block);
+
+        /**
+         * Reads a block into the page assigned to it, and wakes the coroutines waiting for it
+         *
+         * @param index Index of the page, in the loading state
+         * @param ahead Whether the block is read ahead of any request, so that the pool waits for the read
+         * @return Task of the number of bytes read
+        */
+        AsyncTask<size_t> load(const size_t index, const bool ahead);
+
+        // Unpins a page, waking the coroutines waiting for a page if it is the last pin
+        void unpin(const size_t index);
+
+        // Start of the page
+        uint8_t* getPageData(const size_t index) const { return memory.get() + index * block_size; }
+
+        AsyncFileReader& reader;
+        CoroutineScheduler& scheduler;
+        uint64_t base_offset;
+        size_t block_size;
+        unsigned int readahead_blocks;
+
+        // Memory of all pages, aligned to the block size
+        std::unique_ptr<uint8_t, void (*)(void*)> memory;
+
+        // Pages, the page holding (or reading) each block, and the clock hand, guarded by `mutex`
+        std::vector<page> pages;
+        std::unordered_map<uint64_t, size_t> block_pages;
+        size_t clock_hand = 0;
+        // Coroutines waiting for a page to be unpinned (or for a block read ahead to be read)
+        std::vector<std::coroutine_handle<>> page_waiters;
+        // Number of blocks being read ahead, which the pool waits for before it is destroyed
+        size_t readahead_in_flight = 0;
+        std::condition_variable readahead_done;
+        // Counters of the statistics
+        buffer_pool_statistics statistics;
+        mutable std::mutex mutex;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Completes word prefixes to the terms of an index's dictionary, most frequent first, in time independent of the
+ * size of the dictionary (e.g. for suggestions on every keystroke).
+ *
+ * The dictionary of an InvertedIndex is sorted, so the terms starting with a prefix are a contiguous range of term ids,
+ * and a node of the trie only stores its range and label. A prefix shared by more than `max_completions` terms also
+ * has its children and its `max_completions` most frequent terms, precomputed. A prefix shared by fewer terms is a
+ * leaf, since ranking its few terms at lookup costs about as much as reading a precomputed list.
+ *
+ * Nodes are laid out breadth first, so the children of a node are contiguous and sorted by label, in the byte order
+ * of the dictionary (unsigned, so non-ASCII bytes sort after ASCII ones).
+ *
+ * The trie keeps no term text, only ranges into the index's dictionary, so it needs no compact dictionary (front coded
+ * or FST) of its own: compressing the terms would only pay off for the dictionary itself, which the index shares with
+ * every other lookup.
+*/
+class CompletionTrie {
+    public:
+        // Remove default constructor
+        CompletionTrie() = delete;
+
+        // Remove copy constructor and copy assignment
+        CompletionTrie(const CompletionTrie&) = delete;
+        CompletionTrie& operator= (const CompletionTrie&) = delete;
+
+        /**
+         * Initialize a CompletionTrie over the dictionary of an index
+         *
+         * @param index Index whose terms are completed (must outlive the trie)
+         * @param max_completions Number of completions precomputed per prefix, i.e. the most a lookup can return
+        */
+        CompletionTrie(const InvertedIndex& index, const unsigned int max_completions = 10);
+
+        /**
+         * Finds the most frequent terms starting with a prefix
+         *
+         * @param prefix Prefix to complete (normalized like terms are)
+         * @param n Number of completions wanted (at most `max_completions`)
+         * @param completions Set to the ids of the completions, by decreasing document frequency
+        */
+        void complete(std::string_view prefix, const unsigned int n, std::vector<term_id>& completions) const;
+
+        /**
+         * Finds the range of term ids starting with a prefix
+         *
+         * @param prefix Prefix to look up
+         * @return Range [begin, end) of term ids, empty if no term starts with the prefix
+        */
+        std::pair<term_id, term_id> getPrefixRange(std::string_view prefix) const;
+
+        // Number of completions precomputed per prefix
+        unsigned int getMaxCompletions() const { return max_completions; }
+
+        // Number of nodes in the trie
+        size_t getNumNodes() const { return nodes.size(); }
+
+    private:
+        // A prefix shared by at least one term
+        struct trie_node {
+            // Range of the terms starting with the prefix
+            term_id range_begin;
+            term_id range_end;
+            // Children of the node, contiguous in `nodes` (none for a prefix shared by few terms)
+            uint32_t first_child;
+            uint32_t num_children;
+            // Offset of the node's precomputed completions in `completions`
+            uint32_t first_completion;
+            // Last character of the prefix
+            char label;
+        };
+
+        // `true` if term `a` ranks before term `b` as a completion
+        bool isBetterCompletion(const term_id a, const term_id b) const;
+
+        const InvertedIndex& index;
+        const unsigned int max_completions;
+
+        // Nodes in breadth first order, starting with the root (the empty prefix)
+        std::vector<trie_node> nodes;
+        // Precomputed completions of every node with children, `max_completions` per node
+        std::vector<term_id> completions;
+};
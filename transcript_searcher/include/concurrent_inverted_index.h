@@ -0,0 +1,219 @@
+#pragma once
+
+#include "inverted_index.h"
+#include "epoch_manager.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+/**
+ * An in-memory inverted index which documents can be appended to while it is being searched.
+ *
+ * Readers never take a lock and never wait for writers. Every structure a writer changes is published
+ * through an atomic pointer or an atomically published length:
+ * - documents and term entries live in append-only chunked arrays whose chunks never move,
+ * - the term dictionary is a hash table which, when it grows, is rebuilt and swapped in as a whole,
+ * - each posting list grows in place below its capacity, and is copied into a larger version when full.
+ * Replaced dictionary tables and posting list versions are reclaimed by an EpochManager once no reader can see them.
+ *
+ * A Reader pins a snapshot of the first N documents: since documents are only published once all of their
+ * postings are in place, and posting lists are sorted by document id, every posting list (and so every
+ * document frequency) seen through a Reader is consistent with that snapshot.
+ *
+ * Writers are serialized by a mutex, which readers never touch.
+*/
+class ConcurrentInvertedIndex {
+    private:
+        // One version of a term's posting list; elements below `size` are immutable
+        struct posting_list_version {
+            size_t capacity;
+            std::atomic<size_t> size;
+            std::unique_ptr<posting[]> postings;
+        };
+
+        // A term and its current posting list version
+        struct term_entry {
+            std::string term;
+            std::atomic<posting_list_version*> postings;
+        };
+
+        // A document's statistics
+        struct document_entry {
+            std::string path;
+            uint32_t num_terms;
+        };
+
+        /**
+         * An array which only grows, built from fixed size chunks which never move, so that elements below
+         * a published length can be read while new elements are appended.
+        */
+        template <typename T>
+        class AppendOnlyArray {
+            public:
+                AppendOnlyArray() : chunks(new std::atomic<T*>[max_chunks]) {
+                    for (size_t c = 0; c < max_chunks; c++) {
+                        chunks[c].store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+
+                ~AppendOnlyArray() {
+                    for (size_t c = 0; c < max_chunks; c++) {
+                        delete[] chunks[c].load(std::memory_order_relaxed);
+                    }
+                }
+
+                // Element at an index which has been published to the reader
+                T& operator[](const size_t index) const {
+                    return chunks[index >> chunk_bits].load(std::memory_order_acquire)[index & (chunk_size - 1)];
+                }
+
+                // Make sure the chunk holding an index exists (writer side only)
+                void reserve(const size_t index) {
+                    size_t chunk = index >> chunk_bits;
+                    if (chunk >= max_chunks) {
+                        throw std::length_error("Error: concurrent index is full\n");
+                    }
+                    if (!chunks[chunk].load(std::memory_order_relaxed)) {
+                        chunks[chunk].store(new T[chunk_size], std::memory_order_release);
+                    }
+                }
+
+            private:
+                static constexpr size_t chunk_bits = 12;
+                static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+                static constexpr size_t max_chunks = size_t(1) << 16;
+
+                std::unique_ptr<std::atomic<T*>[]> chunks;
+        };
+
+        // Node of a dictionary hash chain; immutable once published
+        struct dictionary_node {
+            term_id term;
+            size_t hash;
+            dictionary_node* next;
+        };
+
+        // A version of the dictionary hash table, which owns its nodes
+        struct dictionary_table {
+            size_t mask;
+            size_t size;
+            std::unique_ptr<std::atomic<dictionary_node*>[]> buckets;
+        };
+
+    public:
+        /**
+         * A lock-free view of the first N documents of the index, as of its creation.
+         *
+         * Spans and references obtained from a Reader remain valid for the Reader's lifetime.
+         * Mirrors the read interface of InvertedIndex so the same scoring code can run on either.
+        */
+        class Reader {
+            public:
+                // Remove default constructor
+                Reader() = delete;
+
+                // Remove copy constructor and copy assignment
+                Reader(const Reader&) = delete;
+                Reader& operator= (const Reader&) = delete;
+
+                /**
+                 * Initialize a Reader, entering the index's epoch and pinning its current documents
+                 *
+                 * @param index Index to read
+                */
+                explicit Reader(const ConcurrentInvertedIndex& index);
+
+                // Number of documents in the snapshot
+                size_t getNumDocuments() const { return num_documents; }
+
+                // Path of the source file of a document
+                const std::string& getDocumentPath(const document_id document) const { return index.documents[document].path; }
+
+                // Number of unique terms in a document
+                uint32_t getDocumentNumTerms(const document_id document) const { return index.documents[document].num_terms; }
+
+                /**
+                 * Looks up the id of a term in the dictionary
+                 *
+                 * @param term Term to look up
+                 * @param id Set to the term's id if it is found
+                 * @return `true` if the term appears in the index, otherwise `false`
+                */
+                bool findTerm(const std::string& term, term_id& id) const;
+
+                // Posting list of a term within the snapshot, sorted by document id
+                std::span<const posting> getPostings(const term_id term) const;
+
+                // Number of documents in the snapshot a term appears in
+                uint32_t getDocumentFrequency(const term_id term) const { return static_cast<uint32_t>(getPostings(term).size()); }
+
+            private:
+                const ConcurrentInvertedIndex& index;
+                EpochManager::Guard guard;
+                size_t num_documents;
+        };
+
+        // Initialize an empty ConcurrentInvertedIndex
+        ConcurrentInvertedIndex();
+
+        // Remove copy constructor and copy assignment
+        ConcurrentInvertedIndex(const ConcurrentInvertedIndex&) = delete;
+        ConcurrentInvertedIndex& operator= (const ConcurrentInvertedIndex&) = delete;
+
+        /**
+         * Appends a document, making it visible to Readers created after this returns
+         *
+         * @param document Document and its term statistics
+         * @return Id assigned to the document
+        */
+        document_id addDocument(const indexed_document& document);
+
+        // Number of documents published so far
+        size_t getNumDocuments() const { return num_documents.load(std::memory_order_acquire); }
+
+        // Free every posting list version and dictionary table
+        ~ConcurrentInvertedIndex();
+
+    private:
+        /**
+         * Finds a term's entry, creating it if needed (writer side only)
+         *
+         * @param term Term to find
+         * @return Id of the term's entry
+        */
+        term_id findOrAddTerm(const std::string& term);
+
+        /**
+         * Appends a posting to a term's list, moving it to a larger version if full (writer side only)
+         *
+         * @param term Term id
+         * @param entry Posting to append
+        */
+        void appendPosting(const term_id term, const posting& entry);
+
+        /**
+         * Rebuilds the dictionary with twice as many buckets and publishes it (writer side only)
+        */
+        void growDictionary();
+
+        // Frees a dictionary table and all of its nodes
+        static void deleteDictionaryTable(dictionary_table* table);
+
+        // Documents and terms, below `num_documents` / `num_terms`
+        AppendOnlyArray<document_entry> documents;
+        AppendOnlyArray<term_entry> terms;
+        std::atomic<size_t> num_documents = 0;
+        size_t num_terms = 0;
+
+        // Current dictionary table
+        std::atomic<dictionary_table*> dictionary;
+
+        // Reclaims replaced versions once readers are done with them
+        mutable EpochManager epochs;
+
+        // Serializes writers
+        std::mutex writer_mutex;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "async_task.h"
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads resuming coroutines as they become ready to run.
+ *
+ * A coroutine waiting on I/O (see AsyncFileReader) is suspended rather than blocking its worker, which meanwhile
+ * resumes whichever other coroutine is ready, so that many more searches than threads can be in progress at once.
+ * Coroutines are resumed in the order they became ready.
+*/
+class CoroutineScheduler {
+    public:
+        // Remove default constructor
+        CoroutineScheduler() = delete;
+
+        // Remove copy constructor and copy assignment
+        CoroutineScheduler(const CoroutineScheduler&) = delete;
+        CoroutineScheduler& operator= (const CoroutineScheduler&) = delete;
+
+        /**
+         * Starts the worker threads
+         *
+         * @param num_threads Number of worker threads (0 for one per hardware thread)
+        */
+        explicit CoroutineScheduler(const unsigned int num_threads);
+
+        /**
+         * Queues a suspended coroutine to be resumed on a worker thread
+         *
+         * @param handle Coroutine to resume
+        */
+        void resume(std::coroutine_handle<> handle);
+
+        // Awaiting the result moves the awaiting coroutine onto a worker thread
+        struct schedule_awaiter {
+            CoroutineScheduler& scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler.resume(handle); }
+            void await_resume() const noexcept {}
+        };
+        schedule_awaiter schedule() { return {*this}; }
+
+        /**
+         * Starts a task on the worker threads
+         *
+         * @param task Task to run
+         * @return Future of the task's result
+        */
+        template <typename T>
+        std::future<T> spawn(AsyncTask<T> task) {
+            std::promise<T> result;
+            std::future<T> future = result.get_future();
+            runDetached(*this, std::move(task), std::move(result));
+            return future;
+        }
+
+        // Number of worker threads
+        size_t getNumThreads() const { return threads.size(); }
+
+        // Resume the coroutines already queued and join the worker threads
+        ~CoroutineScheduler();
+
+    private:
+        // Coroutine which runs to completion on its own, destroying its frame at the end
+        struct detached_task {
+            struct promise_type {
+                detached_task get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        // Awaits a task on a worker thread, and fulfils `result` with its outcome
+        template <typename T>
+        static detached_task runDetached(CoroutineScheduler& scheduler, AsyncTask<T> task, std::promise<T> result) {
+            co_await scheduler.schedule();
+            try {
+                result.set_value(co_await task);
+            } catch (...) {
+                result.set_exception(std::current_exception());
+            }
+        }
+
+        // Main loop of each worker thread
+        void run();
+
+        // Coroutines ready to be resumed, guarded by `mutex`
+        std::deque<std::coroutine_handle<>> ready;
+        std::mutex mutex;
+        std::condition_variable ready_available;
+        bool stopping = false;
+
+        std::vector<std::thread> threads;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "async_file_reader.h"
+#include "async_task.h"
+#include "buffer_pool.h"
+#include "coroutine_scheduler.h"
+#include "forward_index.h"
+#include "posting_file.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over posting lists
+ * kept on disk, for indexes bigger than memory.
+ *
+ * Only the forward index (`<database_path>.forward`, as with InMemoryTfIdfSearch), whose vocabulary serves as the
+ * dictionary, and the posting file (`<database_path>.postings`, see PostingFile) are opened, both built on first use
+ * and rebuilt whenever they no longer match each other. Posting lists are read block by block as queries need them.
+ *
+ * Searches are coroutines (see searchAsync), scored term at a time, which suspend while each posting block is read
+ * asynchronously (see AsyncFileReader). Their worker threads meanwhile resume whichever other search has its block,
+ * so hundreds of disk-bound searches can be in progress on a handful of threads, e.g. a batch of queries (see
+ * getBatchTranscriptMatches), of which up to 256 run at once. Each search only keeps accumulators for the
+ * documents its terms appear in, so its memory follows the postings it reads rather than the size of the corpus.
+ *
+ * Posting blocks are kept in a BufferPool of a fixed number of pages, which also reads ahead the next blocks of a
+ * posting list, and may read with O_DIRECT so that the index takes no more memory than the pool whatever else runs
+ * on the machine. Without a pool, every block is read again each time a search needs it (from the page cache, if the
+ * operating system kept it there).
+ *
+ * Search terms are normalized like transcripts are, and a search term made of several words is searched as its
+ * separate words. Boolean queries are searched by the terms they do not exclude. A search stops between blocks once
+ * it is cancelled or past its deadline, returning the documents scored so far.
+*/
+class DiskTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        DiskTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        DiskTfIdfSearch(const DiskTfIdfSearch&) = delete;
+        DiskTfIdfSearch& operator= (const DiskTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a DiskTfIdfSearch, building its forward index and posting file if needed
+         *
+         * @param database_path Path to database which stores corpus state
+         * @param num_threads Number of worker threads searches run on (0 for one per hardware thread)
+         * @param pool_options Size and read ahead of the buffer pool of posting blocks (no pool if it has no pages)
+         * @param warmup_options Warm-up of the forward index and posting files
+        */
+        DiskTfIdfSearch(
+            const std::string database_path,
+            const unsigned int num_threads,
+            const buffer_pool_options& pool_options,
+            const index_warmup_options& warmup_options = index_warmup_options()
+        );
+
+        /**
+         * Searches the k-best matching transcripts, suspending while posting blocks are read.
+         *
+         * The search only starts once the task is awaited, or spawned on `getScheduler()`, and may be resumed on any
+         * of its worker threads.
+         *
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @return Task of the transcript-score pairs, best first
+        */
+        AsyncTask<std::vector<scored_transcript>> searchAsync(
+            const std::vector<std::string> search_terms,
+            const unsigned int k,
+            const search_options options
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the
+         * transcripts and their scores in a Vector.
+         *
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        ) override;
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options, waiting for the
+         * search to run on the worker threads.
+         *
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        ) override;
+
+        /**
+         * Determines the k-best matching transcripts of each of many queries, searched up to 256 at once on the worker
+         * threads, each starting as an earlier one finishes (`num_threads` is ignored).
+         *
+         * @param queries Search terms (or a boolean query) of each query
+         * @param k Number of best matches to return per query
+         * @param options Options of every search
+         * @param num_threads Ignored, the worker threads being set when the algorithm is created
+         * @param best_matches Set to the transcript-score pairs of each query, in the order of `queries`
+        */
+        void getBatchTranscriptMatches(
+            const std::vector<std::vector<std::string>>& queries,
+            const unsigned int k,
+            const search_options& options,
+            const unsigned int num_threads,
+            std::vector<std::vector<scored_transcript>>& best_matches
+        ) override;
+
+        /**
+         * Retrieves the statistics of the buffer pool of posting blocks
+         *
+         * @param statistics Set to the statistics of the buffer pool
+         * @return `true` if the algorithm has a buffer pool, otherwise `false`
+        */
+        bool getBufferPoolStatistics(buffer_pool_statistics& statistics) override;
+
+        // Scheduler on whose worker threads searches run
+        CoroutineScheduler& getScheduler() { return *scheduler; }
+
+    private:
+        /**
+         * Opens the forward index and posting file
+         *
+         * @param forward_index_path Path of the forward index file
+         * @param posting_file_path Path of the posting file
+         * @param warmup_options Warm-up of both files
+         * @return `false` if either file is missing, invalid, or does not match the other
+        */
+        bool loadIndexes(const std::string& forward_index_path, const std::string& posting_file_path, const index_warmup_options& warmup_options);
+
+        // Forward index (whose vocabulary is the dictionary) and on-disk posting lists
+        std::unique_ptr<ForwardIndex> forward_index;
+        std::unique_ptr<PostingFile> posting_file;
+
+        // Worker threads running searches, the reader of posting blocks resuming them, and the pool the blocks are
+        // read into, if any (each destroyed before the ones it uses)
+        std::unique_ptr<CoroutineScheduler> scheduler;
+        std::unique_ptr<AsyncFileReader> posting_reader;
+        std::unique_ptr<BufferPool> buffer_pool;
+};
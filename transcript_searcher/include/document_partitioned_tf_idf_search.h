@@ -0,0 +1,92 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include "worker_thread.h"
+#include <memory>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over an
+ * in-memory index sharded by document.
+ *
+ * Each shard indexes a disjoint subset of the documents and is owned by its own worker thread. A query is
+ * broadcast to every shard, each shard scores its own documents (using corpus wide IDFs, so scores match
+ * the unsharded algorithm) and returns its local K-best, and the local results are merged into the global K-best.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops scoring on every shard and ranks the
+ * documents scored so far.
+*/
+class DocumentPartitionedTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        DocumentPartitionedTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        DocumentPartitionedTfIdfSearch(const DocumentPartitionedTfIdfSearch&) = delete;
+        DocumentPartitionedTfIdfSearch& operator= (const DocumentPartitionedTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a DocumentPartitionedTfIdfSearch instance, loading the corpus from the database
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param num_partitions Number of document shards (and worker threads)
+        */
+        DocumentPartitionedTfIdfSearch(const std::string database_path, const unsigned int num_partitions);
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the 
+         * transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options (only the deadline,
+         * latency budget and cancellation token of which are supported, the operators of a boolean query being ignored
+         * and its excluded terms dropped).
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        // Default destructor
+        ~DocumentPartitionedTfIdfSearch() = default;
+
+    private:
+        /**
+         * Searches terms, stopping early if the search is interrupted
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search, whose statistics are recorded
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void searchTerms(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        // Total number of documents over all shards
+        size_t num_documents_total = 0;
+
+        // Index of each shard, and the worker thread which owns it
+        std::vector<std::unique_ptr<InvertedIndex>> shards;
+        std::vector<std::unique_ptr<WorkerThread>> workers;
+};
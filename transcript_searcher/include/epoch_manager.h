@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Epoch-based memory reclamation for data structures which are read without locks.
+ *
+ * Readers announce the epoch they entered in before loading any shared pointer, and leave when done.
+ * Writers which unlink an old version of some data retire it instead of freeing it; a retired object is
+ * only freed once every reader active at the time it was retired has left, so a reader can never touch
+ * freed memory and never waits on a writer.
+*/
+class EpochManager {
+    public:
+        /**
+         * A reader's presence in the current epoch. Pointers loaded from a shared structure while a Guard
+         * is held remain valid until the Guard is destroyed.
+        */
+        class Guard {
+            public:
+                // Remove copy constructor and copy assignment
+                Guard(const Guard&) = delete;
+                Guard& operator= (const Guard&) = delete;
+
+                // Allow moving the reader's presence
+                Guard(Guard&& other) noexcept;
+
+                // Leave the epoch
+                ~Guard();
+
+            private:
+                friend class EpochManager;
+
+                Guard(EpochManager* manager, size_t slot);
+
+                EpochManager* manager;
+                size_t slot;
+        };
+
+        // Default constructor
+        EpochManager() = default;
+
+        // Remove copy constructor and copy assignment
+        EpochManager(const EpochManager&) = delete;
+        EpochManager& operator= (const EpochManager&) = delete;
+
+        /**
+         * Enters the current epoch as a reader (lock-free)
+         *
+         * @return Guard which leaves the epoch when destroyed
+        */
+        Guard enter();
+
+        /**
+         * Hands over an object which has been unlinked from a shared structure, to be freed once no reader can see it.
+         *
+         * Writers must serialize their calls to `retire` and `reclaim`.
+         *
+         * @param deleter Frees the object
+        */
+        void retire(std::function<void()> deleter);
+
+        /**
+         * Frees every retired object which no active reader can still see
+         *
+         * @return Number of objects freed
+        */
+        size_t reclaim();
+
+        // Number of retired objects waiting to be freed
+        size_t getNumRetired() const { return retired.size(); }
+
+        // Free everything still retired (no reader may be active)
+        ~EpochManager();
+
+    private:
+        // Maximum number of readers which can be active at once
+        static constexpr size_t max_readers = 256;
+
+        // Epoch value of a slot with no active reader
+        static constexpr uint64_t idle_epoch = UINT64_MAX;
+
+        // Announcement of one active reader, on its own cache line
+        struct alignas(64) reader_slot {
+            std::atomic<bool> claimed = false;
+            std::atomic<uint64_t> epoch = idle_epoch;
+        };
+
+        // Release a reader slot
+        void leave(const size_t slot);
+
+        // Current epoch, advanced on every retirement
+        std::atomic<uint64_t> global_epoch = 1;
+
+        // Reader announcements
+        reader_slot slots[max_readers];
+
+        // Retired objects and the epoch they were retired in (writer side only)
+        std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+};
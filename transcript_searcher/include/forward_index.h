@@ -0,0 +1,147 @@
+#pragma once
+
+#include "index_file.h"
+#include "index_warmup.h"
+#include "inverted_index.h"
+#include "minimal_perfect_hash.h"
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Identifier of a token (any word, stop words included) in the vocabulary of a ForwardIndex
+typedef uint32_t token_id;
+
+// Sections of a forward index file
+enum forward_index_section : uint32_t {
+    FORWARD_VOCABULARY_OFFSETS = 1,
+    FORWARD_VOCABULARY = 2,
+    FORWARD_PATH_OFFSETS = 3,
+    FORWARD_PATHS = 4,
+    FORWARD_TOKEN_OFFSETS = 5,
+    FORWARD_TOKENS = 6,
+    FORWARD_TOKEN_TEXT_OFFSETS = 7,
+    FORWARD_TEXT_OFFSETS = 8,
+    FORWARD_TEXT = 9,
+    FORWARD_TOKEN_HASH_SEED = 10,
+    FORWARD_TOKEN_HASH_PILOTS = 11,
+    FORWARD_TOKEN_SLOTS = 12
+};
+
+// A slot of the token hash table: the token hashed there, and a fingerprint of its hash to reject other words
+struct token_slot {
+    token_id token;
+    uint32_t fingerprint;
+};
+
+/**
+ * A memory mapped forward index: each transcript as the sequence of its token ids, with the byte offset of
+ * every token in the stored transcription, and the transcription itself.
+ *
+ * Position-aware features (proximity scoring, snippets) scan a few kilobytes of integers per transcript
+ * instead of tokenizing text at query time. The vocabulary holds every token, stop words included, in
+ * sorted order so that it can be searched in place.
+ *
+ * Tokens are looked up through a minimal perfect hash function over the vocabulary, built with the file: a word
+ * hashes to a single slot holding a token id and a fingerprint, which rejects almost every word outside the
+ * vocabulary without reading any of it. Files without the hash sections are searched by binary search instead.
+ *
+ * The file is built from the database by `build()`, and documents keep the order of the database's
+ * documents table, so document ids agree with indexes built by InvertedIndexBuilder::readDatabaseDocuments.
+ *
+ * The vocabulary, its hash and the per-document offsets are hot, being read by every search, while the tokens are
+ * scanned one document after another (see IndexWarmup).
+*/
+class ForwardIndex {
+    public:
+        // Remove default constructor
+        ForwardIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        ForwardIndex(const ForwardIndex&) = delete;
+        ForwardIndex& operator= (const ForwardIndex&) = delete;
+
+        /**
+         * Maps a forward index file
+         *
+         * @param path Path of the forward index file
+         * @param warmup_options Warm-up of the file's hot sections
+        */
+        explicit ForwardIndex(const std::string& path, const index_warmup_options& warmup_options = index_warmup_options());
+
+        /**
+         * Builds a forward index file from the transcriptions stored in the database
+         *
+         * @param database_path Path to database which stores corpus state
+         * @param path Path of the forward index file to write
+        */
+        static void build(const std::string& database_path, const std::string& path);
+
+        // Number of documents in the index
+        size_t getNumDocuments() const { return path_offsets.size() - 1; }
+
+        // Path of the source file of a document
+        std::string_view getDocumentPath(const document_id document) const {
+            return std::string_view(paths.data() + path_offsets[document], path_offsets[document + 1] - path_offsets[document]);
+        }
+
+        // Token ids of a document, in order of appearance
+        std::span<const token_id> getTokens(const document_id document) const {
+            return tokens.subspan(token_offsets[document], token_offsets[document + 1] - token_offsets[document]);
+        }
+
+        // Byte offset of each of a document's tokens in its transcription
+        std::span<const uint32_t> getTokenTextOffsets(const document_id document) const {
+            return token_text_offsets.subspan(token_offsets[document], token_offsets[document + 1] - token_offsets[document]);
+        }
+
+        // Stored (normalized) transcription of a document
+        std::string_view getText(const document_id document) const {
+            return std::string_view(text.data() + text_offsets[document], text_offsets[document + 1] - text_offsets[document]);
+        }
+
+        // Number of tokens of all documents
+        size_t getNumTokens() const { return tokens.size(); }
+
+        // Number of distinct tokens in the index
+        size_t getVocabularySize() const { return vocabulary_offsets.size() - 1; }
+
+        // Vocabulary entry of a token id
+        std::string_view getToken(const token_id token) const {
+            return std::string_view(vocabulary.data() + vocabulary_offsets[token], vocabulary_offsets[token + 1] - vocabulary_offsets[token]);
+        }
+
+        /**
+         * Looks up the id of a token in the vocabulary
+         *
+         * @param token Token to look up
+         * @param id Set to the token's id if it is found
+         * @return `true` if the token appears in the index, otherwise `false`
+        */
+        bool findToken(const std::string_view token, token_id& id) const;
+
+    private:
+        // Mapped file
+        std::unique_ptr<IndexFile> file;
+        // Warm-up of the mapped file, stopped before the file is unmapped
+        std::unique_ptr<IndexWarmup> warmup;
+
+        // Sorted vocabulary, as offsets into the concatenated tokens
+        std::span<const uint64_t> vocabulary_offsets;
+        std::span<const char> vocabulary;
+        // Document paths, as offsets into the concatenated paths
+        std::span<const uint64_t> path_offsets;
+        std::span<const char> paths;
+        // Offset of each document's tokens in `tokens`, plus a trailing end offset
+        std::span<const uint64_t> token_offsets;
+        // Token ids of all documents, back to back
+        std::span<const token_id> tokens;
+        // Byte offset of each token within its document's transcription
+        std::span<const uint32_t> token_text_offsets;
+        // Transcriptions, as offsets into the concatenated transcriptions
+        std::span<const uint64_t> text_offsets;
+        std::span<const char> text;
+        // Perfect hash of the vocabulary, and the token and fingerprint in each of its slots (absent in older files)
+        std::unique_ptr<MinimalPerfectHash> token_hash;
+        std::span<const token_slot> token_slots;
+};
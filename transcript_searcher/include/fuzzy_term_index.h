@@ -0,0 +1,79 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A dictionary term within a small edit distance of a search term.
+*/
+struct fuzzy_match {
+    term_id term;
+    unsigned int distance;
+};
+
+/**
+ * Finds the terms of an index's dictionary within a small edit distance of a (possibly mis-spelled) word, without
+ * scanning the dictionary, using a SymSpell style deletion index.
+ *
+ * Two words within edit distance d share a string obtained by deleting at most d characters from each, so every
+ * term is indexed under all of its deletions, and a lookup only has to generate the deletions of the word and
+ * verify the terms found under them. Only the first `prefix_length` characters of words are used for deletions,
+ * which keeps their number (and the size of the index) bounded for long words.
+ *
+ * Deletions are stored as 32-bit hashes in a single sorted array, so a collision only costs one more verification.
+*/
+class FuzzyTermIndex {
+    public:
+        // Remove default constructor
+        FuzzyTermIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        FuzzyTermIndex(const FuzzyTermIndex&) = delete;
+        FuzzyTermIndex& operator= (const FuzzyTermIndex&) = delete;
+
+        /**
+         * Initialize a FuzzyTermIndex over the dictionary of an index
+         *
+         * @param index Index whose terms are looked up
+         * @param max_distance Largest edit distance lookups may ask for
+        */
+        FuzzyTermIndex(const InvertedIndex& index, const unsigned int max_distance = 2);
+
+        /**
+         * Finds the terms within an edit distance of a word (the word itself included, if it is a term)
+         *
+         * @param word Word to look up
+         * @param max_distance Largest edit distance to match, at most the one the index was built for
+         * @param matches Set to the matching terms and their distances, closest first
+        */
+        void findTerms(const std::string& word, const unsigned int max_distance, std::vector<fuzzy_match>& matches) const;
+
+        // Largest edit distance lookups may ask for
+        unsigned int getMaxDistance() const { return max_distance; }
+
+        /**
+         * Computes the optimal string alignment distance of two words (insertions, deletions, substitutions and
+         * transpositions of adjacent characters), giving up once it exceeds a bound
+         *
+         * @param a First word
+         * @param b Second word
+         * @param max_distance Bound of the distance
+         * @return The distance, or `max_distance + 1` if it is larger than `max_distance`
+        */
+        static unsigned int editDistance(std::string_view a, std::string_view b, const unsigned int max_distance);
+
+    private:
+        // Calls `on_deletion` with every string obtained by deleting at most `max_deletions` characters of `word`'s prefix
+        template <typename Callback>
+        static void forEachDeletion(std::string_view word, const unsigned int max_deletions, Callback on_deletion);
+
+        const InvertedIndex& index;
+        const unsigned int max_distance;
+
+        // Hash of every deletion of every term, sorted, with the id of the term it was made from at the same index
+        std::vector<uint32_t> deletion_hashes;
+        std::vector<term_id> deletion_terms;
+};
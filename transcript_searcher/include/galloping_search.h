@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * Finds the first element not less than a key in a sorted range, by galloping (exponential search) from
+ * the front of the range followed by a binary search over the last gap.
+ *
+ * Costs O(log d) where d is the distance to the result, so repeatedly galloping forward through a long
+ * list to the elements of a much shorter one (intersection) is far cheaper than a linear merge.
+ *
+ * @param begin Start of the sorted range
+ * @param end End of the sorted range
+ * @param key Key to search for
+ * @param less Comparison of an element against the key
+ * @return Iterator to the first element not less than the key, or `end`
+*/
+template <typename Iterator, typename Key, typename Less>
+Iterator gallopLowerBound(Iterator begin, Iterator end, const Key& key, Less less) {
+    size_t step = 1;
+    Iterator low = begin;
+    Iterator high = begin;
+    while (high != end && less(*high, key)) {
+        low = high;
+        high = (static_cast<size_t>(end - high) > step) ? high + step : end;
+        step <<= 1;
+    }
+    return std::lower_bound(low, high, key, less);
+}
+
+// gallopLowerBound over plain sorted integers
+template <typename Iterator, typename Key>
+Iterator gallopLowerBound(Iterator begin, Iterator end, const Key& key) {
+    return gallopLowerBound(begin, end, key, [](const auto& element, const Key& value) { return element < value; });
+}
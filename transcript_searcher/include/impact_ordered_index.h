@@ -0,0 +1,53 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <span>
+#include <vector>
+
+/**
+ * The posting lists of an index in impact order: each term's postings sorted by decreasing contribution to a
+ * document's TF-IDF score, so that a query can go through the postings which matter most first, and stop once the
+ * rest can no longer change its results (see InMemoryTfIdfSearch, score at a time).
+ *
+ * A term's contribution is its normalized frequency (frequency / number of terms in the document) times its IDF,
+ * which is the same for all of its postings, so lists are ordered by normalized frequency alone (ties by document).
+ * The first postings of a list are then the term's champion list, the documents it weighs the most in.
+ *
+ * Lists are laid out like the index's: back to back in a single array, at the same offsets.
+*/
+class ImpactOrderedIndex {
+    public:
+        // Remove default constructor
+        ImpactOrderedIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        ImpactOrderedIndex(const ImpactOrderedIndex&) = delete;
+        ImpactOrderedIndex& operator= (const ImpactOrderedIndex&) = delete;
+
+        /**
+         * Initialize an ImpactOrderedIndex from the posting lists of an index
+         *
+         * @param index Index whose posting lists are reordered (must outlive the ImpactOrderedIndex)
+        */
+        explicit ImpactOrderedIndex(const InvertedIndex& index);
+
+        // Posting list of a term, sorted by decreasing normalized frequency
+        std::span<const posting> getPostings(const term_id term) const {
+            return std::span<const posting>(postings.data() + posting_offsets[term], postings.data() + posting_offsets[term + 1]);
+        }
+
+        /**
+         * Sorts postings by decreasing normalized frequency, as the lists of an ImpactOrderedIndex are (e.g. to order
+         * the postings of a phrase, which are computed per query)
+         *
+         * @param index Index the postings' documents belong to
+         * @param postings Postings to sort in place
+        */
+        static void sortByImpact(const InvertedIndex& index, std::span<posting> postings);
+
+    private:
+        // Offset of each term's posting list in `postings`, plus a trailing end offset
+        std::vector<uint64_t> posting_offsets;
+        // All posting lists, back to back
+        std::vector<posting> postings;
+};
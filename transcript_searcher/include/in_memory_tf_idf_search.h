@@ -0,0 +1,451 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include "phrase_matching.h"
+#include "forward_index.h"
+#include "fuzzy_term_index.h"
+#include "phonetic_index.h"
+#include "completion_trie.h"
+#include "trigram_index.h"
+#include "impact_ordered_index.h"
+#include "quantized_impact_index.h"
+#include "search_interruption.h"
+#include "tf_idf_scoring.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over a single
+ * in-memory positional index.
+ *
+ * Search terms are normalized like transcripts are. A search term made of several words (e.g. a quoted
+ * "ice hockey") is a phrase: it only matches where its words appear consecutively, and it is scored like a
+ * single term whose frequency is the number of occurrences of the phrase.
+ *
+ * A forward index of the transcripts is memory mapped alongside the inverted index, from `<database_path>.forward`
+ * (built on first use, and rebuilt whenever it no longer matches the database). The inverted index takes its
+ * positions from it, and proximity scoring scans it rather than decoding position lists.
+ *
+ * Search terms may also form a boolean query (see boolean_query), e.g. `ice AND (hockey OR "field hockey") -fight`.
+ * The matching documents are found first, by intersecting and subtracting posting lists, and only those are scored
+ * (by the terms which are not excluded), rather than every document containing any of the terms.
+ *
+ * With fuzzy matching, a single word search term also matches the dictionary terms within a small edit distance
+ * (1 for words of 3 to 5 letters, 2 for longer ones), found through a FuzzyTermIndex built on first use. Each match
+ * is scored like a term of its own, divided by one plus its distance.
+ *
+ * With phonetic matching, a single word search term stands for every term with the same phonetic key (see
+ * PhoneticIndex, built with the index), e.g. "puck" also matches transcripts where speech-to-text wrote "puk". Their
+ * posting lists are merged into one, scored as a single term, so this costs about as much as looking up one term.
+ * Phonetic matching takes precedence over fuzzy matching for words which have sound-alikes.
+ *
+ * A single word search term ending with `*` (e.g. `hock*`) matches every term starting with the word, again as one
+ * merged posting list.
+ *
+ * A single word search term starting with `~` (e.g. `~ockey`) matches every term containing the rest of the word, and
+ * every transcript whose path contains it (e.g. `~2019`), again as one merged posting list where a matching path
+ * counts as one more occurrence. Both are found through TrigramIndexes of the dictionary and of the paths, built on
+ * the first such search, rather than by scanning either. The substring needs at least 3 characters.
+ *
+ * Snippets of the results are cut from the forward index, finding all of the query's terms and phrases with
+ * one Aho-Corasick automaton per query (see extractSnippets), spread over several threads for long result lists.
+ *
+ * Plain searches are evaluated with whichever strategy a cost model expects to be cheapest (see planQuery): term at
+ * a time into a dense accumulator, which suits rare terms; WAND, which suits a mix of rare and common terms since it
+ * skips the documents only common terms could score; or a scan of the forward index, which suits a small corpus.
+ *
+ * Score at a time, the postings of all units are gone through by decreasing contribution to the score (each term's
+ * kept in that order by an ImpactOrderedIndex), and the search stops as soon as the contributions left could not
+ * change which documents are the K-best. It is the strategy chosen for a search with a latency budget or a deadline,
+ * since the documents it has scored when time runs out are the best candidates so far, rather than arbitrary ones.
+ *
+ * The scoring loops of every strategy poll a SearchInterruption between blocks of postings (or of documents), so that a
+ * cancelled search, or one past its deadline, returns early with the documents scored so far, flagged as approximate
+ * if it ran out of time.
+ *
+ * With quantized impacts, term at a time adds up small integers instead (see QuantizedImpactIndex, built for each
+ * width on the first search which uses it) into a dense accumulator whose blocks are scanned with vectorized loops for
+ * the K-best. Only those are then scored exactly, so the ranking is approximate but the reported scores are not.
+ *
+ * A batch of queries (see getBatchTranscriptMatches) is scored like a sparse product of the queries' term weights and
+ * the index's postings: documents are gone through in blocks, each posting list once per block, adding its
+ * contributions into an accumulator per query and document of the block, small enough to stay in cache.
+ *
+ * With a proximity boost, a transcript's score is multiplied by `1 + boost * min(1, m / span)`, where `span` is the
+ * length of the shortest window holding all `m` of the query's terms and phrases the transcript contains
+ * (when m is at least 2). Only transcripts whose boosted score could still reach the K-best are boosted.
+*/
+class InMemoryTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        InMemoryTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        InMemoryTfIdfSearch(const InMemoryTfIdfSearch&) = delete;
+        InMemoryTfIdfSearch& operator= (const InMemoryTfIdfSearch&) = delete;
+
+        /**
+         * Initialize an InMemoryTfIdfSearch instance, loading the corpus from the database and its forward index
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param warmup_options Warm-up of the forward index file
+        */
+        InMemoryTfIdfSearch(const std::string database_path, const index_warmup_options& warmup_options = index_warmup_options());
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the 
+         * transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms (or phrases) to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options.
+         * 
+         * @param search_terms Vector of terms (or phrases) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Determines the k-best matching transcripts of each of many queries, the plain ones scored together term at
+         * a time (see scoreBatchRange) over ranges of documents searched on several threads.
+         *
+         * Boolean queries, and every query when the options call for another strategy (a proximity boost, quantized
+         * impacts, a latency budget or a deadline), are searched one by one, spread over the same threads.
+         *
+         * @param queries Search terms (or a boolean query) of each query
+         * @param k Number of best matches to return per query
+         * @param options Options of every search
+         * @param num_threads Number of threads to search on (0 to use one per hardware thread)
+         * @param best_matches Set to the transcript-score pairs of each query, in the order of `queries`
+        */
+        void getBatchTranscriptMatches(
+            const std::vector<std::vector<std::string>>& queries,
+            const unsigned int k,
+            const search_options& options,
+            const unsigned int num_threads,
+            std::vector<std::vector<scored_transcript>>& best_matches
+        );
+
+        /**
+         * Extracts, for each of a query's results, the windows of its transcript which best match the query,
+         * with the matching terms highlighted.
+         * 
+         * @param search_terms Vector of terms (or phrases) used in the search
+         * @param best_matches Results of the search
+         * @param options Options of the search
+         * @param snippets Set to the snippets of each result, best first
+        */
+        void getTranscriptSnippets(
+            const std::vector<std::string>& search_terms,
+            const std::vector<scored_transcript>& best_matches,
+            const search_options& options,
+            std::vector<std::vector<transcript_snippet>>& snippets
+        );
+
+        /**
+         * Completes the last word of a partially typed search to the most frequent terms starting with it, in time
+         * independent of the size of the dictionary (see CompletionTrie).
+         * 
+         * @param prefix Text typed so far
+         * @param n Number of completions wanted (at most 10)
+         * @param completions Set to the completions, most frequent first
+        */
+        void getCompletions(const std::string& prefix, const unsigned int n, std::vector<term_completion>& completions);
+
+        // Default destructor
+        ~InMemoryTfIdfSearch() = default;
+
+    private:
+        /**
+         * Loads the inverted index, taking positions from the forward index
+         *
+         * @param database_path Path to database which stores corpus state
+         * @param forward_index_path Path of the forward index file
+         * @param warmup_options Warm-up of the forward index file
+         * @return `false` if the forward index is missing or does not match the database
+        */
+        bool loadIndexes(const std::string& database_path, const std::string& forward_index_path, const index_warmup_options& warmup_options);
+
+        // A term or phrase of a query, resolved against the index
+        struct query_unit {
+            // Non stop word words of the term or phrase
+            std::vector<std::string> words;
+            // Terms of the phrase (a single term has one, at offset zero)
+            std::vector<phrase_term> phrase;
+            // The same phrase as forward index token ids
+            std::vector<phrase_term> forward_phrase;
+            // Matching documents, with the number of occurrences of the term or phrase
+            std::span<const posting> postings;
+            // Storage of the matches of a phrase, which are computed per query
+            std::vector<posting> phrase_postings;
+            // Corpus IDF of the term or phrase
+            double idf = 0.0;
+            // Weight of the unit's score, lower for fuzzy matches the further they are from the search term
+            double weight = 1.0;
+            // `false` for merged terms, whose occurrences cannot be counted from `forward_phrase` alone
+            bool countable = true;
+            // Upper bound of the unit's contribution to any document's score (set by planQuery)
+            double max_score = 0.0;
+        };
+
+        // A unit of a query scored in a batch
+        struct batch_unit {
+            // Position of the query in the batch
+            uint32_t query;
+            double idf;
+            double weight;
+        };
+
+        // A posting list of a batch, with every unit (of any query) it is the postings of
+        struct batch_list {
+            std::span<const posting> postings;
+            std::vector<batch_unit> units;
+        };
+
+        /**
+         * Looks up the words of a unit (whose `words` are set) and finds the documents containing them
+         *
+         * @param unit Term or phrase to resolve
+         * @param offsets Offset of each word within the phrase
+         * @return `false` if the term or phrase matches nothing
+        */
+        bool resolvePhrase(query_unit& unit, const std::vector<uint32_t>& offsets) const;
+
+        /**
+         * Lists the terms a wildcard (a prefix followed by `*`) expands to, the most frequent ones if there are too many
+         *
+         * @param prefix Normalized prefix of the wildcard
+         * @param terms Set to the ids of the terms starting with the prefix
+        */
+        void findWildcardTerms(const std::string& prefix, std::vector<term_id>& terms) const;
+
+        /**
+         * Lists the terms containing a substring, the most frequent ones if there are too many
+         *
+         * @param substring Normalized substring
+         * @param terms Set to the ids of the terms containing the substring
+        */
+        void findSubstringTerms(const std::string& substring, std::vector<term_id>& terms) const;
+
+        /**
+         * Resolves a substring to the terms and the paths containing it, merging their posting lists
+         *
+         * @param substring Substring, as typed
+         * @param unit Unit to resolve (whose `words` are set)
+         * @return `false` if no term or path contains the substring
+        */
+        bool resolveSubstring(const std::string& substring, query_unit& unit) const;
+
+        /**
+         * Resolves a single word unit (whose `words` are set) to the terms which sound like it, merging their posting lists
+         *
+         * @param unit Word to resolve
+         * @return `false` if no term sounds like the word
+        */
+        bool resolveSoundAlikes(query_unit& unit) const;
+
+        /**
+         * Resolves a single search term into query units: the term or phrase itself, or for a single word, the merged
+         * terms which sound like it (with phonetic matching) or each term within the edit distance (with fuzzy matching),
+         * or the merged terms and paths matching its wildcard or substring
+         *
+         * @param search_term Term (or phrase)
+         * @param options Options of the search, which may ask for sound-alike or fuzzy matches
+         * @param units Appended with the units which match any document
+        */
+        void resolveTerm(const std::string& search_term, const search_options& options, std::vector<query_unit>& units) const;
+
+        /**
+         * Resolves search terms into query units, dropping duplicates and those which match nothing
+         *
+         * @param search_terms Vector of terms (or phrases)
+         * @param options Options of the search, which may ask for sound-alike or fuzzy matches
+         * @return Resolved query units
+        */
+        std::vector<query_unit> resolveQuery(const std::vector<std::string>& search_terms, const search_options& options) const;
+
+        /**
+         * Adds a term or phrase's TF-IDF to the scores of the given documents which contain it
+         *
+         * @param unit Resolved term or phrase
+         * @param documents Documents to score, in increasing id order
+         * @param scores Dense score accumulator, indexed by document id
+        */
+        void scoreMatchingDocuments(const query_unit& unit, const std::vector<document_id>& documents, std::vector<double>& scores) const;
+
+        /**
+         * Chooses the strategy to evaluate a plain (not boolean) query with, from the number of postings, tokens and
+         * documents each strategy would go through, and orders the units by decreasing IDF
+         *
+         * @param query_units Resolved query units, whose `max_score` are set
+         * @param k Number of best matches to return
+         * @param options Options of the search, which may force a strategy
+         * @return Strategy to use (never automatic)
+        */
+        search_strategy planQuery(std::vector<query_unit>& query_units, const unsigned int k, const search_options& options) const;
+
+        /**
+         * Finds the K-best documents with WAND: documents are visited in id order, and one is only scored once the
+         * score bounds of the units reaching it add up to the K-th best score so far, other units skipping ahead
+         *
+         * @param query_units Resolved query units (with their `max_score`)
+         * @param options Options of the search
+         * @param interruption Stops the search early
+         * @param best_documents K-best documents, filled in
+        */
+        void rankByWand(
+            const std::vector<query_unit>& query_units,
+            const search_options& options,
+            SearchInterruption& interruption,
+            TopKDocuments& best_documents
+        ) const;
+
+        /**
+         * Scores documents score at a time: the postings of all units are gone through in blocks, the block of largest
+         * contributions first, until the contributions left could not change which documents are the K-best, or the
+         * search is interrupted. Those documents are then scored exactly, as term at a time would.
+         *
+         * @param query_units Resolved query units, in scoring order
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param interruption Stops the search early, at which point the best documents so far are taken
+         * @param scores Dense score accumulator, indexed by document id
+         * @param candidates Appended with the documents which may be among the K-best
+        */
+        void scoreByImpact(
+            const std::vector<query_unit>& query_units,
+            const unsigned int k,
+            const search_options& options,
+            SearchInterruption& interruption,
+            std::vector<double>& scores,
+            std::vector<document_id>& candidates
+        ) const;
+
+        /**
+         * Selects the K-best documents by the sum of their quantized impacts, added up term at a time, and scores
+         * them exactly
+         *
+         * @param query_units Resolved query units, in scoring order
+         * @param k Number of best matches to return
+         * @param impacts Quantized impacts of the index
+         * @param interruption Stops the search early, at which point the best documents so far are taken
+         * @param scores Dense score accumulator, indexed by document id
+         * @param candidates Appended with the K-best documents by impact, in increasing id order
+        */
+        template <typename Impact>
+        void scoreByQuantizedImpacts(
+            const std::vector<query_unit>& query_units,
+            const unsigned int k,
+            const QuantizedImpactIndex<Impact>& impacts,
+            SearchInterruption& interruption,
+            std::vector<double>& scores,
+            std::vector<document_id>& candidates
+        ) const;
+
+        /**
+         * Scores every document by counting the units in its tokens, in the forward index (units must be countable)
+         *
+         * @param query_units Resolved query units
+         * @param interruption Stops the scan early, leaving the documents after it unscored
+         * @param scores Dense score accumulator, indexed by document id
+         * @param candidates Appended with the documents containing any unit, in increasing id order
+        */
+        void scoreByForwardScan(
+            const std::vector<query_unit>& query_units,
+            SearchInterruption& interruption,
+            std::vector<double>& scores,
+            std::vector<document_id>& candidates
+        ) const;
+
+        /**
+         * Scores a range of documents for a batch of queries term at a time, a block of documents at once: each
+         * posting list is gone through once, its contributions fanned out to the accumulators of every query sharing
+         * it, so that a term common to many queries is read once rather than once per query
+         *
+         * @param batch_lists Posting lists of the batch, ordered so that each query's units come in scoring order
+         * @param num_queries Number of queries in the batch
+         * @param begin First document of the range
+         * @param end Document after the last of the range
+         * @param options Options of the searches
+         * @param best_documents K-best documents of the range for each query, filled in
+        */
+        void scoreBatchRange(
+            const std::vector<batch_list>& batch_lists,
+            const size_t num_queries,
+            const document_id begin,
+            const document_id end,
+            const search_options& options,
+            std::vector<TopKDocuments>& best_documents
+        ) const;
+
+        /**
+         * Computes the proximity boost factor of a document
+         *
+         * @param query_units Resolved query units
+         * @param document Document to measure
+         * @param proximity_boost Weight of the boost
+         * @return Factor to multiply the document's score by
+        */
+        double proximityFactor(const std::vector<query_unit>& query_units, const document_id document, const double proximity_boost) const;
+
+        // Positional index of the whole corpus
+        std::unique_ptr<InvertedIndex> index;
+        // Forward index of the whole corpus, with the same document ids
+        std::unique_ptr<ForwardIndex> forward_index;
+        // Term of each token of the forward index's vocabulary, so that the token's perfect hash lookup also finds the
+        // term (stop words have none)
+        std::vector<term_id> token_terms;
+        // Terms of the dictionary grouped by how they sound
+        std::unique_ptr<PhoneticIndex> phonetic_index;
+        // Posting lists of the corpus by decreasing contribution, for score at a time evaluation
+        std::unique_ptr<ImpactOrderedIndex> impact_index;
+        // Trie over the dictionary, for wildcards and completions
+        std::unique_ptr<CompletionTrie> completion_trie;
+        // Document id of each path, viewing the paths in the forward index
+        std::unordered_map<std::string_view, document_id> document_ids;
+
+        // Builds the fuzzy term index on the first search which needs it
+        const FuzzyTermIndex& getFuzzyIndex() const;
+
+        // Deletion index of the dictionary, for fuzzy matching
+        mutable std::unique_ptr<FuzzyTermIndex> fuzzy_index;
+        mutable std::once_flag fuzzy_index_built;
+
+        // Builds the quantized impacts of a width (`uint8_t` or `uint16_t`) on the first search which uses them
+        template <typename Impact>
+        const QuantizedImpactIndex<Impact>& getQuantizedImpacts() const;
+
+        // Quantized impacts of every posting, for approximate term at a time ranking
+        mutable std::unique_ptr<QuantizedImpactIndex<uint8_t>> impacts_8bit;
+        mutable std::once_flag impacts_8bit_built;
+        mutable std::unique_ptr<QuantizedImpactIndex<uint16_t>> impacts_16bit;
+        mutable std::once_flag impacts_16bit_built;
+
+        // Builds the trigram indexes on the first search for a substring
+        void buildTrigramIndexes() const;
+
+        // Trigram indexes of the dictionary and of the paths, for substring matching
+        mutable std::unique_ptr<TrigramIndex> term_trigrams;
+        mutable std::unique_ptr<TrigramIndex> path_trigrams;
+        mutable std::once_flag trigram_indexes_built;
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Binary index files are a header, a number of sections each holding one flat array, and a table
+ * locating the sections:
+ *
+ *     header | section | section | ... | section table
+ *
+ * Every section starts on a page boundary, so once the file is memory mapped each section can be used in place
+ * as a typed array, and can be advised to (or locked in) memory independently of the others.
+ * Integers are stored in native byte order, so index files are not portable across architectures.
+*/
+
+// Identifies index files, and the version of their layout
+static const char index_file_magic[8] = {'V', 'C', 'S', 'F', 'I', 'D', 'X', '\0'};
+static const uint32_t index_file_version = 1;
+
+// Alignment of every section within the file
+static const uint64_t index_file_alignment = 4096;
+
+// Size (and alignment) of a transparent huge page
+static const uint64_t huge_page_size = 2 * 1024 * 1024;
+
+/**
+ * How a section of an index file is read, as advised to the kernel, which reads ahead around the faulting page of a
+ * section read sequentially and only the faulting page of a section read at random.
+*/
+enum section_access {
+    SECTION_ACCESS_NORMAL,
+    SECTION_ACCESS_RANDOM,
+    SECTION_ACCESS_SEQUENTIAL
+};
+
+/**
+ * Fixed header at the start of an index file.
+*/
+struct index_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t section_table_offset;
+};
+
+/**
+ * An entry of the section table: where a section lives in the file.
+*/
+struct index_file_section {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * Writes an index file section by section.
+ *
+ * The file is written under a temporary name and only renamed into place by `finish()`, so readers never
+ * see a partially written index.
+*/
+class IndexFileWriter {
+    public:
+        // Remove default constructor
+        IndexFileWriter() = delete;
+
+        // Remove copy constructor and copy assignment
+        IndexFileWriter(const IndexFileWriter&) = delete;
+        IndexFileWriter& operator= (const IndexFileWriter&) = delete;
+
+        /**
+         * Starts writing an index file
+         *
+         * @param path Path the finished file will have
+        */
+        explicit IndexFileWriter(const std::string& path);
+
+        /**
+         * Appends a section holding a flat array
+         *
+         * @param id Identifier of the section, unique within the file
+         * @param elements Array to store
+        */
+        template <typename T>
+        void addSection(const uint32_t id, const std::vector<T>& elements) {
+            addSection(id, elements.data(), sizeof(T), elements.size());
+        }
+
+        /**
+         * Appends a section holding a flat array
+         *
+         * @param id Identifier of the section, unique within the file
+         * @param elements Start of the array to store
+         * @param element_size Size of each element in bytes
+         * @param num_elements Number of elements
+        */
+        void addSection(const uint32_t id, const void* elements, const size_t element_size, const size_t num_elements);
+
+        /**
+         * Starts a section whose elements are appended piece by piece, e.g. one too large to be held in memory at
+         * once. It ends when the next section starts, or with the file.
+         *
+         * @param id Identifier of the section, unique within the file
+         * @param element_size Size of each element in bytes
+        */
+        void beginSection(const uint32_t id, const size_t element_size);
+
+        /**
+         * Appends elements to the section started last
+         *
+         * @param elements Start of the elements to append
+         * @param num_elements Number of elements
+        */
+        void appendToSection(const void* elements, const size_t num_elements);
+
+        // Writes the section table and header, and moves the file into place
+        void finish();
+
+        // Removes the temporary file if the index was never finished
+        ~IndexFileWriter();
+
+    private:
+        // Pads the file with zeros up to the next section boundary
+        void align();
+
+        // Final and temporary paths of the file
+        std::string path;
+        std::string temporary_path;
+
+        // File being written, and the sections written so far
+        std::ofstream file;
+        std::vector<index_file_section> sections;
+        bool finished = false;
+};
+
+/**
+ * A memory mapped index file, giving in-place access to its sections.
+ *
+ * Sections may be managed one by one in the page cache (see IndexWarmup): advised of how they are read, faulted in
+ * or locked in memory ahead of use, or copied out of the mapping into memory backed by transparent huge pages, so
+ * that looking up a large section (e.g. a dictionary) takes fewer TLB misses.
+*/
+class IndexFile {
+    public:
+        // Remove default constructor
+        IndexFile() = delete;
+
+        // Remove copy constructor and copy assignment
+        IndexFile(const IndexFile&) = delete;
+        IndexFile& operator= (const IndexFile&) = delete;
+
+        /**
+         * Maps an index file and reads its section table
+         *
+         * @param path Path of the index file
+        */
+        explicit IndexFile(const std::string& path);
+
+        // `true` if the file has a section with the given id
+        bool hasSection(const uint32_t id) const { return sections.count(id) > 0; }
+
+        /**
+         * Retrieves a section as a typed array
+         *
+         * @param id Identifier of the section
+         * @return Array stored in the section, pointing into the mapping
+        */
+        template <typename T>
+        std::span<const T> getSection(const uint32_t id) const {
+            auto& section = findSection(id, sizeof(T));
+            return std::span<const T>(reinterpret_cast<const T*>(getSectionData(section)), section.size / sizeof(T));
+        }
+
+        // Section table of the file, keyed by section id
+        const std::unordered_map<uint32_t, index_file_section>& getSections() const { return sections; }
+
+        // Underlying mapping of the whole file
+        const MappedFile& getMapping() const { return *mapping; }
+
+        // Path of the file
+        const std::string& getPath() const { return path; }
+
+        /**
+         * Advises the kernel of how a section will be read
+         *
+         * @param id Identifier of the section
+         * @param access How the section is read
+        */
+        void adviseSection(const uint32_t id, const section_access access) const;
+
+        /**
+         * Faults every page of a section into memory, reading it from disk if the page cache does not hold it
+         *
+         * @param id Identifier of the section
+         * @param stop Checked between pages, stopping early once it is set
+        */
+        void prefaultSection(const uint32_t id, const std::atomic<bool>& stop) const;
+
+        /**
+         * Locks the pages of a section in memory, faulting them in, so that they are never evicted
+         *
+         * @param id Identifier of the section
+         * @return `false` if the kernel refused (e.g. past the RLIMIT_MEMLOCK limit of unprivileged processes)
+        */
+        bool lockSection(const uint32_t id) const;
+
+        /**
+         * Copies a section out of the mapping into memory advised to be backed by transparent huge pages. The section
+         * then takes private memory, and `getSection` returns the copy, so it must be called before the section is used.
+         *
+         * @param id Identifier of the section
+        */
+        void copySectionToHugePages(const uint32_t id);
+
+    private:
+        // Start of a section's data, in its huge page copy if it has one, otherwise in the mapping
+        const uint8_t* getSectionData(const index_file_section& section) const;
+
+        // Start and size of a section's data rounded out to whole pages, which the kernel manages memory in
+        std::pair<void*, size_t> getSectionPages(const uint32_t id) const;
+
+        /**
+         * Looks up a section, checking that it holds elements of the expected size
+         *
+         * @param id Identifier of the section
+         * @param element_size Expected size of each element in bytes
+         * @return Section table entry
+        */
+        const index_file_section& findSection(const uint32_t id, const size_t element_size) const;
+
+        // Path of the file, for error messages
+        std::string path;
+        // Mapping of the whole file
+        std::unique_ptr<MappedFile> mapping;
+        // Section table, keyed by section id
+        std::unordered_map<uint32_t, index_file_section> sections;
+        // Copies of sections in huge pages, keyed by section id
+        std::unordered_map<uint32_t, std::unique_ptr<uint8_t, void (*)(void*)>> huge_page_copies;
+};
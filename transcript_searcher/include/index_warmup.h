@@ -0,0 +1,108 @@
+#pragma once
+
+#include "index_file.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <thread>
+
+/**
+ * Ways of bringing the hot sections of an index file into memory at startup.
+*/
+enum warmup_mode {
+    // Leave the sections to be faulted in by the first searches
+    WARMUP_NONE,
+    // Fault every page of the sections in, which the kernel may still evict later
+    WARMUP_PREFAULT,
+    // Lock the sections in memory, so that they are never evicted
+    WARMUP_LOCK
+};
+
+// Name of each warm-up mode, as given on the command line
+static const char* const warmup_mode_names[] = {"none", "prefault", "lock"};
+
+/**
+ * Settings of the warm-up of the memory mapped index files.
+*/
+struct index_warmup_options {
+    // How the hot sections (e.g. dictionary, document statistics) are brought into memory
+    warmup_mode mode = WARMUP_NONE;
+    // Whether they are brought in on a background thread, so that searches can start at once
+    bool background = false;
+    // Whether the kernel is advised of how each section is read (random or sequential)
+    bool advise = false;
+    // Whether the dictionary is copied into memory backed by transparent huge pages
+    bool huge_pages = false;
+};
+
+/**
+ * How an index reads one of the sections of its file, declared by each kind of index for IndexWarmup.
+*/
+struct section_profile {
+    uint32_t id;
+    section_access access;
+    // Whether the section is hot, i.e. read by (nearly) every search
+    bool hot;
+    // Whether the section is part of the dictionary, looked up by every search term
+    bool dictionary;
+};
+
+/**
+ * Parses the name of a warm-up mode, as listed in `warmup_mode_names`
+ *
+ * @param name Name of the mode ("none", "prefault" or "lock")
+ * @return Warm-up mode
+*/
+warmup_mode parseWarmupMode(const std::string& name);
+
+/**
+ * Warms up the sections of a memory mapped index file as it is opened, so that the first searches after a restart do
+ * not each pay for page faults, and reports the time it took on stderr.
+ *
+ * The kernel is advised of how each section is read, and the dictionary is copied into huge pages, right away, since
+ * both change how the sections are then used. Hot sections are then faulted in (or locked in memory), either before
+ * the constructor returns or on a background thread, which is stopped if the index is closed first. A section
+ * which cannot be locked (past the RLIMIT_MEMLOCK limit) is only faulted in.
+*/
+class IndexWarmup {
+    public:
+        // Remove default constructor
+        IndexWarmup() = delete;
+
+        // Remove copy constructor and copy assignment
+        IndexWarmup(const IndexWarmup&) = delete;
+        IndexWarmup& operator= (const IndexWarmup&) = delete;
+
+        /**
+         * Warms up an index file, which must outlive the IndexWarmup
+         *
+         * @param file Index file
+         * @param profiles How the index reads each of its sections (sections missing from the file are skipped)
+         * @param options Warm-up to apply
+        */
+        IndexWarmup(IndexFile& file, std::span<const section_profile> profiles, const index_warmup_options& options);
+
+        // `true` once the warm-up is over
+        bool isDone() const { return done.load(std::memory_order_acquire); }
+
+        // Stops the warm-up if it is still running in the background
+        ~IndexWarmup();
+
+    private:
+        // Faults in (or locks) the hot sections, and reports the warm-up
+        void warmHotSections();
+
+        IndexFile& file;
+        std::span<const section_profile> profiles;
+        index_warmup_options options;
+
+        // Time the warm-up started, and the time spent on huge page copies
+        std::chrono::steady_clock::time_point start_time;
+        std::chrono::steady_clock::duration copy_duration{0};
+
+        std::atomic<bool> stopping = false;
+        std::atomic<bool> done = false;
+        std::thread thread;
+};
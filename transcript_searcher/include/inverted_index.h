@@ -0,0 +1,249 @@
+#pragma once
+
+#include "roaring_bitmap.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Dense identifier of a document within a single InvertedIndex
+typedef uint32_t document_id;
+
+// Dense identifier of a term within a single InvertedIndex
+typedef uint32_t term_id;
+
+/**
+ * A single entry of a term's posting list: a document the term appears in, and the number of times it appears there.
+*/
+struct posting {
+    document_id document;
+    uint32_t frequency;
+};
+
+/**
+ * A document and its term statistics, as produced by the preprocessing module.
+*/
+struct indexed_document {
+    // Unique path of the source file of the transcript
+    std::string path;
+    // Number of unique terms in the transcript
+    unsigned int num_terms;
+    // Each (non stop word) term in the transcript and its number of appearances
+    std::vector<std::pair<std::string, unsigned int>> term_frequencies;
+    // Token positions (counting stop words) of each term, aligned with `term_frequencies`, or empty if not recorded
+    std::vector<std::vector<uint32_t>> term_positions;
+};
+
+/**
+ * An immutable, in-memory inverted index over a corpus of transcripts.
+ *
+ * Documents and terms are addressed by dense integer ids, and all posting lists are stored back to back
+ * in a single array (sorted by document id within each list), so that search algorithms can score with
+ * plain array scans instead of the string-keyed maps and JSON parsing required by the database layout.
+ *
+ * Terms are stored in sorted order, so term ids also give the lexicographic order of the dictionary.
+ *
+ * The index may optionally store the token positions of every posting, for phrase and proximity matching.
+ * Positions are delta encoded as varints, one run per posting (of `frequency` values), with the runs of all
+ * postings back to back in a single byte array.
+ *
+ * Terms appearing in at least 1/16th of the documents also keep their documents as a RoaringBitmap, on which set
+ * operations (e.g. boolean queries) run word by word rather than posting by posting. The bitmaps are kept on top of
+ * the posting lists, which scoring reads for the frequencies. On a 30,000 document corpus they add about 7% to the
+ * postings' memory and make boolean queries over common terms up to 3 times faster (see `benchmark --boolean_bitmaps`).
+ * Plain searches, which read every posting to score it anyway, do not use them.
+*/
+class InvertedIndex {
+    public:
+        // Remove default constructor
+        InvertedIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        InvertedIndex(const InvertedIndex&) = delete;
+        InvertedIndex& operator= (const InvertedIndex&) = delete;
+
+        /**
+         * Initialize an InvertedIndex from already laid out index data (see InvertedIndexBuilder)
+         *
+         * @param document_paths Path of each document, indexed by document id
+         * @param document_num_terms Number of unique terms in each document, indexed by document id
+         * @param terms Sorted term dictionary, indexed by term id
+         * @param posting_offsets Offset of each term's posting list in `postings`, with a trailing end offset
+         * @param postings All posting lists, back to back
+         * @param position_offsets Offset of each posting's positions in `positions`, with a trailing end offset (empty if positions are not stored)
+         * @param positions Encoded positions of all postings, back to back
+        */
+        InvertedIndex(
+            std::vector<std::string> document_paths,
+            std::vector<uint32_t> document_num_terms,
+            std::vector<std::string> terms,
+            std::vector<uint64_t> posting_offsets,
+            std::vector<posting> postings,
+            std::vector<uint64_t> position_offsets = {},
+            std::vector<uint8_t> positions = {}
+        );
+
+        // Number of documents in the index
+        size_t getNumDocuments() const { return document_paths.size(); }
+
+        // Number of distinct terms in the index
+        size_t getNumTerms() const { return terms.size(); }
+
+        // Path of the source file of a document
+        const std::string& getDocumentPath(const document_id document) const { return document_paths[document]; }
+
+        // Number of unique terms in a document
+        uint32_t getDocumentNumTerms(const document_id document) const { return document_num_terms[document]; }
+
+        // Dictionary entry of a term id
+        const std::string& getTerm(const term_id term) const { return terms[term]; }
+
+        /**
+         * Looks up the id of a term in the dictionary
+         *
+         * @param term Term to look up
+         * @param id Set to the term's id if it is found
+         * @return `true` if the term appears in the index, otherwise `false`
+        */
+        bool findTerm(const std::string& term, term_id& id) const;
+
+        // Posting list of a term, sorted by document id
+        std::span<const posting> getPostings(const term_id term) const {
+            return std::span<const posting>(postings.data() + posting_offsets[term], postings.data() + posting_offsets[term + 1]);
+        }
+
+        // Documents of a term as a bitmap, for terms in at least 1/16th of the documents (otherwise `nullptr`)
+        const RoaringBitmap* getDocumentBitmap(const term_id term) const;
+
+        // Number of documents a term appears in
+        uint32_t getDocumentFrequency(const term_id term) const {
+            return static_cast<uint32_t>(posting_offsets[term + 1] - posting_offsets[term]);
+        }
+
+        /**
+         * Largest normalized term frequency (frequency / number of terms in document) of a term over all documents,
+         * which multiplied by the term's IDF bounds any single document's score contribution from that term.
+         *
+         * @param term Term id
+         * @return Maximum normalized term frequency of the term
+        */
+        double getMaxTermFrequency(const term_id term) const { return max_term_frequencies[term]; }
+
+        // `true` if the index stores token positions
+        bool hasPositions() const { return !position_offsets.empty(); }
+
+        /**
+         * Decodes the token positions of a posting
+         *
+         * @param term Term id
+         * @param index Index of the posting within the term's posting list
+         * @param term_positions Set to the positions of the term in the posting's document, in increasing order
+        */
+        void getPositions(const term_id term, const size_t index, std::vector<uint32_t>& term_positions) const;
+
+        // Number of bytes used by the encoded positions
+        size_t getPositionsSize() const { return positions.size(); }
+
+    private:
+        // Path of each document, indexed by document id
+        std::vector<std::string> document_paths;
+        // Number of unique terms in each document, indexed by document id
+        std::vector<uint32_t> document_num_terms;
+
+        // Sorted term dictionary, indexed by term id
+        std::vector<std::string> terms;
+        // Reverse lookup of the dictionary
+        std::unordered_map<std::string, term_id> term_ids;
+
+        // Offset of each term's posting list in `postings`, plus a trailing end offset
+        std::vector<uint64_t> posting_offsets;
+        // All posting lists, back to back
+        std::vector<posting> postings;
+        // Maximum normalized term frequency of each term
+        std::vector<double> max_term_frequencies;
+        // Documents of each dense term, as a bitmap
+        std::unordered_map<term_id, RoaringBitmap> document_bitmaps;
+
+        // Offset of each posting's encoded positions in `positions`, plus a trailing end offset
+        std::vector<uint64_t> position_offsets;
+        // Encoded positions of all postings, back to back
+        std::vector<uint8_t> positions;
+};
+
+/**
+ * Accumulates documents and lays them out as an InvertedIndex.
+ *
+ * Documents receive ids in the order they are added, so several indexes built from the same builder
+ * (e.g. with different term filters) agree on document ids.
+*/
+class InvertedIndexBuilder {
+    public:
+        // Default constructor
+        InvertedIndexBuilder() = default;
+
+        // Remove copy constructor and copy assignment
+        InvertedIndexBuilder(const InvertedIndexBuilder&) = delete;
+        InvertedIndexBuilder& operator= (const InvertedIndexBuilder&) = delete;
+
+        /**
+         * Reads every document stored by the preprocessing module in the database
+         *
+         * @param database_path Path to database which stores corpus state
+         * @param on_document Callback invoked with each document, in table order
+        */
+        static void readDatabaseDocuments(
+            const std::string& database_path,
+            const std::function<void(const indexed_document&)>& on_document
+        );
+
+        /**
+         * Adds a document to the index being built
+         *
+         * Positions are stored if the document carries them (documents without them get empty position runs).
+         *
+         * @param document Document and its term statistics
+         * @return Id assigned to the document
+        */
+        document_id addDocument(const indexed_document& document);
+
+        // Number of documents added so far
+        size_t getNumDocuments() const { return document_paths.size(); }
+
+        /**
+         * Lists every term added so far and the number of documents it appears in
+         *
+         * @return Vector of term-document frequency pairs (unordered)
+        */
+        std::vector<std::pair<std::string, uint32_t>> getTermDocumentFrequencies() const;
+
+        /**
+         * Lays out the documents added so far as an InvertedIndex
+         *
+         * All documents are always kept (so document ids and statistics are shared between indexes built
+         * from this builder), but only terms accepted by `term_filter` are placed in the dictionary.
+         *
+         * @param term_filter Optional predicate selecting the terms to include
+         * @return The built index
+        */
+        std::unique_ptr<InvertedIndex> build(const std::function<bool(const std::string&)>& term_filter = nullptr) const;
+
+    private:
+        // Path and number of unique terms of each document added
+        std::vector<std::string> document_paths;
+        std::vector<uint32_t> document_num_terms;
+
+        // A term's posting list while it is being built, with the size and encoding of each posting's positions
+        struct term_posting_list {
+            std::vector<posting> postings;
+            std::vector<uint32_t> position_sizes;
+            std::vector<uint8_t> positions;
+        };
+
+        // Posting lists of each term seen so far, in document insertion order
+        std::unordered_map<std::string, term_posting_list> term_postings;
+        // Whether any document added carried positions
+        bool has_positions = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * A read-only memory mapping of a whole file.
+ *
+ * Pages are loaded lazily by the operating system on first access and shared with every other process
+ * mapping the same file, so large index files cost no load time and no private memory.
+*/
+class MappedFile {
+    public:
+        // Remove default constructor
+        MappedFile() = delete;
+
+        // Remove copy constructor and copy assignment
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+
+        /**
+         * Maps a file into memory
+         *
+         * @param path Path of the file to map
+        */
+        explicit MappedFile(const std::string& path);
+
+        // Start of the mapped file
+        const uint8_t* getData() const { return data; }
+
+        // Size of the mapped file in bytes
+        size_t getSize() const { return size; }
+
+        // Unmaps the file
+        ~MappedFile();
+
+    private:
+        // Start and size of the mapping
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * A minimal perfect hash function over a fixed set of keys: it maps each of the n keys to its own slot in [0, n),
+ * in constant time, storing a few bits per key. Keys outside the set map to arbitrary slots, so a lookup table
+ * built on it must also tell keys apart (e.g. with a fingerprint per slot).
+ *
+ * Keys are hashed into buckets of about 5 keys. Each bucket stores a pilot, chosen at build time (largest buckets
+ * first, while the table is empty) so that hashing its keys together with the pilot lands them on free slots
+ * (the PTHash construction). A key's slot only takes its hash, its bucket's pilot, and a few multiplications.
+ *
+ * The function is a view over its pilots, so that they can be stored in, and used from, a memory mapped file.
+*/
+class MinimalPerfectHash {
+    public:
+        // Remove default constructor
+        MinimalPerfectHash() = delete;
+
+        // Remove copy constructor and copy assignment
+        MinimalPerfectHash(const MinimalPerfectHash&) = delete;
+        MinimalPerfectHash& operator= (const MinimalPerfectHash&) = delete;
+
+        /**
+         * Initialize a MinimalPerfectHash from the result of `build()`
+         *
+         * @param seed Seed the keys are hashed with
+         * @param num_keys Number of keys (at least 1)
+         * @param pilots Pilot of each bucket (must outlive the function)
+        */
+        MinimalPerfectHash(const uint64_t seed, const uint64_t num_keys, std::span<const uint32_t> pilots);
+
+        /**
+         * Builds a minimal perfect hash function over a set of distinct keys
+         *
+         * @param keys Keys to hash, without duplicates
+         * @param seed Set to the seed the keys are hashed with
+         * @param pilots Set to the pilot of each bucket
+        */
+        static void build(std::span<const std::string_view> keys, uint64_t& seed, std::vector<uint32_t>& pilots);
+
+        // 64-bit hash of a key, from which its slot (see getSlot) and any fingerprint are derived
+        static uint64_t hash(std::string_view key, const uint64_t seed);
+
+        // Slot of a key, given its hash
+        uint64_t getSlot(const uint64_t key_hash) const;
+
+        // Seed the keys are hashed with
+        uint64_t getSeed() const { return seed; }
+
+    private:
+        const uint64_t seed;
+        const uint64_t num_keys;
+        std::span<const uint32_t> pilots;
+};
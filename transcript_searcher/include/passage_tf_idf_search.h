@@ -0,0 +1,108 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include <memory>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over short,
+ * timed passages of the transcripts rather than whole transcripts.
+ *
+ * Passages are built from the timed segments stored with each transcript: a passage starts at a segment and
+ * takes the following segments which start within `passage_seconds` of it, and a new passage starts every
+ * half `passage_seconds`, so passages overlap and a match is never split by a passage boundary.
+ * Each passage is indexed as its own document (IDFs count passages), so a transcript is ranked by its best
+ * passage, and the passage gives the time to jump to. Transcripts stored without segments are indexed as
+ * a single passage with unknown (zero) times.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops scoring and ranks the passages scored
+ * so far.
+*/
+class PassageTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        PassageTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        PassageTfIdfSearch(const PassageTfIdfSearch&) = delete;
+        PassageTfIdfSearch& operator= (const PassageTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a PassageTfIdfSearch instance, loading the timed segments of the corpus from the database
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param passage_seconds Length of each passage, in seconds
+        */
+        PassageTfIdfSearch(const std::string database_path, const double passage_seconds = 30.0);
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts, scored by their best passage, and stores
+         * the transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching passages, at most one per transcript.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best passages to return
+         * @param options Options of the search
+         * @param best_passages Vector to store the scored passages, best first
+        */
+        void getBestPassageMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_passage>& best_passages
+        );
+
+        // Passages are what this algorithm indexes
+        bool searchesPassages() const override { return true; }
+
+        // Default destructor
+        ~PassageTfIdfSearch() = default;
+
+    private:
+        // Which transcript a passage belongs to, and where it lies in the source file
+        struct passage_location {
+            uint32_t transcript;
+            double start_time;
+            double end_time;
+            // Whether the times are known
+            bool timed;
+        };
+
+        // A timed segment of a transcript, as stored in the database
+        struct timed_segment {
+            double start_time;
+            double end_time;
+            std::string text;
+        };
+
+        /**
+         * Groups a transcript's segments into overlapping passages and adds them to the index being built
+         *
+         * @param transcript Index of the transcript in `transcript_paths`
+         * @param segments Segments of the transcript, ordered by start time
+         * @param builder Builder of the passage index
+        */
+        void addPassages(const uint32_t transcript, const std::vector<timed_segment>& segments, InvertedIndexBuilder& builder);
+
+        // Length of each passage, in seconds
+        const double passage_seconds;
+
+        // Path of each transcript
+        std::vector<std::string> transcript_paths;
+        // Location of each passage, indexed by its document id in `index`
+        std::vector<passage_location> passages;
+        // Index with a document per passage
+        std::unique_ptr<InvertedIndex> index;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Groups the terms of an index's dictionary by how they sound, so that a word can be expanded to the terms
+ * speech-to-text may have written it as (e.g. "puck" and "puk", or "gretzky" and "gretsky").
+ *
+ * Terms are keyed by their Metaphone code, and laid out like posting lists: the sorted distinct keys, and the
+ * terms of each key back to back in a single array.
+*/
+class PhoneticIndex {
+    public:
+        // Remove default constructor
+        PhoneticIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        PhoneticIndex(const PhoneticIndex&) = delete;
+        PhoneticIndex& operator= (const PhoneticIndex&) = delete;
+
+        /**
+         * Initialize a PhoneticIndex over the dictionary of an index
+         *
+         * @param index Index whose terms are grouped
+        */
+        explicit PhoneticIndex(const InvertedIndex& index);
+
+        /**
+         * Finds the terms which sound like a word
+         *
+         * @param word Word to look up (normalized like terms are)
+         * @return Ids of the terms sharing the word's phonetic key (the word itself included, if it is a term), in increasing order
+        */
+        std::span<const term_id> findTerms(const std::string& word) const;
+
+        // Number of distinct phonetic keys
+        size_t getNumKeys() const { return keys.size(); }
+
+        /**
+         * Computes the phonetic key of a word with the original Metaphone rules (e.g. "ck" and "k" both encode as K,
+         * "z" as S, and vowels only count at the start of a word). Characters other than letters are kept as they are.
+         *
+         * @param word Word to encode
+         * @return Phonetic key of the word, in upper case
+        */
+        static std::string encode(const std::string& word);
+
+    private:
+        // Sorted distinct keys of the dictionary's terms
+        std::vector<std::string> keys;
+        // Offset of each key's terms in `key_terms`, plus a trailing end offset
+        std::vector<uint32_t> key_offsets;
+        // Terms of every key, back to back
+        std::vector<term_id> key_terms;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * A term of a phrase, and its offset in tokens (stop words included) from the start of the phrase.
+*/
+struct phrase_term {
+    term_id term;
+    uint32_t offset;
+};
+
+/**
+ * Finds every document containing a phrase, and the number of times it occurs there.
+ *
+ * Documents are found by intersecting the terms' posting lists, driven by the rarest term and galloping
+ * through the others, and each document in the intersection is verified by galloping through the position
+ * lists of the terms. Only the non stop word terms are verified, so stop words inside a phrase just keep
+ * their place.
+ *
+ * @param index Index to search, which must store positions
+ * @param phrase Terms of the phrase
+ * @return Documents containing the phrase in increasing id order, with its number of occurrences as frequency
+*/
+std::vector<posting> matchPhrase(const InvertedIndex& index, const std::vector<phrase_term>& phrase);
+
+/**
+ * Finds every occurrence of a phrase in a document's sequence of token ids (see ForwardIndex)
+ *
+ * @param tokens Token ids of the document, in order of appearance
+ * @param phrase Terms of the phrase, as token ids of the same vocabulary
+ * @param starts Set to the position of the start of each occurrence, in increasing order
+*/
+void findPhraseInTokens(std::span<const uint32_t> tokens, const std::vector<phrase_term>& phrase, std::vector<uint32_t>& starts);
+
+/**
+ * Measures the shortest window of a document holding at least one position from each list
+ *
+ * @param position_lists Non-empty lists of positions, each in increasing order
+ * @return Number of tokens spanned by the shortest such window
+*/
+uint32_t minimumCoveringSpan(const std::vector<std::vector<uint32_t>>& position_lists);
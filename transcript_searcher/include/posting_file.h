@@ -0,0 +1,98 @@
+#pragma once
+
+#include "forward_index.h"
+#include "index_file.h"
+#include "index_warmup.h"
+#include "inverted_index.h"
+#include <memory>
+#include <span>
+#include <string>
+
+// Sections of a posting file
+enum posting_file_section : uint32_t {
+    POSTING_FILE_TERM_OFFSETS = 1,
+    POSTING_FILE_DOCUMENT_NUM_TERMS = 2,
+    POSTING_FILE_POSTINGS = 3
+};
+
+// Size of the blocks in which postings are read from a posting file, one page
+static const uint64_t posting_block_size = index_file_alignment;
+
+// Number of postings in a block
+static const uint64_t postings_per_block = posting_block_size / sizeof(posting);
+
+/**
+ * The posting lists of an inverted index stored on disk, for indexes too large to load, keyed by the token ids of a
+ * ForwardIndex (whose vocabulary doubles as the dictionary, stop words getting empty lists).
+ *
+ * The term offsets and the number of terms of each document are used in place from the mapped file. The postings
+ * section is only meant to be read block by block, e.g. by an AsyncFileReader: it starts on a page boundary, so
+ * a term's postings span the blocks `getFirstPosting(token) / postings_per_block` onwards.
+ *
+ * The file is built from the database by `build()`, with the documents in the order of the forward index and each
+ * term's postings in increasing document order. Building holds a bounded run of postings in memory at a time, the
+ * runs being spilled next to the file and merged into it.
+*/
+class PostingFile {
+    public:
+        // Remove default constructor
+        PostingFile() = delete;
+
+        // Remove copy constructor and copy assignment
+        PostingFile(const PostingFile&) = delete;
+        PostingFile& operator= (const PostingFile&) = delete;
+
+        /**
+         * Maps a posting file
+         *
+         * @param path Path of the posting file
+         * @param warmup_options Warm-up of the term offsets and the number of terms of each document
+        */
+        explicit PostingFile(const std::string& path, const index_warmup_options& warmup_options = index_warmup_options());
+
+        /**
+         * Builds a posting file from the documents stored in the database
+         *
+         * @param database_path Path to database which stores corpus state
+         * @param forward_index Forward index of the same documents, whose token ids key the posting lists
+         * @param path Path of the posting file to write
+         * @return `false` if the database's documents do not match the forward index's (nothing is written then)
+        */
+        static bool build(const std::string& database_path, const ForwardIndex& forward_index, const std::string& path);
+
+        // Number of documents in the index
+        size_t getNumDocuments() const { return document_num_terms.size(); }
+
+        // Number of tokens the posting lists are keyed by
+        size_t getVocabularySize() const { return term_offsets.size() - 1; }
+
+        // Number of terms of a document, by which term frequencies are normalized
+        uint32_t getDocumentNumTerms(const document_id document) const { return document_num_terms[document]; }
+
+        // Number of documents a token appears in
+        uint32_t getDocumentFrequency(const token_id token) const {
+            return static_cast<uint32_t>(term_offsets[token + 1] - term_offsets[token]);
+        }
+
+        // Index of a token's first posting within the postings section
+        uint64_t getFirstPosting(const token_id token) const { return term_offsets[token]; }
+
+        // Byte offset of the postings section within the file
+        uint64_t getPostingsOffset() const { return postings.offset; }
+
+        // Number of postings of all tokens
+        uint64_t getNumPostings() const { return postings.size / sizeof(posting); }
+
+    private:
+        // Mapped file
+        std::unique_ptr<IndexFile> file;
+        // Warm-up of the mapped file, stopped before the file is unmapped
+        std::unique_ptr<IndexWarmup> warmup;
+
+        // Offset of each token's postings in the postings section, plus a trailing end offset
+        std::span<const uint64_t> term_offsets;
+        // Number of terms of each document
+        std::span<const uint32_t> document_num_terms;
+        // Where the postings section lives in the file
+        index_file_section postings;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <span>
+#include <vector>
+
+/**
+ * The TF-IDF contribution of every posting of an index, precomputed and quantized to small integers (`Impact` is
+ * `uint8_t` or `uint16_t`), so that a query is scored with integer additions instead of a division and multiplications
+ * in double precision per posting.
+ *
+ * Contributions are mapped linearly onto [1, max] with a single scale for the whole index, the largest contribution
+ * of any posting taking the largest impact, so that impacts of different terms add up like their contributions do.
+ * A posting never quantizes to 0, so that every document containing a term still matches it. Rounding makes the
+ * ranking approximate: documents whose scores differ by less than about a step of the scale may swap.
+ *
+ * Impacts are laid out like the index's posting lists: those of each term are aligned with the term's postings.
+*/
+template <typename Impact>
+class QuantizedImpactIndex {
+    public:
+        // Remove default constructor
+        QuantizedImpactIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        QuantizedImpactIndex(const QuantizedImpactIndex&) = delete;
+        QuantizedImpactIndex& operator= (const QuantizedImpactIndex&) = delete;
+
+        /**
+         * Initialize a QuantizedImpactIndex with the contributions of every posting of an index
+         *
+         * @param index Index whose postings are quantized
+        */
+        explicit QuantizedImpactIndex(const InvertedIndex& index);
+
+        // Impact of each posting of a term, in the order of `InvertedIndex::getPostings()`
+        std::span<const Impact> getImpacts(const term_id term) const {
+            return std::span<const Impact>(impacts.data() + impact_offsets[term], impacts.data() + impact_offsets[term + 1]);
+        }
+
+        // Impact of a contribution, which saturates at the largest impact (e.g. for phrases, rarer than any term)
+        Impact quantize(const double contribution) const;
+
+        // Number of bytes used by the impacts
+        size_t getSizeInBytes() const { return impacts.size() * sizeof(Impact); }
+
+    private:
+        // Impacts per unit of contribution
+        double scale = 0.0;
+        // Offset of each term's impacts in `impacts`, plus a trailing end offset
+        std::vector<uint64_t> impact_offsets;
+        // Impacts of all postings, back to back
+        std::vector<Impact> impacts;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include "concurrent_inverted_index.h"
+#include "transcript_database_writer.h"
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over an
+ * in-memory index which new transcripts can be added to while it is being searched.
+ *
+ * The corpus in the database is loaded into an immutable base segment. Documents indexed afterwards are
+ * tokenized and counted here and appended to a lock-free delta segment, so they are searchable as soon as
+ * `indexDocument` returns, and are queued to be written to the database in the background.
+ * Searches score both segments with IDFs over their combined document counts, as if they were one corpus.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops scoring and ranks the documents scored
+ * so far.
+*/
+class RealTimeTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        RealTimeTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        RealTimeTfIdfSearch(const RealTimeTfIdfSearch&) = delete;
+        RealTimeTfIdfSearch& operator= (const RealTimeTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a RealTimeTfIdfSearch instance, loading the corpus from the database
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+        */
+        RealTimeTfIdfSearch(const std::string database_path);
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the 
+         * transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options (only the deadline,
+         * latency budget and cancellation token of which are supported, the operators of a boolean query being ignored
+         * and its excluded terms dropped).
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Tokenizes and counts a transcript, makes it immediately searchable, and queues it to be written to the database.
+         * 
+         * @param path Unique path of the source file of the transcript
+         * @param transcript Raw text transcript of the source file
+         * @return `true` if the document was indexed, `false` if it is already indexed
+        */
+        bool indexDocument(const std::string& path, const std::string& transcript);
+
+        // Default destructor
+        ~RealTimeTfIdfSearch() = default;
+
+    private:
+        /**
+         * Searches terms, stopping early if the search is interrupted
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search, whose statistics are recorded
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void searchTerms(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        // Corpus as loaded from the database
+        std::unique_ptr<InvertedIndex> base_segment;
+
+        // Documents indexed since loading
+        std::unique_ptr<ConcurrentInvertedIndex> delta_segment;
+
+        // Paths of every indexed document, guarded by `index_mutex` (which searches never take)
+        std::unordered_set<std::string> indexed_paths;
+        std::mutex index_mutex;
+
+        // Persists documents indexed since loading
+        std::unique_ptr<TranscriptDatabaseWriter> database_writer;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * A chunk of a RoaringBitmap: the values sharing their high 16 bits, as a sorted array of their low 16 bits,
+ * or as a bitmap of 65536 bits once there are too many for an array to be smaller.
+*/
+struct roaring_container {
+    // High 16 bits of the chunk's values
+    uint16_t key;
+    // Number of values in the chunk
+    uint32_t cardinality;
+    // Sorted low bits of the values (array containers only)
+    std::vector<uint16_t> array;
+    // Bit of each of the 65536 possible low bits, as 1024 words (bitmap containers only)
+    std::vector<uint64_t> words;
+};
+
+/**
+ * A compressed set of 32-bit integers, such as the documents a term appears in, in the Roaring layout.
+ *
+ * Values are split into chunks by their high 16 bits. A chunk holding at most 4096 values is a sorted array of
+ * their low 16 bits, and a denser chunk is a bitmap (8 KB), so a set takes at most 2 bytes per value and at most
+ * one bit per possible value. Set operations go chunk by chunk: two bitmaps are combined 64-bit word by word (in
+ * plain loops the compiler vectorizes), an array against a bitmap probes one bit per value, and two arrays merge.
+*/
+class RoaringBitmap {
+    public:
+        // Remove default constructor
+        RoaringBitmap() = delete;
+
+        // Remove copy constructor and copy assignment
+        RoaringBitmap(const RoaringBitmap&) = delete;
+        RoaringBitmap& operator= (const RoaringBitmap&) = delete;
+
+        // Default move constructor and move assignment
+        RoaringBitmap(RoaringBitmap&&) = default;
+        RoaringBitmap& operator= (RoaringBitmap&&) = default;
+
+        /**
+         * Initialize a RoaringBitmap holding a set of values
+         *
+         * @param values Values of the set, in increasing order
+        */
+        explicit RoaringBitmap(std::span<const uint32_t> values);
+
+        // Values in both of two sets
+        static RoaringBitmap intersect(const RoaringBitmap& a, const RoaringBitmap& b);
+
+        // Values in either of two sets
+        static RoaringBitmap unite(const RoaringBitmap& a, const RoaringBitmap& b);
+
+        // Values in the first of two sets but not the second
+        static RoaringBitmap subtract(const RoaringBitmap& a, const RoaringBitmap& b);
+
+        // `true` if the set holds a value
+        bool contains(const uint32_t value) const;
+
+        // Number of values in the set
+        uint64_t getCardinality() const { return cardinality; }
+
+        /**
+         * Lists the values of the set
+         *
+         * @param values Set to the values, in increasing order
+        */
+        void getValues(std::vector<uint32_t>& values) const;
+
+        // Number of bytes used by the containers
+        size_t getSizeInBytes() const;
+
+    private:
+        // Initialize a RoaringBitmap from its (non empty, sorted by key) containers
+        explicit RoaringBitmap(std::vector<roaring_container> containers);
+
+        // Containers sorted by key
+        std::vector<roaring_container> containers;
+        // Number of values in the set
+        uint64_t cardinality = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include <chrono>
+#include <cstddef>
+
+// Number of postings (or tokens scanned) between checks of whether a search was cancelled or is past its deadline, so
+// that reading the clock costs next to nothing
+static const size_t interruption_check_interval = 4096;
+
+/**
+ * Tells the scoring loops of a search when to stop: once its deadline or the end of its latency budget passes, or once
+ * it is cancelled (see search_options).
+ *
+ * Loops poll `check()` between blocks of work (e.g. every few thousand postings) rather than per posting, as reading
+ * the clock takes tens of nanoseconds. Once a check has failed, every later one does too, so that nested loops all
+ * stop.
+*/
+class SearchInterruption {
+    public:
+        // Remove default constructor
+        SearchInterruption() = delete;
+
+        // Remove copy constructor and copy assignment
+        SearchInterruption(const SearchInterruption&) = delete;
+        SearchInterruption& operator= (const SearchInterruption&) = delete;
+
+        /**
+         * Initialize a SearchInterruption for a search
+         *
+         * @param options Options of the search, with its deadline, latency budget and cancellation token
+         * @param start_time Time the search started, from which its latency budget counts
+        */
+        SearchInterruption(const search_options& options, const std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Checks whether the search must stop
+         *
+         * @param reserve Time the search needs to finish once it stops, so that it stops that long before its deadline
+         * @return `true` if the search was cancelled or is (about to be) past its deadline
+        */
+        bool check(const std::chrono::nanoseconds reserve = std::chrono::nanoseconds(0));
+
+        // `true` once a check has failed
+        bool isInterrupted() const { return interrupted; }
+
+        // `true` if the search was cancelled
+        bool isCancelled() const { return cancellation && cancellation->isCancelled(); }
+
+        // `true` if the search has a deadline or a latency budget
+        bool hasDeadline() const { return deadline != std::chrono::steady_clock::time_point::max(); }
+
+        // Time at which the search must stop
+        std::chrono::steady_clock::time_point getDeadline() const { return deadline; }
+
+    private:
+        // Earliest of the deadline and the end of the latency budget
+        std::chrono::steady_clock::time_point deadline;
+        // Token through which the search may be cancelled, if any
+        const CancellationToken* cancellation;
+        // Whether a check has failed
+        bool interrupted = false;
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include "search_interruption.h"
+#include "spsc_queue.h"
+#include "tf_idf_scoring.h"
+#include <atomic>
+#include <future>
+#include <latch>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over an
+ * in-memory index, executed shared-nothing across the cores of a dedicated machine.
+ *
+ * One worker thread is pinned to each core. Every worker builds and exclusively owns a shard of the
+ * documents (so its index memory is allocated by, and local to, its core) and has its own allocator for
+ * per-query scratch space. Cores only communicate through a mesh of lock-free single-producer
+ * single-consumer queues, one per ordered pair of cores.
+ *
+ * A search is handed to one core (round robin), which fans it out to every other core, scores its own shard,
+ * and merges the local K-best returned by the other cores. Each shard stores the corpus wide document
+ * frequency of its terms, so no extra round trip is needed to compute IDFs.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops scoring on every core and ranks the
+ * documents scored so far.
+*/
+class SharedNothingTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        SharedNothingTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        SharedNothingTfIdfSearch(const SharedNothingTfIdfSearch&) = delete;
+        SharedNothingTfIdfSearch& operator= (const SharedNothingTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a SharedNothingTfIdfSearch instance, loading the corpus from the database and starting one worker per core
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param num_cores Number of cores (and shards) to use, pinned to cores 0 to num_cores - 1
+        */
+        SharedNothingTfIdfSearch(const std::string database_path, const unsigned int num_cores);
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the 
+         * transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options (only the deadline,
+         * latency budget and cancellation token of which are supported, the operators of a boolean query being ignored
+         * and its excluded terms dropped).
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        // Stop and join every worker
+        ~SharedNothingTfIdfSearch();
+
+    private:
+        // Final K-best of a search, and how its scoring stopped
+        struct search_result {
+            std::vector<scored_transcript> best_matches;
+            bool interrupted;
+            bool cancelled;
+        };
+
+        // A search in flight, owned by the core which received it
+        struct search_query {
+            std::vector<std::string> terms;
+            unsigned int k;
+            // Deadline, latency budget and cancellation token of the search (its statistics are recorded by the caller),
+            // from which each core checks for interruption on its own
+            search_options options;
+            std::chrono::steady_clock::time_point start_time;
+            // K-best of each core's shard, and whether its scoring was interrupted, each written only by that core
+            std::vector<std::vector<scored_document>> shard_results;
+            std::vector<uint8_t> shard_interrupted;
+            // Number of other cores yet to reply (only touched by the receiving core)
+            unsigned int pending_replies = 0;
+            std::promise<search_result> result;
+        };
+
+        // Message passed between two cores
+        struct core_message {
+            enum { search, reply } kind;
+            // Core which sent the message
+            unsigned int sender;
+            search_query* query;
+        };
+
+        // Everything owned by one core
+        struct core_state {
+            // Shard of the documents, and the corpus wide document frequency of each of its terms
+            std::unique_ptr<InvertedIndex> shard;
+            std::vector<uint32_t> global_document_frequencies;
+
+            // Allocator for per-query scratch space, only ever used from this core
+            std::unique_ptr<std::pmr::unsynchronized_pool_resource> allocator;
+
+            // Searches handed to this core from outside, and a lock for callers sharing the producer side
+            std::unique_ptr<SpscQueue<search_query*>> ingress;
+            std::mutex ingress_mutex;
+            // Number of searches received by this core which have not completed
+            size_t in_flight = 0;
+
+            // Messages from every core, indexed by sender
+            std::vector<std::unique_ptr<SpscQueue<core_message>>> inbound;
+
+            // Bumped on every message so an idle core can sleep until there is work
+            std::atomic<uint32_t> signal = 0;
+            std::atomic<bool> sleeping = false;
+
+            std::thread thread;
+        };
+
+        /**
+         * Searches terms, stopping early if the search is interrupted
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search, whose statistics are recorded
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void searchTerms(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Main loop of a core: builds its shard, then serves messages until stopped
+         *
+         * @param core Core id
+         * @param builder Documents of this core's shard
+         * @param global_document_frequencies Corpus wide document frequency of every term
+         * @param ready Signalled once the shard is built
+        */
+        void runCore(
+            const unsigned int core,
+            const InvertedIndexBuilder* builder,
+            const std::unordered_map<std::string, uint32_t>* global_document_frequencies,
+            std::latch* ready
+        );
+
+        /**
+         * Handles every message currently queued for a core
+         *
+         * @param core Core id
+         * @return `true` if any message was handled
+        */
+        bool pollCore(const unsigned int core);
+
+        /**
+         * Delivers a message to a core's inbound queue from another core and wakes it if needed
+         *
+         * @param target Receiving core
+         * @param message Message to send
+        */
+        void sendMessage(const unsigned int target, const core_message& message);
+
+        // Wakes a core if it is sleeping
+        void wakeCore(const unsigned int core);
+
+        /**
+         * Scores a core's own shard for a search, storing its local K-best in the search
+         *
+         * @param core Core id
+         * @param query Search to score
+        */
+        void scoreShard(const unsigned int core, search_query& query);
+
+        /**
+         * Merges the local K-best of every shard into the final result (on the receiving core)
+         *
+         * @param query Completed search, deleted by this method
+        */
+        void completeQuery(search_query* query);
+
+        // Total number of documents over all shards
+        size_t num_documents_total = 0;
+
+        // State of each core
+        std::vector<std::unique_ptr<core_state>> cores;
+
+        // Next core to receive a search from outside
+        std::atomic<unsigned int> next_receiving_core = 0;
+
+        // Set when shutting down
+        std::atomic<bool> stopping = false;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "aho_corasick.h"
+#include "forward_index.h"
+#include "transcript_search_algorithm.h"
+#include <vector>
+
+/**
+ * Extracts the windows of a transcript which best match a query, with the matches highlighted.
+ *
+ * The query's terms and phrases are patterns of an automaton over token ids, so a single pass over the
+ * transcript's forward index entry finds all of them. Windows are then chosen greedily: the window holding
+ * the most distinct patterns (then the most matches) first, and each next window among those not overlapping
+ * the windows already chosen. Each window starts a little before its first match, for context.
+ *
+ * @param forward_index Forward index holding the transcript
+ * @param document Document id of the transcript
+ * @param automaton Automaton of the query's patterns, over the forward index's token ids
+ * @param max_snippets Maximum number of windows to extract
+ * @param snippet_words Number of words in each window
+ * @return Snippets best first, or none if no pattern occurs in the transcript
+*/
+std::vector<transcript_snippet> extractSnippets(
+    const ForwardIndex& forward_index,
+    const document_id document,
+    const AhoCorasickAutomaton& automaton,
+    const unsigned int max_snippets,
+    const unsigned int snippet_words
+);
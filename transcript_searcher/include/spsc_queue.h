@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * A bounded, lock-free, single-producer single-consumer ring buffer.
+ *
+ * Exactly one thread may push and exactly one (other) thread may pop. The head and tail indexes live on
+ * separate cache lines, and each side caches its last view of the other side's index, so in the common
+ * case a push or pop touches only cache lines owned by the calling thread.
+*/
+template <typename T>
+class SpscQueue {
+    public:
+        // Remove default constructor
+        SpscQueue() = delete;
+
+        // Remove copy constructor and copy assignment
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator= (const SpscQueue&) = delete;
+
+        /**
+         * Initialize an empty SpscQueue
+         *
+         * @param capacity Maximum number of queued elements, rounded up to a power of two
+        */
+        explicit SpscQueue(const size_t capacity) {
+            size_t slots = 1;
+            while (slots < capacity) {
+                slots <<= 1;
+            }
+            elements.resize(slots);
+            mask = slots - 1;
+        }
+
+        /**
+         * Appends an element (producer thread only)
+         *
+         * @param element Element to append
+         * @return `false` if the queue is full, otherwise `true`
+        */
+        bool push(const T& element) {
+            size_t tail_index = tail.load(std::memory_order_relaxed);
+            if (tail_index - cached_head >= elements.size()) {
+                cached_head = head.load(std::memory_order_acquire);
+                if (tail_index - cached_head >= elements.size()) {
+                    return false;
+                }
+            }
+            elements[tail_index & mask] = element;
+            tail.store(tail_index + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Removes the oldest element (consumer thread only)
+         *
+         * @param element Set to the removed element
+         * @return `false` if the queue is empty, otherwise `true`
+        */
+        bool pop(T& element) {
+            size_t head_index = head.load(std::memory_order_relaxed);
+            if (head_index == cached_tail) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (head_index == cached_tail) {
+                    return false;
+                }
+            }
+            element = elements[head_index & mask];
+            head.store(head_index + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Maximum number of queued elements
+        size_t capacity() const { return elements.size(); }
+
+    private:
+        static constexpr size_t cache_line_size = 64;
+
+        // Ring buffer storage, and the mask turning an index into a slot
+        std::vector<T> elements;
+        size_t mask;
+
+        // Consumer side: index of the next element to pop, and the last tail it observed
+        alignas(cache_line_size) std::atomic<size_t> head = 0;
+        size_t cached_tail = 0;
+
+        // Producer side: index of the next slot to push to, and the last head it observed
+        alignas(cache_line_size) std::atomic<size_t> tail = 0;
+        size_t cached_head = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SQLiteConnectionPool;
+
+/**
+ * A database connection checked out of a SQLiteConnectionPool, which is returned to the pool when this goes out of scope.
+ *
+ * The connection is opened without SQLite's internal mutex, so it must only be used by the thread holding it.
+*/
+class PooledConnection {
+    public:
+        // Remove copy constructor and copy assignment
+        PooledConnection(const PooledConnection&) = delete;
+        PooledConnection& operator= (const PooledConnection&) = delete;
+
+        // Allow moving ownership of the checked out connection
+        PooledConnection(PooledConnection&& other) noexcept;
+
+        // Database connection held
+        SQLite::Database& get() { return *connection; }
+
+        // Return the connection to its pool
+        ~PooledConnection();
+
+    private:
+        friend class SQLiteConnectionPool;
+
+        PooledConnection(SQLiteConnectionPool* pool, SQLite::Database* connection);
+
+        SQLiteConnectionPool* pool;
+        SQLite::Database* connection;
+};
+
+/**
+ * A fixed size pool of read-only connections to a SQLite database, which any thread can check a connection out of.
+ *
+ * The database is switched to write-ahead logging, so readers on different connections never block each other
+ * (or the preprocessing module writing new documents), and each reader can see a consistent snapshot of
+ * the database for the duration of a read transaction.
+*/
+class SQLiteConnectionPool {
+    public:
+        // Remove default constructor
+        SQLiteConnectionPool() = delete;
+
+        // Remove copy constructor and copy assignment
+        SQLiteConnectionPool(const SQLiteConnectionPool&) = delete;
+        SQLiteConnectionPool& operator= (const SQLiteConnectionPool&) = delete;
+
+        /**
+         * Initialize a SQLiteConnectionPool, opening all of its connections
+         *
+         * @param database_path Path to database
+         * @param num_connections Number of connections in the pool
+        */
+        SQLiteConnectionPool(const std::string database_path, const unsigned int num_connections);
+
+        /**
+         * Checks a connection out of the pool, waiting for one to be returned if all are in use
+         *
+         * @return Connection which is returned to the pool when destroyed
+        */
+        PooledConnection acquire();
+
+        // Default destructor
+        ~SQLiteConnectionPool() = default;
+
+    private:
+        friend class PooledConnection;
+
+        /**
+         * Puts a connection back into the pool
+         *
+         * @param connection Connection previously checked out of the pool
+        */
+        void release(SQLite::Database* connection);
+
+        // Every connection owned by the pool
+        std::vector<std::unique_ptr<SQLite::Database>> connections;
+
+        // Connections not currently checked out, guarded by `mutex`
+        std::vector<SQLite::Database*> available_connections;
+        std::mutex mutex;
+        std::condition_variable connection_available;
+};
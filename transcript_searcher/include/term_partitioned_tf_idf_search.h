@@ -0,0 +1,156 @@
+#pragma once
+
+#include "transcript_search_algorithm.h"
+#include "inverted_index.h"
+#include "search_interruption.h"
+#include "worker_thread.h"
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * This is an implementation of a TranscriptSearchAlgorithm which utilizes the TF-IDF algorithm over an
+ * in-memory index partitioned by term.
+ *
+ * Each partition owns the posting lists of a subset of the term dictionary (plus a replica of the small
+ * per-document statistics) and is served by its own worker thread. A query is evaluated as a pipeline:
+ * a partial accumulator of document scores is created by the owner of the rarest query term and handed
+ * from owner to owner in order of increasing document frequency, each owner merging in its own terms.
+ *
+ * Every stage prunes the accumulator: with an upper bound on the score the remaining terms can still add,
+ * documents which can no longer reach the current K-th best score are dropped, and once no new document
+ * could reach it either, later stages only update documents already in the accumulator.
+ * The pruning is safe, so results match the exhaustive algorithm.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops merging postings and skips its
+ * remaining stages, ranking the documents accumulated so far.
+*/
+class TermPartitionedTfIdfSearch : public TranscriptSearchAlgorithm {
+    public:
+        // Remove default constructor
+        TermPartitionedTfIdfSearch() = delete;
+
+        // Remove copy constructor and copy assignment
+        TermPartitionedTfIdfSearch(const TermPartitionedTfIdfSearch&) = delete;
+        TermPartitionedTfIdfSearch& operator= (const TermPartitionedTfIdfSearch&) = delete;
+
+        /**
+         * Initialize a TermPartitionedTfIdfSearch instance, loading the corpus from the database
+         *
+         * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param num_partitions Number of term partitions (and worker threads)
+        */
+        TermPartitionedTfIdfSearch(const std::string database_path, const unsigned int num_partitions);
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts and stores the 
+         * transcripts and their scores in a Vector.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options (only the deadline,
+         * latency budget and cancellation token of which are supported, the operators of a boolean query being ignored
+         * and its excluded terms dropped).
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        // Default destructor
+        ~TermPartitionedTfIdfSearch() = default;
+
+    private:
+        // Where a term's posting list lives, and the statistics needed to plan and prune a query with it
+        struct term_location {
+            unsigned int partition;
+            term_id term;
+            uint32_t document_frequency;
+            double max_term_frequency;
+        };
+
+        // A partially scored document carried between pipeline stages
+        struct accumulator {
+            document_id document;
+            double score;
+        };
+
+        // One term's step of a query pipeline
+        struct pipeline_stage {
+            unsigned int partition;
+            term_id term;
+            double idf;
+            // Upper bound on this term's contribution to any document's score
+            double max_score;
+        };
+
+        // State of a query travelling through the pipeline
+        struct pipeline_query {
+            std::vector<pipeline_stage> stages;
+            size_t next_stage = 0;
+            unsigned int k;
+            // Sorted by document id
+            std::vector<accumulator> accumulators;
+            std::promise<std::vector<accumulator>> result;
+            // Checked between blocks of postings, by one stage at a time (owned by the caller waiting for the result)
+            SearchInterruption* interruption;
+        };
+
+        /**
+         * Searches terms, stopping early if the search is interrupted
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search, whose statistics are recorded
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void searchTerms(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
+        /**
+         * Runs every consecutive stage of a query owned by one partition, then forwards the query to the
+         * owner of its next stage (or completes it). Only ever called on the partition's worker thread.
+         *
+         * @param query Query to advance
+        */
+        void runStages(std::shared_ptr<pipeline_query> query);
+
+        /**
+         * Merges one term's postings into the accumulator and prunes it
+         *
+         * @param stage Stage to run
+         * @param remaining_max_score Upper bound on the score contributed by all stages after this one
+         * @param query Query being evaluated
+        */
+        void runStage(const pipeline_stage& stage, const double remaining_max_score, pipeline_query& query);
+
+        // Total number of documents in the corpus
+        size_t num_documents_total = 0;
+
+        // Broker side term dictionary, mapping each term to its owning partition
+        std::unordered_map<std::string, term_location> term_directory;
+
+        // Index of each partition, and the worker thread which owns it
+        std::vector<std::unique_ptr<InvertedIndex>> partitions;
+        std::vector<std::unique_ptr<WorkerThread>> workers;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "inverted_index.h"
+#include "search_interruption.h"
+#include "transcript_search_algorithm.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Create an alias for a document id and its score within a single InvertedIndex
+typedef std::pair<document_id, double> scored_document;
+
+/**
+ * A search term resolved against an InvertedIndex, along with its corpus IDF.
+*/
+struct weighted_term {
+    term_id term;
+    double idf;
+};
+
+/**
+ * Calculates the corpus IDF of a term (the same formula used by TfIdfTranscriptSearch).
+ *
+ * @param num_documents_total Number of documents in the corpus
+ * @param num_documents_term Number of documents the term appears in
+ * @return IDF score of the term
+*/
+double inverseDocumentFrequency(const size_t num_documents_total, const size_t num_documents_term);
+
+/**
+ * Keeps the K best scoring documents seen so far, using a K-sized minheap.
+ *
+ * Ties in score are broken in favour of the lower document id so that results are deterministic.
+*/
+class TopKDocuments {
+    public:
+        // Remove default constructor
+        TopKDocuments() = delete;
+
+        /**
+         * Initialize an empty TopKDocuments
+         *
+         * @param k Number of best documents to keep
+        */
+        explicit TopKDocuments(const unsigned int k);
+
+        /**
+         * Offers a document, keeping it if it is among the K best seen so far
+         *
+         * @param document Document id
+         * @param score Score of the document
+        */
+        void push(const document_id document, const double score);
+
+        // `true` once K documents are held, i.e. new documents must beat `getThreshold()` to get in
+        bool isFull() const { return heap.size() >= k; }
+
+        // Score of the worst document held, or zero while fewer than K documents are held
+        double getThreshold() const { return isFull() && !heap.empty() ? heap.front().second : 0.0; }
+
+        /**
+         * Retrieves the documents held, sorted best to worst
+         *
+         * @return Vector of document-score pairs
+        */
+        std::vector<scored_document> getSortedDocuments() const;
+
+    private:
+        // Number of documents to keep
+        const unsigned int k;
+        // Minheap of the best documents, worst document at the front
+        std::vector<scored_document> heap;
+};
+
+/**
+ * Sorts scored transcripts gathered from several sources (e.g. shards or segments) best to worst, and keeps the K best.
+ *
+ * Ties in score are broken by path so that results are deterministic.
+ *
+ * @param transcripts Transcript-score pairs to sort and truncate in place
+ * @param k Number of best transcripts to keep
+*/
+void keepBestTranscripts(std::vector<scored_transcript>& transcripts, const unsigned int k);
+
+/**
+ * Scores every document containing a query term, one term at a time, into a dense accumulator array
+ * and keeps the K best.
+ *
+ * Works on any index exposing the read interface of InvertedIndex (e.g. a ConcurrentInvertedIndex::Reader).
+ *
+ * @param index Index to score against
+ * @param query_terms Query terms present in the index, with their (corpus wide) IDFs
+ * @param interruption Checked between blocks of postings, the K best being kept from the sums so far once it stops
+ * @param best_documents Collects the best scoring documents
+*/
+template <typename Index>
+void scoreTermAtATime(
+    const Index& index,
+    const std::vector<weighted_term>& query_terms,
+    SearchInterruption& interruption,
+    TopKDocuments& best_documents
+) {
+    // Dense accumulator per document, plus the list of documents touched by any term
+    std::vector<double> scores(index.getNumDocuments(), 0.0);
+    std::vector<bool> touched(index.getNumDocuments(), false);
+    std::vector<document_id> candidates;
+
+    for (auto& query_term : query_terms) {
+        auto postings = index.getPostings(query_term.term);
+        for (size_t block = 0; block < postings.size() && !interruption.check(); block += interruption_check_interval) {
+            size_t end = std::min<size_t>(postings.size(), block + interruption_check_interval);
+            for (size_t p = block; p < end; p++) {
+                auto& entry = postings[p];
+                double tf = (1.0 * entry.frequency) / index.getDocumentNumTerms(entry.document);
+                scores[entry.document] += tf * query_term.idf;
+                if (!touched[entry.document]) {
+                    touched[entry.document] = true;
+                    candidates.push_back(entry.document);
+                }
+            }
+        }
+    }
+
+    for (auto document : candidates) {
+        best_documents.push(document, scores[document]);
+    }
+}
@@ -1,4 +1,8 @@
+#pragma once
+
 #include "transcript_search_algorithm.h"
+#include "sqlite_connection_pool.h"
+#include "search_interruption.h"
 #include <unordered_map>
 #include <SQLiteCpp/SQLiteCpp.h>
 
@@ -9,6 +13,13 @@
  * about the candidate transcripts as part of a distributed population of the algorithm.
  * This module serves as the front end which performs final calculations using provided search terms
  * to determine the best matching transcripts.
+ *
+ * Searches may be performed concurrently from multiple threads: each search checks a connection out of
+ * a pool of read-only connections and runs inside a single read transaction, so that the corpus size,
+ * term and document reads it makes all see one consistent snapshot of the database.
+ *
+ * A search which is cancelled, or runs past its deadline or latency budget, stops between candidate documents and
+ * ranks the documents scored so far.
 */
 class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
     public:
@@ -23,8 +34,9 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
          * Initialize a TfIdfTranscriptSearch instance
          * 
          * @param database_path Path to database which stores corpus state for this search algorithm
+         * @param num_connections Number of pooled database connections, i.e. concurrent searches (0 to use one per hardware thread)
         */
-        TfIdfTranscriptSearch(const std::string database_path);
+        TfIdfTranscriptSearch(const std::string database_path, const unsigned int num_connections = 0);
 
         /**
          * Uses search terms to determine the k-best matching transcripts and stores the 
@@ -40,13 +52,38 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
             std::vector<scored_transcript>& best_matches
         );
 
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options (only the deadline,
+         * latency budget and cancellation token of which are supported, the operators of a boolean query being ignored
+         * and its excluded terms dropped).
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
+
     private:
         /**
-         * Connects to the database which stores corpus state for the search algorithm
+         * Searches terms, stopping early if the search is interrupted
          * 
-         * @param database_path Path to database
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search, whose statistics are recorded
+         * @param best_matches Vector to store the transcript-score pairs
         */
-        void connectDatabase(const std::string database_path);
+        void searchTerms(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        );
 
         /**
          * Perform term-based preprocessing based on the input search terms
@@ -62,12 +99,16 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
          * For candidate_documents, we really just need a set, but to avoid unneccessary copying we can just form
          * the map of document-tf-idf-score that we will need in the following operation anyway.
          * 
+         * @param db Database connection of the search
          * @param search_terms Vector of terms to use in the search
+         * @param interruption Stops the preprocessing between terms
          * @param search_terms_idfs Map of term-idf score to be populated by the method
          * @param candidate_documents Map of documents-tf-idf-score to be populated by the method (score initialized to zero)
          * */
         void preprocessTermsCandidates(
+            SQLite::Database& db,
             const std::vector<std::string>& search_terms,
+            SearchInterruption& interruption,
             std::unordered_map<std::string, double>& search_terms_idfs,
             std::unordered_map<std::string, double>& candidate_documents
         );
@@ -77,12 +118,14 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
          * 
          * This is an intermediate step for TF-IDF calculation for a document
          * 
+         * @param db Database connection of the search
          * @param document Name of the document to search
          * @param search_terms Vector of all search terms
          * @param document_term_frequencies Map to populate with terms and their frequencies in this document
          * 
         */
         int getDocumentTermFrequencies(
+            SQLite::Database& db,
             const std::string& document,
             const std::vector<std::string>& search_terms,
             std::unordered_map<std::string, int>& document_term_frequencies
@@ -91,13 +134,17 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
         /**
          * Provided a list of search terms and their corpus IDF scores, calculate the sum of TF-IDF scores of all search terms over each document.
          * 
+         * @param db Database connection of the search
          * @param search_terms Vector of all search terms
          * @param search_terms_idfs Map of search terms and their corpus IDF scores
+         * @param interruption Stops the scoring between documents, the documents left unscored being dropped
          * @param candidate_documents_scores Map of candidate documents and their sum of TF-IDF scores of all search terms
         */
         void calculateTfIdfScores(
+            SQLite::Database& db,
             const std::vector<std::string>& search_terms,
             const std::unordered_map<std::string, double>& search_terms_idfs,
+            SearchInterruption& interruption,
             std::unordered_map<std::string, double>& candidate_documents_scores
         );
 
@@ -117,6 +164,6 @@ class TfIdfTranscriptSearch : public TranscriptSearchAlgorithm {
         // Default destructor
         ~TfIdfTranscriptSearch() = default;
 
-        // Unique pointer to database instance
-        std::unique_ptr<SQLite::Database> db;
+        // Pool of read-only connections to the database
+        std::unique_ptr<SQLiteConnectionPool> connection_pool;
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Persists documents indexed by the searcher to the database in the background, in the same layout the
+ * preprocessing module writes (a `documents` row, and the document appended to each of its terms' `terms` rows).
+ *
+ * Writes are queued so that indexing a document never waits on the database; each document is written in
+ * its own transaction, so a crash never leaves a document half written.
+*/
+class TranscriptDatabaseWriter {
+    public:
+        // Remove default constructor
+        TranscriptDatabaseWriter() = delete;
+
+        // Remove copy constructor and copy assignment
+        TranscriptDatabaseWriter(const TranscriptDatabaseWriter&) = delete;
+        TranscriptDatabaseWriter& operator= (const TranscriptDatabaseWriter&) = delete;
+
+        /**
+         * Initialize a TranscriptDatabaseWriter, opening a writable connection and starting its thread
+         *
+         * @param database_path Path to database which stores corpus state
+        */
+        TranscriptDatabaseWriter(const std::string database_path);
+
+        /**
+         * Queues a document to be written
+         *
+         * @param document Document and its term statistics
+         * @param normalized_transcript Normalized transcript of the document
+        */
+        void enqueue(const indexed_document& document, const std::string& normalized_transcript);
+
+        // Finish writing every queued document and stop
+        ~TranscriptDatabaseWriter();
+
+    private:
+        // A document waiting to be written
+        struct pending_document {
+            indexed_document document;
+            std::string normalized_transcript;
+        };
+
+        // Main loop of the writer thread
+        void run();
+
+        /**
+         * Writes one document and its term updates in a single transaction
+         *
+         * @param pending Document to write
+        */
+        void write(const pending_document& pending);
+
+        // Writable database connection, only used by the writer thread
+        std::unique_ptr<SQLite::Database> db;
+
+        // Documents waiting to be written, guarded by `mutex`
+        std::deque<pending_document> queue;
+        std::mutex mutex;
+        std::condition_variable queue_changed;
+        bool stopping = false;
+
+        std::thread thread;
+};
@@ -1,12 +1,159 @@
+#pragma once
+
+#include "boolean_query.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Create an alias for this frequently used type denoting a transcript's path and its score
 typedef std::pair<std::string, double> scored_transcript;
 
+/**
+ * A time window of a transcript matching a search, and its score.
+*/
+struct scored_passage {
+    // Path of the source file of the transcript
+    std::string path;
+    // Start and end of the passage within the source file, in seconds
+    double start_time;
+    double end_time;
+    // Whether the passage has a start and end (transcripts transcribed before segments were kept are a single untimed passage)
+    bool timed;
+    double score;
+};
+
+/**
+ * A window of a transcript's text showing where it matches a query.
+*/
+struct transcript_snippet {
+    // Text of the window, with any whitespace shown as plain spaces
+    std::string text;
+    // Byte range [begin, end) within `text` of each matched term or phrase
+    std::vector<std::pair<uint32_t, uint32_t>> highlights;
+};
+
+/**
+ * A term of the corpus completing a typed prefix.
+*/
+struct term_completion {
+    std::string term;
+    // Number of transcripts containing the term
+    uint32_t document_frequency;
+};
+
+/**
+ * Ways of evaluating the terms of a query, for algorithms which choose one per query.
+*/
+enum search_strategy {
+    // Let the algorithm choose
+    STRATEGY_AUTOMATIC,
+    // Accumulate every posting of every term into per-document scores
+    STRATEGY_TERM_AT_A_TIME,
+    // Go document at a time, skipping the documents whose score bound cannot reach the K-best
+    STRATEGY_WAND,
+    // Count the terms in every transcript of the forward index
+    STRATEGY_FORWARD_SCAN,
+    // Go through the postings of all terms by decreasing score contribution, stopping once the K-best are known
+    STRATEGY_SCORE_AT_A_TIME
+};
+
+// Name of each search strategy, as given on the command line and reported in statistics
+static const char* const search_strategy_names[] = {"auto", "taat", "wand", "forward", "saat"};
+
+/**
+ * Lets another thread cancel a search in progress, e.g. once a newer search makes its results useless. Searches poll
+ * it between blocks of work, so they stop shortly after it is cancelled rather than immediately.
+*/
+class CancellationToken {
+    public:
+        // Default constructor
+        CancellationToken() = default;
+
+        // Remove copy constructor and copy assignment
+        CancellationToken(const CancellationToken&) = delete;
+        CancellationToken& operator= (const CancellationToken&) = delete;
+
+        // Asks the searches holding the token to stop
+        void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+        // `true` once the token has been cancelled
+        bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<bool> cancelled = false;
+};
+
+/**
+ * Statistics of a single query, filled in by the algorithm as it works.
+*/
+struct search_statistics {
+    // Time spent extracting snippets of the results
+    std::chrono::nanoseconds snippet_duration{0};
+    // Strategy the query was evaluated with (automatic if the algorithm has a single one)
+    search_strategy strategy = STRATEGY_AUTOMATIC;
+    // `true` if the deadline or the latency budget ran out, so that the results are the best found so far rather than
+    // the K-best
+    bool approximate = false;
+    // `true` if the search was cancelled, so that the results are incomplete
+    bool cancelled = false;
+};
+
+/**
+ * Statistics of the buffer pool through which an algorithm reads its index from disk, since it was created.
+*/
+struct buffer_pool_statistics {
+    // Number of pages of the pool, and of those holding a block
+    size_t num_pages = 0;
+    size_t resident_pages = 0;
+    // Requests for a block found in the pool (or already being read into it), and requests which had to read theirs
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Blocks dropped from the pool to make room for others
+    uint64_t evictions = 0;
+    // Blocks read ahead of any request, following a miss
+    uint64_t readahead_blocks = 0;
+};
+
+/**
+ * Per-query options of a search. Algorithms ignore the options they do not support.
+*/
+struct search_options {
+    // Weight of the proximity boost, which favours transcripts where the query terms appear close together (0 to disable)
+    double proximity_boost = 0.0;
+    // Maximum number of snippets to extract per result
+    unsigned int max_snippets = 1;
+    // Number of words in each snippet
+    unsigned int snippet_words = 16;
+    // Largest edit distance at which a search term matches a mis-spelled term (0 for exact matching only)
+    unsigned int max_edit_distance = 0;
+    // Whether a search word also matches the terms which sound like it
+    bool phonetic = false;
+    // Strategy to evaluate the query with, overriding the algorithm's choice (for benchmarking)
+    search_strategy strategy = STRATEGY_AUTOMATIC;
+    // Time after which the search returns the best results found so far, flagged as approximate in its statistics
+    // (0 for no limit). Algorithms which cannot stop early ignore it.
+    std::chrono::microseconds latency_budget{0};
+    // Time at which the search returns the best results found so far, like at the end of its latency budget (whichever
+    // comes first), e.g. to count the time a request waited before being searched
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Token through which the search may be cancelled, after which it returns early with incomplete results (if any)
+    const CancellationToken* cancellation = nullptr;
+    // Width (8 or 16 bits) of the quantized impacts term at a time adds up to rank documents, instead of exact
+    // contributions (0 for exact ranking). The K-best by impact are still reported with their exact scores.
+    unsigned int impact_bits = 0;
+    // Where to record statistics of the query, if anywhere
+    search_statistics* statistics = nullptr;
+};
+
 /**
  * Abstract base class for a TranscriptSearchAlgorithm, which must provide an implementation capable
  * of using search terms to produce the k-best matches in a corpus of transcripts.
+ *
+ * Implementations must be safe to call concurrently from several threads (searches, snippets, completions and live
+ * indexing alike), e.g. by a batch of queries or by a server indexing documents while it searches.
 */
 class TranscriptSearchAlgorithm {
     public:
@@ -32,4 +179,132 @@ class TranscriptSearchAlgorithm {
             const unsigned int k,
             std::vector<scored_transcript>& best_matches
         ) = 0;
+
+        /**
+         * Uses search terms to determine the k-best matching transcripts under the given options.
+         * 
+         * Defaults to ignoring the options, for algorithms which do not support any, and to searching only the terms of
+         * a boolean query which are not excluded, ignoring its operators, for algorithms which do not support those.
+         * 
+         * @param search_terms Vector of terms (or a boolean query) to use in the search
+         * @param k Number of best matches to return
+         * @param options Options of the search
+         * @param best_matches Vector to store the transcript-score pairs
+        */
+        virtual void getBestTranscriptMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_transcript>& best_matches
+        ) {
+            getBestTranscriptMatches(getIncludedTerms(search_terms), k, best_matches);
+        }
+
+        /**
+         * Determines the k-best matching transcripts of each of many queries, e.g. to tag the whole corpus against a
+         * list of topics, which algorithms may evaluate together rather than one by one.
+         *
+         * Defaults to searching the queries one by one, on the calling thread, for algorithms which are not safe to
+         * search from several threads. Per-query statistics are not recorded.
+         *
+         * @param queries Search terms (or a boolean query) of each query
+         * @param k Number of best matches to return per query
+         * @param options Options of every search
+         * @param num_threads Number of threads to search on (0 to use one per hardware thread)
+         * @param best_matches Set to the transcript-score pairs of each query, in the order of `queries`
+        */
+        virtual void getBatchTranscriptMatches(
+            const std::vector<std::vector<std::string>>& queries,
+            const unsigned int k,
+            const search_options& options,
+            const unsigned int num_threads,
+            std::vector<std::vector<scored_transcript>>& best_matches
+        ) {
+            search_options query_options = options;
+            query_options.statistics = nullptr;
+            best_matches.assign(queries.size(), {});
+            for (size_t q = 0; q < queries.size(); q++) {
+                getBestTranscriptMatches(queries[q], k, query_options, best_matches[q]);
+            }
+        }
+
+        /**
+         * Uses search terms to determine the k-best matching passages (time windows of transcripts), at most one per
+         * transcript, so that results can point to the right moment of long recordings.
+         * 
+         * Defaults to no passages, for algorithms which only index whole transcripts.
+         * 
+         * @param search_terms Vector of terms to use in the search
+         * @param k Number of best passages to return
+         * @param options Options of the search
+         * @param best_passages Vector to store the scored passages, best first
+        */
+        virtual void getBestPassageMatches(
+            const std::vector<std::string>& search_terms,
+            const unsigned int k,
+            const search_options& options,
+            std::vector<scored_passage>& best_passages
+        ) {
+            best_passages.clear();
+        }
+
+        /**
+         * Extracts, for each of a query's results, the windows of its transcript which best match the query,
+         * with the matching terms highlighted. Only meant to be run on the final (few) results of a search.
+         * 
+         * Defaults to no snippets, for algorithms which do not keep transcripts.
+         * 
+         * @param search_terms Vector of terms used in the search
+         * @param best_matches Results of the search
+         * @param options Options of the search
+         * @param snippets Set to the snippets of each result, best first
+        */
+        virtual void getTranscriptSnippets(
+            const std::vector<std::string>& search_terms,
+            const std::vector<scored_transcript>& best_matches,
+            const search_options& options,
+            std::vector<std::vector<transcript_snippet>>& snippets
+        ) {
+            snippets.assign(best_matches.size(), {});
+        }
+
+        /**
+         * Completes the last word of a user's partially typed search to the corpus' most frequent terms starting with it,
+         * e.g. to suggest terms as the user types.
+         * 
+         * Defaults to no completions, for algorithms which do not keep a term dictionary.
+         * 
+         * @param prefix Text typed so far
+         * @param n Number of completions wanted
+         * @param completions Set to the completions, most frequent first
+        */
+        virtual void getCompletions(const std::string& prefix, const unsigned int n, std::vector<term_completion>& completions) {
+            completions.clear();
+        }
+
+        /**
+         * Whether the algorithm searches passages, rather than leaving `getBestPassageMatches` without results.
+         * 
+         * @return `true` if the algorithm indexes the timed passages of transcripts, otherwise `false`
+        */
+        virtual bool searchesPassages() const { return false; }
+
+        /**
+         * Retrieves the statistics of the buffer pool through which the algorithm reads its index.
+         * 
+         * Defaults to none, for algorithms which keep their index in memory.
+         * 
+         * @param statistics Set to the statistics of the buffer pool
+         * @return `true` if the algorithm has a buffer pool, otherwise `false`
+        */
+        virtual bool getBufferPoolStatistics(buffer_pool_statistics& statistics) { return false; }
+
+        /**
+         * Adds a newly transcribed document to the corpus, for algorithms which support live indexing.
+         * 
+         * @param path Unique path of the source file of the transcript
+         * @param transcript Raw text transcript of the source file
+         * @return `true` if the document was indexed, `false` if it is already indexed or live indexing is unsupported
+        */
+        virtual bool indexDocument(const std::string& path, const std::string& transcript) { return false; }
 };
\ No newline at end of file
@@ -1,8 +1,12 @@
+#pragma once
+
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <SQLiteCpp/SQLiteCpp.h>
 #include "tf_idf_transcript_search.h"
+#include "buffer_pool.h"
+#include "index_warmup.h"
 #include <chrono>
 
 /**
@@ -26,12 +30,20 @@ class TranscriptSearcher {
          * @param search_algorithm Algorithm to be used for searching transcripts
          * @param max_search_terms Maximum number of terms allowed for a user to search for at once
          * @param num_best_results Number of top-scoring results to return to the user
+         * @param options Options applied to every search
+         * @param show_passages Whether to search for the best passage of each transcript, showing its time
+         * @param pool_options Buffer pool of algorithms reading their index from disk
+         * @param warmup_options Warm-up of the memory mapped index files of the algorithm
         */
         TranscriptSearcher(
             const std::string database_path,
             const std::string search_algorithm = "tf-idf",
             const unsigned int max_search_terms = 5,
-            const unsigned int num_best_results = 3
+            const unsigned int num_best_results = 3,
+            const search_options options = search_options(),
+            const bool show_passages = false,
+            const buffer_pool_options pool_options = buffer_pool_options(),
+            const index_warmup_options warmup_options = index_warmup_options()
         );
 
         /**
@@ -40,6 +52,60 @@ class TranscriptSearcher {
          * Prompts user for input, feeds it to the search algorithm, and presents the user with results. 
         */
         void runSearch();
+
+        /**
+         * Searches every query of a file at once, e.g. to tag the corpus against a list of topics, and prints the
+         * `num_best_results` results of each as tab separated lines of query line number, score and path.
+         *
+         * Queries are written one per line like interactive searches, with no limit on their number of terms, and
+         * are evaluated together where the search algorithm supports it (see getBatchTranscriptMatches).
+         *
+         * @param queries_path Path of the file of queries
+         * @param num_threads Number of threads to search on (0 to use one per hardware thread)
+        */
+        void runTagging(const std::string& queries_path, const unsigned int num_threads);
+
+        /**
+         * Runs every query of a JSON Lines file on several threads, e.g. for nightly evaluations and load tests, and
+         * prints the results of each as a line of JSON, in the order of the file, then a summary of the run on stderr.
+         *
+         * Each line is an object with the query's `terms` (an array of terms, or a string split like an interactive
+         * search), and optionally its `k` (`num_best_results` by default) and any of `proximity_boost`, `snippets`,
+         * `snippet_words`, `fuzzy`, `phonetic`, `strategy`, `latency_budget` (in microseconds) and `impact_bits`,
+         * overriding the searcher's options. Each result line has the query's line number, its results (with their
+         * snippets, and passage times if searching passages), its timings in microseconds, and its statistics. A line
+         * which cannot be searched gets a result line with an `error` instead.
+         *
+         * @param queries_path Path of the JSON Lines file of queries
+         * @param num_threads Number of threads to search on (0 to use one per hardware thread)
+        */
+        void runBatch(const std::string& queries_path, const unsigned int num_threads);
+
+        /**
+         * Creates the TranscriptSearchAlgorithm registered under a given name
+         *
+         * @param search_algorithm Name of the algorithm ("tf-idf", "tf-idf-document-partitioned", "tf-idf-term-partitioned", "tf-idf-shared-nothing", "tf-idf-realtime", "tf-idf-memory", "tf-idf-passages" or "tf-idf-disk")
+         * @param database_path Path to database which stores corpus state for the algorithm
+         * @param num_partitions Number of partitions (or cores) for partitioned algorithms, or of worker threads for "tf-idf-disk" (0 to use one per hardware thread)
+         * @param pool_options Buffer pool of algorithms reading their index from disk ("tf-idf-disk")
+         * @param warmup_options Warm-up of the memory mapped index files of the algorithm ("tf-idf-memory" and "tf-idf-disk")
+         * @return Newly allocated algorithm, owned by the caller
+        */
+        static TranscriptSearchAlgorithm* createSearchAlgorithm(
+            const std::string search_algorithm,
+            const std::string database_path,
+            const unsigned int num_partitions = 0,
+            const buffer_pool_options& pool_options = buffer_pool_options(),
+            const index_warmup_options& warmup_options = index_warmup_options()
+        );
+
+        /**
+         * Parses the name of a search strategy, as listed in `search_strategy_names`
+         *
+         * @param name Name of the strategy ("auto", "taat", "wand", "forward" or "saat")
+         * @return The strategy of that name
+        */
+        static search_strategy parseSearchStrategy(const std::string& name);
         
         // Default destructor
         ~TranscriptSearcher() = default;
@@ -55,6 +121,9 @@ class TranscriptSearcher {
         /**
          * Prompts user to enter search terms, retrieves them, and stores them in `search_terms`
          * 
+         * Terms are separated by whitespace, and a phrase can be entered as a single term by quoting it. Terms may be
+         * combined with `AND`, `OR`, `NOT`, parentheses and `-term` exclusions (see boolean_query).
+         * 
          * @param search_terms Vector to be updated with individual search terms as elements
          * @return `true` if valid input was provided, otherwise `false`
         */
@@ -64,17 +133,37 @@ class TranscriptSearcher {
          * Formats and outputs the results for the user.
          * 
          * @param result Vector of scored transcripts, ordered by score
+         * @param passages Best passage of each scored transcript, if passages were searched
+         * @param snippets Snippets of each scored transcript
          * @param duration_ns Execution time (in nanoseconds) of the search
+         * @param statistics Statistics of the search
         */
         void outputResult(
             const std::vector<scored_transcript>& result,
-            const std::chrono::nanoseconds duration_ns
+            const std::vector<scored_passage>& passages,
+            const std::vector<std::vector<transcript_snippet>>& snippets,
+            const std::chrono::nanoseconds duration_ns,
+            const search_statistics& statistics
         );
 
+        /**
+         * Runs a query of a batch (see runBatch) and formats its result line
+         *
+         * @param line Query, as a JSON object
+         * @param line_number Line number of the query in its file
+         * @param duration_ns Set to the execution time (in nanoseconds) of the search, if the query is valid
+         * @return Result line, as a JSON object (with an `error` if the query is not valid)
+        */
+        std::string runBatchQuery(const std::string& line, const size_t line_number, std::chrono::nanoseconds& duration_ns);
+
         // Maximum number of terms the transcript searcher will accept
         const unsigned int max_search_terms;
         // Number of top results that should be displayed to the user
         const unsigned int num_best_results;
+        // Options applied to every search
+        const search_options options;
+        // Whether searches are for passages rather than whole transcripts
+        const bool show_passages;
 
         // Base pointer to a TranscriptSearchAlgorithm implementation
         TranscriptSearchAlgorithm* transcript_search_algorithm = nullptr;
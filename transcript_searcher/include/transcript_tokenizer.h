@@ -0,0 +1,75 @@
+#pragma once
+
+#include "inverted_index.h"
+#include <string>
+#include <vector>
+
+/**
+ * Turns raw transcripts into terms exactly the way the preprocessing module does: ASCII punctuation is removed,
+ * text is lowercased, split on whitespace, and (for term counting) English stop words are dropped.
+ *
+ * Transcripts are UTF-8, lowercased and split like Python's str.lower() and str.split() do (e.g. "É" becomes "é",
+ * and a non-breaking space separates words), from tables of Unicode 14.0, the version of Python 3.11. Bytes which
+ * are not valid UTF-8 are kept as they are.
+ *
+ * Lets the searcher index transcripts itself, with statistics identical to those stored in the database.
+*/
+class TranscriptTokenizer {
+    public:
+        // Remove default constructor, all methods are static
+        TranscriptTokenizer() = delete;
+
+        /**
+         * Removes punctuation and lowercases a transcript (the form in which transcripts are stored in the database)
+         *
+         * @param transcript Raw transcript
+         * @return Normalized transcript
+        */
+        static std::string normalize(const std::string& transcript);
+
+        /**
+         * Splits a normalized transcript into its tokens, stop words included
+         *
+         * @param normalized_transcript Normalized transcript
+         * @return Tokens in order of appearance
+        */
+        static std::vector<std::string> tokenize(const std::string& normalized_transcript);
+
+        /**
+         * Splits a normalized transcript into its tokens, stop words included, recording where each one starts
+         *
+         * @param normalized_transcript Normalized transcript
+         * @param tokens Set to the tokens in order of appearance
+         * @param offsets Set to the byte offset of each token in the transcript
+        */
+        static void tokenize(
+            const std::string& normalized_transcript,
+            std::vector<std::string>& tokens,
+            std::vector<uint32_t>& offsets
+        );
+
+        /**
+         * Whether a text contains whitespace, as tokens are split on (e.g. whether a search term is a phrase)
+         *
+         * @param text Text to check
+         * @return `true` if the text contains whitespace, otherwise `false`
+        */
+        static bool hasWhitespace(const std::string& text);
+
+        /**
+         * Whether a token is an English stop word, which is not counted as a term
+         *
+         * @param token Token to check
+         * @return `true` if the token is a stop word, otherwise `false`
+        */
+        static bool isStopWord(const std::string& token);
+
+        /**
+         * Counts the terms of a normalized transcript
+         *
+         * @param path Unique path of the source file of the transcript
+         * @param normalized_transcript Normalized transcript
+         * @return Document with each term's frequency and positions, in order of first appearance
+        */
+        static indexed_document countTerms(const std::string& path, const std::string& normalized_transcript);
+};
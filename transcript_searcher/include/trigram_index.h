@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+ * Finds the strings of a collection (e.g. the terms of a dictionary, or the paths of the transcripts) containing
+ * a substring, without scanning the collection.
+ *
+ * Every string is indexed under each distinct trigram (three consecutive characters) it contains, so a string
+ * containing the substring must appear in the lists of all of the substring's trigrams. Lookups intersect those
+ * lists rarest first, galloping through the longer ones, and only verify the strings left. Matching ignores case.
+ *
+ * Lists are laid out like posting lists: the sorted distinct trigrams, and their lists of string ids back to back.
+*/
+class TrigramIndex {
+    public:
+        // Remove default constructor
+        TrigramIndex() = delete;
+
+        // Remove copy constructor and copy assignment
+        TrigramIndex(const TrigramIndex&) = delete;
+        TrigramIndex& operator= (const TrigramIndex&) = delete;
+
+        /**
+         * Initialize a TrigramIndex over a collection of strings
+         *
+         * @param num_strings Number of strings, with ids 0 to `num_strings - 1`
+         * @param get_string Accessor of the string of an id, which must stay valid as long as the index is used
+        */
+        TrigramIndex(const size_t num_strings, std::function<std::string_view(uint32_t)> get_string);
+
+        /**
+         * Finds the strings containing a substring
+         *
+         * @param substring Substring of at least 3 characters to look for (shorter ones match nothing)
+         * @param matches Set to the ids of the matching strings, in increasing order
+        */
+        void findSubstring(std::string_view substring, std::vector<uint32_t>& matches) const;
+
+        // Number of distinct trigrams indexed
+        size_t getNumTrigrams() const { return trigrams.size(); }
+
+    private:
+        // Accessor of the indexed strings
+        std::function<std::string_view(uint32_t)> get_string;
+
+        // Sorted distinct trigrams, each packed in the low 24 bits of an integer
+        std::vector<uint32_t> trigrams;
+        // Offset of each trigram's list in `string_ids`, plus a trailing end offset
+        std::vector<uint64_t> offsets;
+        // Ids of the strings containing each trigram, in increasing order, back to back
+        std::vector<uint32_t> string_ids;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Variable length integer coding (LEB128): 7 bits per byte, high bit set on every byte but the last.
+ * Small values, such as the gaps between sorted positions, take a single byte.
+*/
+
+/**
+ * Appends an integer to a byte buffer
+ *
+ * @param value Integer to encode
+ * @param bytes Buffer to append to
+*/
+inline void encodeVarint(uint32_t value, std::vector<uint8_t>& bytes) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * Reads an integer from a byte buffer, advancing the read pointer past it
+ *
+ * @param bytes Read pointer
+ * @return Decoded integer
+*/
+inline uint32_t decodeVarint(const uint8_t*& bytes) {
+    uint32_t value = 0;
+    unsigned int shift = 0;
+    while (*bytes & 0x80) {
+        value |= static_cast<uint32_t>(*bytes++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<uint32_t>(*bytes++) << shift;
+    return value;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * A long-lived thread which runs submitted tasks one at a time, in submission order.
+ *
+ * Used by the partitioned search algorithms so that each partition of the index is only ever
+ * touched by the thread which owns it.
+*/
+class WorkerThread {
+    public:
+        // Start the thread
+        WorkerThread();
+
+        // Remove copy constructor and copy assignment
+        WorkerThread(const WorkerThread&) = delete;
+        WorkerThread& operator= (const WorkerThread&) = delete;
+
+        /**
+         * Queues a task to be run on this worker's thread
+         *
+         * @param task Task to run
+        */
+        void submit(std::function<void()> task);
+
+        // Finish queued tasks and join the thread
+        ~WorkerThread();
+
+    private:
+        // Main loop of the thread
+        void run();
+
+        // Tasks waiting to be run, guarded by `mutex`
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable tasks_available;
+        bool stopping = false;
+
+        std::thread thread;
+};
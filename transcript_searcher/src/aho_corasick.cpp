@@ -0,0 +1,78 @@
+#include "aho_corasick.h"
+#include <algorithm>
+#include <deque>
+
+AhoCorasickAutomaton::AhoCorasickAutomaton() : nodes(1) {}
+
+uint32_t AhoCorasickAutomaton::findChild(const uint32_t state, const uint32_t symbol) const {
+    auto& children = nodes[state].children;
+    auto it = std::lower_bound(children.begin(), children.end(), symbol, [](const std::pair<uint32_t, uint32_t>& child, uint32_t value) {
+        return child.first < value;
+    });
+    return (it != children.end() && it->first == symbol) ? it->second : 0;
+}
+
+void AhoCorasickAutomaton::addPattern(const std::vector<uint32_t>& symbols, const uint32_t pattern) {
+    if (symbols.empty()) {
+        return;
+    }
+
+    // Walk down the trie, adding the nodes that are missing
+    uint32_t state = 0;
+    for (auto symbol : symbols) {
+        uint32_t child = findChild(state, symbol);
+        if (child == 0) {
+            child = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            nodes[child].depth = nodes[state].depth + 1;
+            auto& children = nodes[state].children;
+            auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(symbol, 0u));
+            children.insert(it, {symbol, child});
+        }
+        state = child;
+    }
+    nodes[state].is_pattern = true;
+    nodes[state].pattern = pattern;
+}
+
+uint32_t AhoCorasickAutomaton::step(uint32_t state, const uint32_t symbol) const {
+    while (true) {
+        uint32_t child = findChild(state, symbol);
+        if (child != 0 || state == 0) {
+            return child;
+        }
+        state = nodes[state].failure;
+    }
+}
+
+void AhoCorasickAutomaton::build() {
+    // Breadth first, so every shallower node's links are final before they are used
+    std::deque<uint32_t> queue;
+    for (auto& [symbol, child] : nodes[0].children) {
+        nodes[child].failure = 0;
+        queue.push_back(child);
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        for (auto& [symbol, child] : nodes[state].children) {
+            uint32_t failure = step(nodes[state].failure, symbol);
+            nodes[child].failure = failure;
+            nodes[child].output_link = nodes[failure].is_pattern ? failure : nodes[failure].output_link;
+            queue.push_back(child);
+        }
+    }
+}
+
+void AhoCorasickAutomaton::findMatches(std::span<const uint32_t> text, std::vector<pattern_match>& matches) const {
+    matches.clear();
+    uint32_t state = 0;
+    for (uint32_t position = 0; position < text.size(); position++) {
+        state = step(state, text[position]);
+
+        // Report the pattern ending here, and every shorter pattern which is a suffix of it
+        for (uint32_t output = nodes[state].is_pattern ? state : nodes[state].output_link; output != 0; output = nodes[output].output_link) {
+            matches.push_back({position + 1 - nodes[output].depth, nodes[output].depth, nodes[output].pattern});
+        }
+    }
+}
@@ -0,0 +1,321 @@
+#include "async_file_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Number of entries of the io_uring's submission queue, one of which is kept for waking the completion thread
+static const unsigned io_uring_entries = 256;
+
+// Reads a byte range in as many `pread` calls as it takes, returning the number of bytes read or minus the error number
+static ssize_t readFully(const int descriptor, void* buffer, const size_t size, const uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t result = pread(descriptor, static_cast<char*>(buffer) + done, size - done, static_cast<off_t>(offset + done));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+static int ioUringSetup(const unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(const int ring, const unsigned to_submit, const unsigned min_complete, const unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+}
+
+AsyncFileReader::AsyncFileReader(
+    const std::string& path,
+    CoroutineScheduler& scheduler,
+    const unsigned int num_io_threads,
+    const bool use_io_uring,
+    const bool direct_io
+) : path(path), scheduler(scheduler) {
+    descriptor = open(path.c_str(), direct_io ? O_RDONLY | O_DIRECT : O_RDONLY);
+    if (descriptor < 0 && direct_io && errno == EINVAL) {
+        throw std::runtime_error("Error: the file system of \"" + path + "\" does not support direct reads\n");
+    }
+    if (descriptor < 0) {
+        throw std::runtime_error("Error: unable to open \"" + path + "\"\n");
+    }
+
+    if (use_io_uring && setUpRing()) {
+        threads.emplace_back(&AsyncFileReader::reapCompletions, this);
+    } else {
+        for (unsigned int t = 0; t < std::max(1u, num_io_threads); t++) {
+            threads.emplace_back(&AsyncFileReader::serveReads, this);
+        }
+    }
+}
+
+bool AsyncFileReader::setUpRing() {
+    io_uring_params params = {};
+    int ring = ioUringSetup(io_uring_entries, &params);
+    if (ring < 0) {
+        return false;
+    }
+
+    // Reads need IORING_OP_READ, which came with the reads from the current position (Linux 5.6), and the completion
+    // queue must hold a completion for every submission
+    if (!(params.features & IORING_FEAT_RW_CUR_POS) || params.cq_entries < params.sq_entries) {
+        close(ring);
+        return false;
+    }
+
+    submission_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    completion_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mapping) {
+        submission_ring_size = completion_ring_size = std::max(submission_ring_size, completion_ring_size);
+    }
+    submission_ring = mmap(nullptr, submission_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    if (submission_ring == MAP_FAILED) {
+        submission_ring = nullptr;
+        close(ring);
+        return false;
+    }
+    completion_ring = single_mapping ? submission_ring
+        : mmap(nullptr, completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+    submission_entries_size = params.sq_entries * sizeof(io_uring_sqe);
+    submission_entries = completion_ring == MAP_FAILED ? MAP_FAILED
+        : mmap(nullptr, submission_entries_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (completion_ring == MAP_FAILED || submission_entries == MAP_FAILED) {
+        if (completion_ring != MAP_FAILED && completion_ring != submission_ring) {
+            munmap(completion_ring, completion_ring_size);
+        }
+        munmap(submission_ring, submission_ring_size);
+        submission_ring = completion_ring = submission_entries = nullptr;
+        close(ring);
+        return false;
+    }
+
+    auto* submission_base = static_cast<char*>(submission_ring);
+    submission_tail = reinterpret_cast<unsigned*>(submission_base + params.sq_off.tail);
+    submission_mask = *reinterpret_cast<unsigned*>(submission_base + params.sq_off.ring_mask);
+    submission_array = reinterpret_cast<unsigned*>(submission_base + params.sq_off.array);
+    auto* completion_base = static_cast<char*>(completion_ring);
+    completion_head = reinterpret_cast<unsigned*>(completion_base + params.cq_off.head);
+    completion_tail = reinterpret_cast<unsigned*>(completion_base + params.cq_off.tail);
+    completion_mask = *reinterpret_cast<unsigned*>(completion_base + params.cq_off.ring_mask);
+    completions = completion_base + params.cq_off.cqes;
+    ring_entries = params.sq_entries;
+    ring_descriptor = ring;
+    return true;
+}
+
+size_t AsyncFileReader::read_awaiter::await_resume() const {
+    if (request.result < 0) {
+        throw std::runtime_error("Error: unable to read \"" + reader.getPath() + "\"\n");
+    }
+    return static_cast<size_t>(request.result);
+}
+
+void AsyncFileReader::submit(read_request* request) {
+    if (usesIoUring()) {
+        std::vector<read_request*> failed;
+        {
+            std::lock_guard<std::mutex> lock(submit_mutex);
+            if (ring_error != 0) {
+                request->result = -ring_error;
+                failed.push_back(request);
+            } else if (in_flight + 1 < ring_entries) {
+                in_flight++;
+                submitToRing(request, failed);
+            } else {
+                overflow.push_back(request);
+            }
+        }
+        for (auto* failed_request : failed) {
+            scheduler.resume(failed_request->handle);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(request);
+    }
+    requests_available.notify_one();
+}
+
+bool AsyncFileReader::pushSubmission(read_request* request) {
+    unsigned tail = *submission_tail;
+    unsigned index = tail & submission_mask;
+    auto& entry = static_cast<io_uring_sqe*>(submission_entries)[index];
+    entry = {};
+    if (request) {
+        entry.opcode = IORING_OP_READ;
+        entry.fd = descriptor;
+        entry.off = request->offset + request->done;
+        entry.addr = reinterpret_cast<uint64_t>(static_cast<char*>(request->buffer) + request->done);
+        entry.len = static_cast<uint32_t>(request->size - request->done);
+    } else {
+        entry.opcode = IORING_OP_NOP;
+    }
+    entry.user_data = reinterpret_cast<uint64_t>(request);
+    submission_array[index] = index;
+    __atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+    // The kernel takes the entry off the queue within the call, unless it is interrupted first
+    int submitted;
+    do {
+        submitted = ioUringEnter(ring_descriptor, 1, 0, 0);
+    } while (submitted < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+    if (submitted < 0) {
+        // The kernel only reads the queue within the call, so the entry can be taken back
+        int error = errno;
+        __atomic_store_n(submission_tail, tail, __ATOMIC_RELEASE);
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+void AsyncFileReader::submitToRing(read_request* request, std::vector<read_request*>& failed) {
+    if (pushSubmission(request)) {
+        submitted.insert(request);
+        return;
+    }
+    request->result = -errno;
+    submitted.erase(request);
+    in_flight--;
+    failed.push_back(request);
+}
+
+void AsyncFileReader::reapCompletions() {
+    std::vector<read_request*> completed;
+    std::vector<read_request*> partial;
+    bool woken = false;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(submit_mutex);
+            if (woken && in_flight == 0 && overflow.empty()) {
+                return;
+            }
+        }
+        int result = ioUringEnter(ring_descriptor, 0, 1, IORING_ENTER_GETEVENTS);
+        if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            // Completions can no longer be waited for: fail every read left, and any read submitted from now on
+            int error = errno;
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex);
+                ring_error = error;
+                completed.assign(submitted.begin(), submitted.end());
+                completed.insert(completed.end(), overflow.begin(), overflow.end());
+                submitted.clear();
+                overflow.clear();
+                in_flight = 0;
+            }
+            for (auto* request : completed) {
+                request->result = -error;
+                scheduler.resume(request->handle);
+            }
+            return;
+        }
+
+        unsigned head = *completion_head;
+        unsigned tail = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            auto& completion = static_cast<io_uring_cqe*>(completions)[head & completion_mask];
+            auto* request = reinterpret_cast<read_request*>(completion.user_data);
+            if (!request) {
+                woken = true;
+            } else if (completion.res > 0 && request->done + completion.res < request->size) {
+                // A short read, not at the end of the file until a read of the rest returns nothing
+                request->done += completion.res;
+                partial.push_back(request);
+            } else {
+                request->result = completion.res < 0 ? completion.res : static_cast<ssize_t>(request->done + completion.res);
+                completed.push_back(request);
+            }
+        }
+        __atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+
+        // Submit the rest of the short reads, which keep their room, and make room for the reads which did not fit,
+        // before resuming any coroutine (which may submit more)
+        {
+            std::lock_guard<std::mutex> lock(submit_mutex);
+            for (auto* request : completed) {
+                submitted.erase(request);
+            }
+            in_flight -= static_cast<unsigned>(completed.size());
+            for (auto* request : partial) {
+                submitToRing(request, completed);
+            }
+            while (!overflow.empty() && in_flight + 1 < ring_entries) {
+                in_flight++;
+                submitToRing(overflow.front(), completed);
+                overflow.pop_front();
+            }
+        }
+        partial.clear();
+        for (auto* request : completed) {
+            scheduler.resume(request->handle);
+        }
+        completed.clear();
+    }
+}
+
+void AsyncFileReader::serveReads() {
+    while (true) {
+        read_request* request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requests_available.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (requests.empty()) {
+                // Stopping and nothing left to do
+                return;
+            }
+            request = requests.front();
+            requests.pop_front();
+        }
+        request->result = readFully(descriptor, request->buffer, request->size, request->offset);
+        scheduler.resume(request->handle);
+    }
+}
+
+AsyncFileReader::~AsyncFileReader() {
+    if (usesIoUring()) {
+        // A no-op completion wakes the completion thread, which stops once no read is left in flight (unless it
+        // already stopped on an error)
+        while (true) {
+            std::lock_guard<std::mutex> lock(submit_mutex);
+            if (ring_error != 0 || pushSubmission(nullptr)) {
+                break;
+            }
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        requests_available.notify_all();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (usesIoUring()) {
+        munmap(submission_entries, submission_entries_size);
+        if (completion_ring != submission_ring) {
+            munmap(completion_ring, completion_ring_size);
+        }
+        munmap(submission_ring, submission_ring_size);
+        close(ring_descriptor);
+    }
+    close(descriptor);
+}
@@ -0,0 +1,588 @@
+#include "transcript_searcher.h"
+#include "boolean_query.h"
+#include "inverted_index.h"
+#include "concurrent_inverted_index.h"
+#include "completion_trie.h"
+#include "transcript_tokenizer.h"
+#include "tf_idf_scoring.h"
+#include "argparse/argparse.hpp"
+#include "rapidjson/document.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+#ifndef PROJECT_BASE_DIR
+    #define PROJECT_BASE_DIR "../../"
+#endif
+
+/**
+ * Samples benchmark queries from the corpus itself: each query is 1 to `max_query_terms` terms
+ * drawn from the term list of a randomly chosen document, so queries mix common and rare terms
+ * the way real searches for a remembered video do.
+*/
+static std::vector<std::vector<std::string>> sampleQueries(
+    const std::string& database_path,
+    const unsigned int num_queries,
+    const unsigned int max_query_terms
+) {
+    std::mt19937 generator(42);
+
+    // Reservoir sample `num_queries` documents
+    std::vector<std::vector<std::string>> sampled_terms;
+    size_t num_documents = 0;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        num_documents++;
+        std::vector<std::string> document_terms;
+        for (auto& [term, frequency] : document.term_frequencies) {
+            document_terms.push_back(term);
+        }
+        if (sampled_terms.size() < num_queries) {
+            sampled_terms.push_back(std::move(document_terms));
+        } else {
+            size_t slot = std::uniform_int_distribution<size_t>(0, num_documents - 1)(generator);
+            if (slot < num_queries) {
+                sampled_terms[slot] = std::move(document_terms);
+            }
+        }
+    });
+
+    std::vector<std::vector<std::string>> queries;
+    while (!sampled_terms.empty() && queries.size() < num_queries) {
+        auto& document_terms = sampled_terms[queries.size() % sampled_terms.size()];
+        if (document_terms.empty()) {
+            queries.push_back({});
+            continue;
+        }
+        std::shuffle(document_terms.begin(), document_terms.end(), generator);
+        size_t num_terms = std::uniform_int_distribution<size_t>(1, max_query_terms)(generator);
+        num_terms = std::min(num_terms, document_terms.size());
+        queries.emplace_back(document_terms.begin(), document_terms.begin() + num_terms);
+    }
+    return queries;
+}
+
+// Reads queries from a file with one whitespace separated query per line
+static std::vector<std::vector<std::string>> readQueries(const std::string& queries_path) {
+    std::ifstream queries_file(queries_path);
+    if (!queries_file) {
+        throw std::runtime_error("Error: could not open queries file \"" + queries_path + "\"\n");
+    }
+    std::vector<std::vector<std::string>> queries;
+    std::string line;
+    while (std::getline(queries_file, line)) {
+        std::stringstream line_ss(line);
+        std::vector<std::string> query;
+        std::string term;
+        while (line_ss >> term) {
+            query.push_back(term);
+        }
+        if (!query.empty()) {
+            queries.push_back(std::move(query));
+        }
+    }
+    return queries;
+}
+
+// Latency percentile (0-100) of a sorted vector of latencies
+static double percentile(const std::vector<double>& sorted_latencies, const double p) {
+    if (sorted_latencies.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>((p / 100.0) * (sorted_latencies.size() - 1) + 0.5);
+    return sorted_latencies[rank];
+}
+
+/**
+ * Measures how well approximate results (e.g. ranked by quantized impacts) agree with exact ones, over a set of queries
+ *
+ * @param results Approximate results of each query
+ * @param exact_results Exact results of each query
+ * @param overlap Set to the mean fraction of the exact results found among the approximate ones
+ * @param identical Set to the fraction of queries whose results are the same, in the same order
+*/
+static void measureRankAgreement(
+    const std::vector<std::vector<scored_transcript>>& results,
+    const std::vector<std::vector<scored_transcript>>& exact_results,
+    double& overlap,
+    double& identical
+) {
+    overlap = 0.0;
+    identical = 0.0;
+    for (size_t q = 0; q < results.size(); q++) {
+        std::set<std::string> exact_paths;
+        for (auto& [path, score] : exact_results[q]) {
+            exact_paths.insert(path);
+        }
+        size_t num_found = 0;
+        bool same_order = results[q].size() == exact_results[q].size();
+        for (size_t r = 0; r < results[q].size(); r++) {
+            num_found += exact_paths.count(results[q][r].first);
+            same_order = same_order && results[q][r].first == exact_results[q][r].first;
+        }
+        overlap += exact_paths.empty() ? 1.0 : (1.0 * num_found) / exact_paths.size();
+        identical += same_order ? 1.0 : 0.0;
+    }
+    if (!results.empty()) {
+        overlap /= results.size();
+        identical /= results.size();
+    }
+}
+
+/**
+ * Checks the completions of a CompletionTrie against ranking every term of the dictionary starting with each prefix.
+ *
+ * The trie is built over the corpus, plus a document of sibling terms around a non-ASCII byte (which sorts after
+ * every ASCII one), and every prefix of every term of the dictionary is completed.
+ *
+ * @param database_path Path to database which stores corpus state
+ * @param max_completions Number of completions precomputed per prefix
+*/
+static void checkCompletions(const std::string& database_path, const unsigned int max_completions) {
+    InvertedIndexBuilder builder;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builder.addDocument(document);
+    });
+    std::string siblings;
+    for (char last = 'b'; last <= 'l'; last++) {
+        siblings += std::string("ca") + last + " ";
+    }
+    siblings += "ca\xc3\xa9x ca\xc3\xa9y ca\xc3\xa9z caz cax";
+    builder.addDocument(TranscriptTokenizer::countTerms("completion-check", siblings));
+    auto index = builder.build();
+    CompletionTrie trie(*index, max_completions);
+
+    auto is_better = [&](term_id a, term_id b) {
+        uint32_t frequency_a = index->getDocumentFrequency(a);
+        uint32_t frequency_b = index->getDocumentFrequency(b);
+        return frequency_a != frequency_b ? frequency_a > frequency_b : a < b;
+    };
+    size_t num_prefixes = 0;
+    size_t num_mismatches = 0;
+    std::unordered_set<std::string> checked;
+    std::vector<term_id> expected;
+    std::vector<term_id> completions;
+    for (term_id term = 0; term < index->getNumTerms(); term++) {
+        for (size_t length = 1; length <= index->getTerm(term).size(); length++) {
+            std::string prefix = index->getTerm(term).substr(0, length);
+            if (!checked.insert(prefix).second) {
+                continue;
+            }
+            expected.clear();
+            for (term_id other = term; other < index->getNumTerms() && index->getTerm(other).starts_with(prefix); other++) {
+                expected.push_back(other);
+            }
+            for (term_id other = term; other > 0 && index->getTerm(other - 1).starts_with(prefix); other--) {
+                expected.push_back(other - 1);
+            }
+            std::sort(expected.begin(), expected.end(), is_better);
+            expected.resize(std::min<size_t>(expected.size(), max_completions));
+            trie.complete(prefix, max_completions, completions);
+            num_prefixes++;
+            num_mismatches += completions != expected ? 1 : 0;
+        }
+    }
+    std::cout << "Completions of " << num_prefixes << " prefixes over " << index->getNumTerms() << " terms, "
+        << trie.getNumNodes() << " trie nodes" << std::endl;
+    std::cout << "  completion mismatches: " << num_mismatches << std::endl;
+}
+
+/**
+ * Measures what the document bitmaps of dense terms cost and buy: their memory next to the posting lists, and the
+ * time to evaluate boolean queries over dense terms with and without them (checking both give the same documents).
+ *
+ * Each query shape is filled in with random dense terms (`a` to `d`) and random rarer terms (`r`).
+ *
+ * @param database_path Path to database which stores corpus state
+ * @param num_queries Number of queries of each shape
+*/
+static void benchmarkBooleanBitmaps(const std::string& database_path, const unsigned int num_queries) {
+    InvertedIndexBuilder builder;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builder.addDocument(document);
+    });
+    auto index = builder.build();
+
+    std::vector<term_id> dense_terms;
+    std::vector<term_id> rare_terms;
+    size_t bitmap_bytes = 0;
+    size_t dense_posting_bytes = 0;
+    size_t posting_bytes = 0;
+    for (term_id term = 0; term < index->getNumTerms(); term++) {
+        size_t term_posting_bytes = index->getDocumentFrequency(term) * sizeof(posting);
+        posting_bytes += term_posting_bytes;
+        if (auto bitmap = index->getDocumentBitmap(term)) {
+            dense_terms.push_back(term);
+            bitmap_bytes += bitmap->getSizeInBytes();
+            dense_posting_bytes += term_posting_bytes;
+        } else if (index->getDocumentFrequency(term) >= 16) {
+            rare_terms.push_back(term);
+        }
+    }
+    std::cout << std::setprecision(1) << std::fixed << "Bitmaps of " << dense_terms.size() << " dense terms over "
+        << index->getNumDocuments() << " documents: " << bitmap_bytes / 1e6 << " MB, next to " << dense_posting_bytes / 1e6
+        << " MB of their postings (" << posting_bytes / 1e6 << " MB of postings in all)" << std::endl;
+    if (dense_terms.empty() || rare_terms.empty()) {
+        return;
+    }
+
+    std::mt19937 rng(7);
+    const std::vector<std::vector<std::string>> shapes = {
+        {"a", "OR", "b", "OR", "c", "OR", "d"},
+        {"(", "a", "OR", "b", ")", "AND", "r"},
+        {"a", "-b"},
+        {"a", "AND", "b"},
+        {"a", "AND", "b", "AND", "c"}
+    };
+    for (auto& shape : shapes) {
+        std::chrono::nanoseconds bitmap_duration(0);
+        std::chrono::nanoseconds posting_duration(0);
+        size_t num_documents = 0;
+        size_t num_mismatches = 0;
+        for (unsigned int q = 0; q < num_queries; q++) {
+            std::vector<std::string> search_terms;
+            for (auto& word : shape) {
+                if (word == "r") {
+                    search_terms.push_back(index->getTerm(rare_terms[rng() % rare_terms.size()]));
+                } else if (word.back() >= 'a' && word.back() <= 'd') {
+                    search_terms.push_back(word.substr(0, word.size() - 1) + index->getTerm(dense_terms[rng() % dense_terms.size()]));
+                } else {
+                    search_terms.push_back(word);
+                }
+            }
+            auto query = parseBooleanQuery(search_terms);
+            std::vector<std::span<const posting>> term_postings;
+            std::vector<const RoaringBitmap*> term_bitmaps;
+            for (auto& term : query.terms) {
+                term_id id = 0;
+                index->findTerm(term, id);
+                term_postings.push_back(index->getPostings(id));
+                term_bitmaps.push_back(index->getDocumentBitmap(id));
+            }
+            auto start_time = std::chrono::steady_clock::now();
+            auto bitmap_documents = evaluateBooleanQuery(query, term_postings, term_bitmaps);
+            auto middle_time = std::chrono::steady_clock::now();
+            auto posting_documents = evaluateBooleanQuery(query, term_postings);
+            bitmap_duration += middle_time - start_time;
+            posting_duration += std::chrono::steady_clock::now() - middle_time;
+            num_documents += bitmap_documents.size();
+            num_mismatches += bitmap_documents != posting_documents ? 1 : 0;
+        }
+        std::string shape_text;
+        for (auto& word : shape) {
+            shape_text += (shape_text.empty() ? "" : " ") + word;
+        }
+        double bitmap_us = std::chrono::duration<double, std::micro>(bitmap_duration).count() / num_queries;
+        double posting_us = std::chrono::duration<double, std::micro>(posting_duration).count() / num_queries;
+        std::cout << "  " << shape_text << ": " << bitmap_us << " us with bitmaps, " << posting_us << " us with posting lists only ("
+            << posting_us / std::max(bitmap_us, 1e-9) << "x), " << num_documents / num_queries << " documents, "
+            << num_mismatches << " mismatches" << std::endl;
+    }
+}
+
+/**
+ * Stress test of searching a ConcurrentInvertedIndex while documents are continuously appended to it.
+ *
+ * Half of the corpus is loaded up front. Query clients then search continuously while, after a quiet
+ * first second, a writer appends the rest of the corpus (and then copies of it, under new paths) as fast
+ * as it can, or at `ingest_rate` documents per second. Read latency is reported per time window, so
+ * windows with and without ingestion can be compared.
+*/
+static void runIngestStress(
+    const std::string& database_path,
+    const std::vector<std::vector<std::string>>& queries,
+    const unsigned int k,
+    const unsigned int num_clients,
+    const unsigned int duration_s,
+    const unsigned int ingest_rate
+) {
+    using clock = std::chrono::steady_clock;
+    const auto window_duration = std::chrono::milliseconds(250);
+    const auto quiet_duration = std::chrono::seconds(1);
+
+    std::vector<indexed_document> documents;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        documents.push_back(document);
+    });
+
+    ConcurrentInvertedIndex index;
+    size_t num_preloaded = documents.size() / 2;
+    for (size_t d = 0; d < num_preloaded; d++) {
+        index.addDocument(documents[d]);
+    }
+
+    auto start_time = clock::now();
+    auto end_time = start_time + std::chrono::seconds(duration_s);
+    size_t num_windows = (std::chrono::seconds(duration_s) + window_duration - std::chrono::nanoseconds(1)) / window_duration;
+    std::vector<std::atomic<size_t>> window_num_documents(num_windows);
+    std::atomic<bool> done = false;
+
+    // Writer: append documents until the end of the run, after a quiet period
+    std::thread writer([&] {
+        std::this_thread::sleep_until(start_time + quiet_duration);
+        size_t next = num_preloaded;
+        size_t cycle = 0;
+        auto ingest_start_time = clock::now();
+        size_t num_ingested = 0;
+        while (!done.load() && !documents.empty()) {
+            if (next == documents.size()) {
+                next = 0;
+                cycle++;
+            }
+            indexed_document document = documents[next++];
+            if (cycle > 0) {
+                document.path += "#" + std::to_string(cycle);
+            }
+            index.addDocument(document);
+            num_ingested++;
+            if (ingest_rate > 0) {
+                std::this_thread::sleep_until(ingest_start_time + std::chrono::microseconds(1000000 * num_ingested / ingest_rate));
+            }
+        }
+    });
+
+    // Clients: search continuously, recording each latency against the window it started in
+    std::vector<std::vector<std::pair<size_t, double>>> client_latencies(num_clients);
+    std::vector<std::thread> clients;
+    for (unsigned int c = 0; c < num_clients; c++) {
+        clients.emplace_back([&, c] {
+            for (size_t q = c; clock::now() < end_time && !queries.empty(); q += num_clients) {
+                auto& query = queries[q % queries.size()];
+                auto query_start_time = clock::now();
+
+                ConcurrentInvertedIndex::Reader reader(index);
+                std::vector<weighted_term> query_terms;
+                for (auto& term : std::set<std::string>(query.begin(), query.end())) {
+                    term_id id;
+                    if (reader.findTerm(term, id)) {
+                        query_terms.push_back({id, inverseDocumentFrequency(reader.getNumDocuments(), reader.getDocumentFrequency(id))});
+                    }
+                }
+                TopKDocuments best_documents(k);
+                SearchInterruption interruption(search_options(), query_start_time);
+                scoreTermAtATime(reader, query_terms, interruption, best_documents);
+
+                auto latency = std::chrono::duration<double, std::micro>(clock::now() - query_start_time).count();
+                size_t window = (query_start_time - start_time) / window_duration;
+                if (window < num_windows) {
+                    client_latencies[c].emplace_back(window, latency);
+                    window_num_documents[window].store(reader.getNumDocuments());
+                }
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    done.store(true);
+    writer.join();
+
+    // Report latency per window
+    std::vector<std::vector<double>> window_latencies(num_windows);
+    for (auto& latencies : client_latencies) {
+        for (auto& [window, latency] : latencies) {
+            window_latencies[window].push_back(latency);
+        }
+    }
+    std::cout << std::setprecision(1) << std::fixed;
+    std::cout << "window (ms) | ingesting | documents | queries | p50 (us) | p99 (us) | max (us)" << std::endl;
+    for (size_t w = 0; w < num_windows; w++) {
+        auto& latencies = window_latencies[w];
+        std::sort(latencies.begin(), latencies.end());
+        auto window_start = w * window_duration;
+        std::cout << std::setw(11) << std::chrono::duration_cast<std::chrono::milliseconds>(window_start).count()
+            << " | " << std::setw(9) << (window_start >= quiet_duration ? "yes" : "no")
+            << " | " << std::setw(9) << window_num_documents[w].load()
+            << " | " << std::setw(7) << latencies.size()
+            << " | " << std::setw(8) << percentile(latencies, 50)
+            << " | " << std::setw(8) << percentile(latencies, 99)
+            << " | " << std::setw(8) << percentile(latencies, 100) << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    // Configure the CLI
+    argparse::ArgumentParser program("benchmark");
+    program.add_argument("-c", "--config_file").default_value(std::string{"config.json"});
+    program.add_argument("-d", "--database").help("database path, overriding the config file");
+    program.add_argument("-a", "--search_algorithms").nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>{"tf-idf-document-partitioned", "tf-idf-term-partitioned"});
+    program.add_argument("-p", "--num_partitions").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("-q", "--queries_file").help("file with one whitespace separated query per line");
+    program.add_argument("-n", "--num_queries").default_value(1000u).scan<'u', unsigned int>();
+    program.add_argument("-t", "--max_query_terms").default_value(5u).scan<'u', unsigned int>();
+    program.add_argument("-k", "--num_best_results").default_value(10u).scan<'u', unsigned int>();
+    program.add_argument("--clients").help("number of threads issuing queries concurrently").default_value(1u).scan<'u', unsigned int>();
+    program.add_argument("--force_strategy").help("evaluate every query with this strategy: auto, taat, wand or forward (with tf-idf-memory)")
+        .default_value(std::string{"auto"});
+    program.add_argument("--latency_budget").help("microseconds after which a search returns its best results so far (with tf-idf-memory, 0 for no limit)")
+        .default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--impact_bits").help("rank by impacts quantized to 8 or 16 bits, reporting rank agreement with exact scores (with tf-idf-memory)")
+        .default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--ingest_stress").help("instead, search for this many seconds while continuously appending documents")
+        .default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--ingest_rate").help("documents per second appended during --ingest_stress (0 for unlimited)")
+        .default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--check_completions").help("instead, check the completions of every prefix of the dictionary (of tf-idf-memory)")
+        .default_value(false).implicit_value(true);
+    program.add_argument("--boolean_bitmaps").help("instead, measure the memory of dense terms' bitmaps and their speedup of boolean queries")
+        .default_value(false).implicit_value(true);
+    try {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        std::exit(1);
+    }
+
+    // Find the database, either directly or through the configuration file
+    std::string database_abspath;
+    if (auto database = program.present<std::string>("--database")) {
+        database_abspath = *database;
+    } else {
+        std::string config_abspath = PROJECT_BASE_DIR + program.get<std::string>("--config_file");
+        std::ifstream config_file(config_abspath);
+        std::string config_data((std::istreambuf_iterator<char>(config_file)),
+            std::istreambuf_iterator<char>());
+        rapidjson::Document config;
+        config.Parse(config_data.c_str());
+        database_abspath = PROJECT_BASE_DIR + std::string(config["Paths"]["database"].GetString());
+    }
+
+    unsigned int num_partitions = program.get<unsigned int>("--num_partitions");
+    unsigned int k = program.get<unsigned int>("--num_best_results");
+    unsigned int num_clients = std::max(1u, program.get<unsigned int>("--clients"));
+
+    try {
+        if (program.get<bool>("--check_completions")) {
+            checkCompletions(database_abspath, 10);
+            return 0;
+        }
+        if (program.get<bool>("--boolean_bitmaps")) {
+            benchmarkBooleanBitmaps(database_abspath, program.get<unsigned int>("--num_queries"));
+            return 0;
+        }
+
+        // The same query set is replayed against every algorithm
+        std::vector<std::vector<std::string>> queries;
+        if (auto queries_path = program.present<std::string>("--queries_file")) {
+            queries = readQueries(*queries_path);
+        } else {
+            queries = sampleQueries(database_abspath, program.get<unsigned int>("--num_queries"), program.get<unsigned int>("--max_query_terms"));
+        }
+        if (unsigned int duration_s = program.get<unsigned int>("--ingest_stress")) {
+            runIngestStress(database_abspath, queries, k, num_clients, duration_s, program.get<unsigned int>("--ingest_rate"));
+            return 0;
+        }
+
+        search_options options;
+        options.strategy = TranscriptSearcher::parseSearchStrategy(program.get<std::string>("--force_strategy"));
+        options.latency_budget = std::chrono::microseconds(program.get<unsigned int>("--latency_budget"));
+        options.impact_bits = program.get<unsigned int>("--impact_bits");
+        if (options.impact_bits != 0 && options.impact_bits != 8 && options.impact_bits != 16) {
+            throw std::runtime_error("Error: --impact_bits must be 0, 8 or 16\n");
+        }
+
+        std::cout << "Benchmarking " << queries.size() << " queries, k = " << k << ", " << num_clients << " client(s)" << std::endl;
+
+        std::vector<std::vector<scored_transcript>> reference_results;
+        for (auto& search_algorithm : program.get<std::vector<std::string>>("--search_algorithms")) {
+            // Time loading the corpus
+            auto load_start_time = std::chrono::high_resolution_clock::now();
+            std::unique_ptr<TranscriptSearchAlgorithm> transcript_search_algorithm(
+                TranscriptSearcher::createSearchAlgorithm(search_algorithm, database_abspath, num_partitions));
+            auto load_duration = std::chrono::high_resolution_clock::now() - load_start_time;
+
+            // Replay the queries from each client thread, each client taking the next unclaimed query
+            std::vector<std::vector<scored_transcript>> results(queries.size());
+            std::vector<double> latencies_us(queries.size());
+            std::atomic<size_t> next_query = 0;
+            std::atomic<size_t> num_approximate = 0;
+            auto run_start_time = std::chrono::high_resolution_clock::now();
+            std::vector<std::thread> clients;
+            for (unsigned int c = 0; c < num_clients; c++) {
+                clients.emplace_back([&] {
+                    for (size_t q = next_query++; q < queries.size(); q = next_query++) {
+                        search_statistics statistics;
+                        search_options query_options = options;
+                        query_options.statistics = &statistics;
+                        auto start_time = std::chrono::high_resolution_clock::now();
+                        transcript_search_algorithm->getBestTranscriptMatches(queries[q], k, query_options, results[q]);
+                        auto duration = std::chrono::high_resolution_clock::now() - start_time;
+                        latencies_us[q] = std::chrono::duration<double, std::micro>(duration).count();
+                        num_approximate += statistics.approximate ? 1 : 0;
+                    }
+                });
+            }
+            for (auto& client : clients) {
+                client.join();
+            }
+            auto run_duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - run_start_time);
+
+            // Compare the returned documents against the first algorithm benchmarked
+            size_t num_mismatches = 0;
+            if (reference_results.empty()) {
+                reference_results = results;
+            } else {
+                for (size_t q = 0; q < queries.size(); q++) {
+                    for (size_t r = 0; r < results[q].size() || r < reference_results[q].size(); r++) {
+                        if (r >= results[q].size() || r >= reference_results[q].size() ||
+                            std::abs(results[q][r].second - reference_results[q][r].second) > 1e-9) {
+                            num_mismatches++;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            std::sort(latencies_us.begin(), latencies_us.end());
+            double mean_latency = 0.0;
+            for (auto latency : latencies_us) {
+                mean_latency += latency / latencies_us.size();
+            }
+
+            std::cout << std::setprecision(1) << std::fixed;
+            std::cout << search_algorithm << std::endl;
+            std::cout << "  load: " << std::chrono::duration_cast<std::chrono::milliseconds>(load_duration).count() << " ms" << std::endl;
+            std::cout << "  latency (us): mean " << mean_latency
+                << " | p50 " << percentile(latencies_us, 50)
+                << " | p95 " << percentile(latencies_us, 95)
+                << " | p99 " << percentile(latencies_us, 99)
+                << " | max " << percentile(latencies_us, 100) << std::endl;
+            std::cout << "  throughput: " << queries.size() / run_duration.count() << " queries/s" << std::endl;
+            std::cout << "  score mismatches vs " << program.get<std::vector<std::string>>("--search_algorithms").front()
+                << ": " << num_mismatches << std::endl;
+            if (options.latency_budget.count() > 0) {
+                std::cout << "  approximate (out of time): " << num_approximate << " queries" << std::endl;
+            }
+            if (options.impact_bits != 0) {
+                // Replay the queries with exact scores to compare the rankings
+                search_options exact_options = options;
+                exact_options.impact_bits = 0;
+                std::vector<std::vector<scored_transcript>> exact_results(queries.size());
+                for (size_t q = 0; q < queries.size(); q++) {
+                    transcript_search_algorithm->getBestTranscriptMatches(queries[q], k, exact_options, exact_results[q]);
+                }
+                double overlap;
+                double identical;
+                measureRankAgreement(results, exact_results, overlap, identical);
+                std::cout << "  rank agreement with exact scores: top-" << k << " overlap " << 100.0 * overlap
+                    << "% | identical rankings " << 100.0 * identical << "%" << std::endl;
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+#include "boolean_query.h"
+#include "galloping_search.h"
+#include "transcript_tokenizer.h"
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+// A token of a boolean query
+struct query_token {
+    enum token_type { TERM, AND, OR, NOT, OPEN, CLOSE };
+    token_type type;
+    std::string text;
+};
+
+/**
+ * Splits search terms into query tokens, separating parentheses and `-` exclusions from the terms they are attached to
+*/
+static std::vector<query_token> lexQuery(const std::vector<std::string>& search_terms) {
+    std::vector<query_token> tokens;
+    for (auto& search_term : search_terms) {
+        // A term containing whitespace was quoted, so it is a phrase and never an operator
+        if (TranscriptTokenizer::hasWhitespace(search_term)) {
+            tokens.push_back({query_token::TERM, search_term});
+            continue;
+        }
+
+        size_t begin = 0;
+        size_t end = search_term.size();
+        while (begin < end && search_term[begin] == '(') {
+            tokens.push_back({query_token::OPEN, "("});
+            begin++;
+        }
+        size_t num_close = 0;
+        while (end > begin && search_term[end - 1] == ')') {
+            num_close++;
+            end--;
+        }
+        if (end - begin > 1 && search_term[begin] == '-') {
+            tokens.push_back({query_token::NOT, "-"});
+            begin++;
+        }
+
+        std::string word = search_term.substr(begin, end - begin);
+        if (word == "AND") {
+            tokens.push_back({query_token::AND, word});
+        } else if (word == "OR") {
+            tokens.push_back({query_token::OR, word});
+        } else if (word == "NOT") {
+            tokens.push_back({query_token::NOT, word});
+        } else if (!word.empty()) {
+            tokens.push_back({query_token::TERM, word});
+        }
+        tokens.insert(tokens.end(), num_close, {query_token::CLOSE, ")"});
+    }
+    return tokens;
+}
+
+// State of a recursive descent parse of the grammar
+//     or_clause  := and_clause ( ["OR"] and_clause )*
+//     and_clause := unary ( "AND" unary )*
+//     unary      := ("NOT" | "-") unary | "(" or_clause ")" | term
+struct query_parser {
+    const std::vector<query_token>& tokens;
+    boolean_query& query;
+    // Index of the next token to parse
+    size_t position = 0;
+    // Number of NOTs enclosing the current token
+    unsigned int negations = 0;
+};
+
+static boolean_query_node parseOr(query_parser& parser);
+
+static boolean_query_node parseUnary(query_parser& parser) {
+    if (parser.position >= parser.tokens.size()) {
+        throw std::runtime_error("Error: query ends where a term was expected\n");
+    }
+    const query_token& token = parser.tokens[parser.position++];
+    switch (token.type) {
+        case query_token::NOT: {
+            parser.negations++;
+            boolean_query_node operand = parseUnary(parser);
+            parser.negations--;
+            // A double negation is just the term itself
+            if (operand.type == boolean_query_node::NOT) {
+                return std::move(operand.children[0]);
+            }
+            boolean_query_node node{boolean_query_node::NOT, 0, {}};
+            node.children.push_back(std::move(operand));
+            return node;
+        }
+        case query_token::OPEN: {
+            boolean_query_node node = parseOr(parser);
+            if (parser.position >= parser.tokens.size()) {
+                throw std::runtime_error("Error: unmatched \"(\" in query\n");
+            }
+            parser.position++;
+            return node;
+        }
+        case query_token::TERM: {
+            boolean_query_node node{boolean_query_node::TERM, parser.query.terms.size(), {}};
+            parser.query.terms.push_back(token.text);
+            parser.query.excluded.push_back(parser.negations % 2 == 1);
+            return node;
+        }
+        default:
+            throw std::runtime_error("Error: expected a term before \"" + token.text + "\" in query\n");
+    }
+}
+
+static boolean_query_node parseAnd(query_parser& parser) {
+    boolean_query_node node{boolean_query_node::AND, 0, {}};
+    node.children.push_back(parseUnary(parser));
+    while (parser.position < parser.tokens.size() && parser.tokens[parser.position].type == query_token::AND) {
+        parser.position++;
+        node.children.push_back(parseUnary(parser));
+    }
+    return node.children.size() == 1 ? std::move(node.children[0]) : std::move(node);
+}
+
+static boolean_query_node parseOr(query_parser& parser) {
+    boolean_query_node node{boolean_query_node::OR, 0, {}};
+    node.children.push_back(parseAnd(parser));
+    while (parser.position < parser.tokens.size() && parser.tokens[parser.position].type != query_token::CLOSE) {
+        if (parser.tokens[parser.position].type == query_token::OR) {
+            parser.position++;
+        }
+        node.children.push_back(parseAnd(parser));
+    }
+    return node.children.size() == 1 ? std::move(node.children[0]) : std::move(node);
+}
+
+/**
+ * Intersects a list of documents with another, or subtracts the other from it, by walking the shorter of
+ * the two and galloping through the longer
+*/
+static std::vector<posting> intersectOrSubtract(std::span<const posting> documents, std::span<const posting> list, const bool intersect) {
+    auto less = [](const posting& entry, document_id document) { return entry.document < document; };
+    std::vector<posting> result;
+    if (documents.size() <= list.size()) {
+        auto it = list.begin();
+        for (auto& entry : documents) {
+            it = gallopLowerBound(it, list.end(), entry.document, less);
+            bool found = it != list.end() && it->document == entry.document;
+            if (found == intersect) {
+                result.push_back(entry);
+            }
+        }
+    } else {
+        auto it = documents.begin();
+        for (auto& entry : list) {
+            auto next = gallopLowerBound(it, documents.end(), entry.document, less);
+            if (!intersect) {
+                result.insert(result.end(), it, next);
+            }
+            if (next != documents.end() && next->document == entry.document) {
+                if (intersect) {
+                    result.push_back(*next);
+                }
+                next++;
+            }
+            it = next;
+        }
+        if (!intersect) {
+            result.insert(result.end(), it, documents.end());
+        }
+    }
+    return result;
+}
+
+// Documents matching a node: a posting list, or a bitmap when a dense term takes part
+struct node_documents {
+    std::span<const posting> postings;
+    const RoaringBitmap* bitmap = nullptr;
+
+    uint64_t size() const { return bitmap ? bitmap->getCardinality() : postings.size(); }
+};
+
+// Storage of the documents computed while evaluating a query
+struct evaluation_storage {
+    std::deque<std::vector<posting>> lists;
+    std::deque<RoaringBitmap> bitmaps;
+};
+
+// Bitmap of a node's documents, converting a posting list
+static const RoaringBitmap* toBitmap(const node_documents& documents, evaluation_storage& storage) {
+    if (documents.bitmap) {
+        return documents.bitmap;
+    }
+    std::vector<uint32_t> values;
+    values.reserve(documents.postings.size());
+    for (auto& entry : documents.postings) {
+        values.push_back(entry.document);
+    }
+    storage.bitmaps.emplace_back(values);
+    return &storage.bitmaps.back();
+}
+
+// Keeps the postings whose documents are (or are not) in a bitmap, probing one bit per posting
+static std::vector<posting> filterByBitmap(std::span<const posting> list, const RoaringBitmap& bitmap, const bool keep_contained) {
+    std::vector<posting> result;
+    for (auto& entry : list) {
+        if (bitmap.contains(entry.document) == keep_contained) {
+            result.push_back(entry);
+        }
+    }
+    return result;
+}
+
+/**
+ * Intersects a node's documents with another's, or subtracts the other's: bitmaps combine word by word, a posting
+ * list is filtered by probing a bitmap, and two posting lists are walked by galloping (see intersectOrSubtract)
+*/
+static node_documents combineDocuments(const node_documents& documents, const node_documents& other, const bool intersect, evaluation_storage& storage) {
+    if (documents.bitmap && other.bitmap) {
+        auto& bitmaps = storage.bitmaps;
+        bitmaps.push_back(intersect ? RoaringBitmap::intersect(*documents.bitmap, *other.bitmap) : RoaringBitmap::subtract(*documents.bitmap, *other.bitmap));
+        return {{}, &bitmaps.back()};
+    }
+    if (other.bitmap) {
+        storage.lists.push_back(filterByBitmap(documents.postings, *other.bitmap, intersect));
+    } else if (!documents.bitmap) {
+        storage.lists.push_back(intersectOrSubtract(documents.postings, other.postings, intersect));
+    } else if (intersect) {
+        storage.lists.push_back(filterByBitmap(other.postings, *documents.bitmap, true));
+    } else {
+        storage.bitmaps.push_back(RoaringBitmap::subtract(*documents.bitmap, *toBitmap(other, storage)));
+        return {{}, &storage.bitmaps.back()};
+    }
+    return {storage.lists.back(), nullptr};
+}
+
+/**
+ * Evaluates a node into its matching documents, which either view a term's posting list or bitmap, or are kept in
+ * `storage` (frequencies of the latter are meaningless)
+*/
+static node_documents evaluateNode(
+    const boolean_query_node& node,
+    const std::vector<node_documents>& term_documents,
+    evaluation_storage& storage
+) {
+    if (node.type == boolean_query_node::TERM) {
+        return term_documents[node.term];
+    } else if (node.type == boolean_query_node::NOT) {
+        return {};
+    }
+
+    std::vector<node_documents> included;
+    std::vector<node_documents> excluded;
+    for (auto& child : node.children) {
+        if (child.type == boolean_query_node::NOT) {
+            excluded.push_back(evaluateNode(child.children[0], term_documents, storage));
+        } else {
+            included.push_back(evaluateNode(child, term_documents, storage));
+        }
+    }
+    if (included.empty()) {
+        return {};
+    }
+
+    node_documents documents = included[0];
+    if (node.type == boolean_query_node::AND) {
+        // Rarest first, so every step walks at most the shortest list so far
+        std::sort(included.begin(), included.end(), [](auto& a, auto& b) { return a.size() < b.size(); });
+        documents = included[0];
+        for (size_t i = 1; i < included.size() && documents.size() > 0; i++) {
+            documents = combineDocuments(documents, included[i], true, storage);
+        }
+    } else if (std::any_of(included.begin(), included.end(), [](auto& list) { return list.bitmap != nullptr; })) {
+        // A union with a dense term is dense too, so it is built as a bitmap
+        const RoaringBitmap* bitmap = toBitmap(included[0], storage);
+        for (size_t i = 1; i < included.size(); i++) {
+            storage.bitmaps.push_back(RoaringBitmap::unite(*bitmap, *toBitmap(included[i], storage)));
+            bitmap = &storage.bitmaps.back();
+        }
+        documents = {{}, bitmap};
+    } else {
+        for (size_t i = 1; i < included.size(); i++) {
+            std::vector<posting> merged;
+            merged.reserve(documents.postings.size() + included[i].postings.size());
+            std::set_union(documents.postings.begin(), documents.postings.end(), included[i].postings.begin(), included[i].postings.end(),
+                std::back_inserter(merged), [](const posting& a, const posting& b) { return a.document < b.document; });
+            storage.lists.push_back(std::move(merged));
+            documents = {storage.lists.back(), nullptr};
+        }
+    }
+
+    for (auto& list : excluded) {
+        if (documents.size() == 0) {
+            break;
+        }
+        if (list.size() > 0) {
+            documents = combineDocuments(documents, list, false, storage);
+        }
+    }
+    return documents;
+}
+
+bool isBooleanQuery(const std::vector<std::string>& search_terms) {
+    auto tokens = lexQuery(search_terms);
+    return std::any_of(tokens.begin(), tokens.end(), [](const query_token& token) { return token.type != query_token::TERM; });
+}
+
+boolean_query parseBooleanQuery(const std::vector<std::string>& search_terms) {
+    auto tokens = lexQuery(search_terms);
+    if (tokens.empty()) {
+        throw std::runtime_error("Error: empty query\n");
+    }
+
+    boolean_query query;
+    query_parser parser{tokens, query};
+    query.root = parseOr(parser);
+    if (parser.position < tokens.size()) {
+        throw std::runtime_error("Error: unmatched \")\" in query\n");
+    }
+    return query;
+}
+
+std::vector<std::string> getIncludedTerms(const std::vector<std::string>& search_terms) {
+    if (!isBooleanQuery(search_terms)) {
+        return search_terms;
+    }
+    auto query = parseBooleanQuery(search_terms);
+    std::vector<std::string> included_terms;
+    for (size_t t = 0; t < query.terms.size(); t++) {
+        if (!query.excluded[t]) {
+            included_terms.push_back(query.terms[t]);
+        }
+    }
+    return included_terms;
+}
+
+std::vector<document_id> evaluateBooleanQuery(
+    const boolean_query& query,
+    const std::vector<std::span<const posting>>& term_postings,
+    const std::vector<const RoaringBitmap*>& term_bitmaps
+) {
+    std::vector<node_documents> term_documents;
+    for (size_t t = 0; t < term_postings.size(); t++) {
+        term_documents.push_back({term_postings[t], t < term_bitmaps.size() ? term_bitmaps[t] : nullptr});
+    }
+    evaluation_storage storage;
+    node_documents documents = evaluateNode(query.root, term_documents, storage);
+
+    std::vector<document_id> matching_documents;
+    if (documents.bitmap) {
+        documents.bitmap->getValues(matching_documents);
+        return matching_documents;
+    }
+    matching_documents.reserve(documents.postings.size());
+    for (auto& entry : documents.postings) {
+        matching_documents.push_back(entry.document);
+    }
+    return matching_documents;
+}
@@ -0,0 +1,212 @@
+#include "buffer_pool.h"
+#include <cstdlib>
+#include <stdexcept>
+
+PinnedBlock::PinnedBlock(PinnedBlock&& other) noexcept
+    : pool(std::exchange(other.pool, nullptr)), page(other.page), data(other.data), size(other.size) {}
+
+PinnedBlock& PinnedBlock::operator= (PinnedBlock&& other) noexcept {
+    if (this != &other) {
+        if (pool) {
+            pool->unpin(page);
+        }
+        pool = std::exchange(other.pool, nullptr);
+        page = other.page;
+        data = other.data;
+        size = other.size;
+    }
+    return *this;
+}
+
+PinnedBlock::~PinnedBlock() {
+    if (pool) {
+        pool->unpin(page);
+    }
+}
+
+BufferPool::BufferPool(
+    AsyncFileReader& reader,
+    CoroutineScheduler& scheduler,
+    const uint64_t base_offset,
+    const size_t block_size,
+    const buffer_pool_options& options
+) : reader(reader), scheduler(scheduler), base_offset(base_offset), block_size(block_size),
+    readahead_blocks(options.readahead_blocks), memory(nullptr, std::free), pages(options.num_pages) {
+    if (options.num_pages == 0) {
+        throw std::runtime_error("Error: a buffer pool needs at least one page\n");
+    }
+    memory.reset(static_cast<uint8_t*>(std::aligned_alloc(block_size, options.num_pages * block_size)));
+    if (!memory) {
+        throw std::runtime_error("Error: unable to allocate a buffer pool of " + std::to_string(options.num_pages) + " pages\n");
+    }
+    statistics.num_pages = options.num_pages;
+}
+
+bool BufferPool::takePage(size_t& victim) {
+    // Two sweeps find a page unless all are pinned or being read, the first clearing the references it passes
+    for (size_t step = 0; step < 2 * pages.size(); step++) {
+        size_t index = clock_hand;
+        clock_hand = (clock_hand + 1) % pages.size();
+        auto& candidate = pages[index];
+        if (candidate.pins > 0 || candidate.state == PAGE_LOADING) {
+            continue;
+        }
+        if (candidate.referenced) {
+            candidate.referenced = false;
+            continue;
+        }
+        if (candidate.state == PAGE_READY) {
+            block_pages.erase(candidate.block);
+            statistics.evictions++;
+        }
+        candidate.state = PAGE_EMPTY;
+        victim = index;
+        return true;
+    }
+    return false;
+}
+
+void BufferPool::assignPage(const size_t index, const uint64_t block) {
+    auto& assigned = pages[index];
+    assigned.block = block;
+    assigned.state = PAGE_LOADING;
+    assigned.referenced = true;
+    assigned.size = 0;
+    block_pages[block] = index;
+}
+
+AsyncTask<PinnedBlock> BufferPool::pin(const uint64_t block, const uint64_t last_block) {
+    mutex.lock();
+    while (true) {
+        auto found = block_pages.find(block);
+        if (found != block_pages.end()) {
+            size_t index = found->second;
+            pages[index].pins++;
+            pages[index].referenced = true;
+            statistics.hits++;
+            if (pages[index].state == PAGE_LOADING) {
+                co_await wait_awaiter{mutex, pages[index].waiters};
+            }
+            if (pages[index].state == PAGE_READY) {
+                PinnedBlock pinned(this, index, getPageData(index), pages[index].size);
+                mutex.unlock();
+                co_return pinned;
+            }
+
+            // The read failed, so this request reads the block again
+            pages[index].pins--;
+            continue;
+        }
+
+        size_t index;
+        if (!takePage(index)) {
+            co_await wait_awaiter{mutex, page_waiters};
+            continue;
+        }
+        assignPage(index, block);
+        pages[index].pins = 1;
+        statistics.misses++;
+
+        // Read the following blocks along with this one, into pages nobody is using
+        std::vector<size_t> ahead;
+        for (uint64_t next = block + 1; next <= last_block && next <= block + readahead_blocks; next++) {
+            size_t ahead_index;
+            if (block_pages.count(next) > 0) {
+                continue;
+            }
+            if (!takePage(ahead_index)) {
+                break;
+            }
+            assignPage(ahead_index, next);
+            ahead.push_back(ahead_index);
+        }
+        statistics.readahead_blocks += ahead.size();
+        readahead_in_flight += ahead.size();
+        mutex.unlock();
+
+        for (auto ahead_index : ahead) {
+            scheduler.spawn(load(ahead_index, true));
+        }
+        size_t size;
+        try {
+            size = co_await load(index, false);
+        } catch (...) {
+            unpin(index);
+            throw;
+        }
+        co_return PinnedBlock(this, index, getPageData(index), size);
+    }
+}
+
+AsyncTask<size_t> BufferPool::load(const size_t index, const bool ahead) {
+    uint64_t block;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        block = pages[index].block;
+    }
+    size_t size = 0;
+    std::exception_ptr failure;
+    try {
+        size = co_await reader.read(base_offset + block * block_size, getPageData(index), block_size);
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& loaded = pages[index];
+        waiters.swap(loaded.waiters);
+        if (failure) {
+            block_pages.erase(loaded.block);
+            loaded.state = PAGE_EMPTY;
+        } else {
+            loaded.state = PAGE_READY;
+            loaded.size = size;
+        }
+        // A block read ahead can now be evicted
+        if (loaded.pins == 0) {
+            waiters.insert(waiters.end(), page_waiters.begin(), page_waiters.end());
+            page_waiters.clear();
+        }
+    }
+    for (auto waiter : waiters) {
+        scheduler.resume(waiter);
+    }
+
+    // Once the count drops, the pool may be destroyed, so it is the last use of it
+    if (ahead) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readahead_in_flight--;
+        readahead_done.notify_all();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    co_return size;
+}
+
+void BufferPool::unpin(const size_t index) {
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pages[index].pins == 0) {
+            waiters.swap(page_waiters);
+        }
+    }
+    for (auto waiter : waiters) {
+        scheduler.resume(waiter);
+    }
+}
+
+buffer_pool_statistics BufferPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer_pool_statistics current = statistics;
+    current.resident_pages = block_pages.size();
+    return current;
+}
+
+BufferPool::~BufferPool() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readahead_done.wait(lock, [this] { return readahead_in_flight == 0; });
+}
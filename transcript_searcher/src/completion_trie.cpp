@@ -0,0 +1,121 @@
+#include "completion_trie.h"
+#include <algorithm>
+
+CompletionTrie::CompletionTrie(const InvertedIndex& index, const unsigned int max_completions)
+    : index(index), max_completions(max_completions) {
+    nodes.push_back({0, static_cast<term_id>(index.getNumTerms()), 0, 0, 0, '\0'});
+    std::vector<uint32_t> depths{0};
+
+    // Breadth first, so each node's children are appended next to each other
+    std::vector<term_id> range_terms;
+    for (size_t n = 0; n < nodes.size(); n++) {
+        term_id begin = nodes[n].range_begin;
+        term_id end = nodes[n].range_end;
+        uint32_t depth = depths[n];
+        if (end - begin <= max_completions) {
+            continue;
+        }
+
+        // Rank the prefix's terms once, here, rather than on every lookup
+        range_terms.resize(end - begin);
+        for (term_id term = begin; term < end; term++) {
+            range_terms[term - begin] = term;
+        }
+        std::partial_sort(range_terms.begin(), range_terms.begin() + max_completions, range_terms.end(), [this](term_id a, term_id b) {
+            return isBetterCompletion(a, b);
+        });
+        nodes[n].first_completion = completions.size();
+        completions.insert(completions.end(), range_terms.begin(), range_terms.begin() + max_completions);
+
+        // The term equal to the prefix, if any, sorts first and has no child; the others are grouped by their next character
+        term_id term = begin;
+        if (index.getTerm(term).size() == depth) {
+            term++;
+        }
+        nodes[n].first_child = nodes.size();
+        while (term < end) {
+            char label = index.getTerm(term)[depth];
+            term_id child_end = term + 1;
+            while (child_end < end && index.getTerm(child_end)[depth] == label) {
+                child_end++;
+            }
+            nodes.push_back({term, child_end, 0, 0, 0, label});
+            depths.push_back(depth + 1);
+            term = child_end;
+        }
+        nodes[n].num_children = nodes.size() - nodes[n].first_child;
+    }
+}
+
+bool CompletionTrie::isBetterCompletion(const term_id a, const term_id b) const {
+    uint32_t frequency_a = index.getDocumentFrequency(a);
+    uint32_t frequency_b = index.getDocumentFrequency(b);
+    return frequency_a != frequency_b ? frequency_a > frequency_b : a < b;
+}
+
+void CompletionTrie::complete(std::string_view prefix, const unsigned int n, std::vector<term_id>& completions) const {
+    completions.clear();
+
+    // Follow the prefix down to a node, or to a leaf holding few enough terms to rank now
+    uint32_t node = 0;
+    size_t depth = 0;
+    while (depth < prefix.size() && nodes[node].num_children > 0) {
+        auto children_begin = nodes.begin() + nodes[node].first_child;
+        auto children_end = children_begin + nodes[node].num_children;
+        // Children are in dictionary order, which compares bytes as unsigned (e.g. "é" after "z")
+        auto child = std::lower_bound(children_begin, children_end, prefix[depth], [](const trie_node& entry, char label) {
+            return static_cast<unsigned char>(entry.label) < static_cast<unsigned char>(label);
+        });
+        if (child == children_end || child->label != prefix[depth]) {
+            return;
+        }
+        node = child - nodes.begin();
+        depth++;
+    }
+
+    unsigned int num_completions = std::min(n, max_completions);
+    if (depth == prefix.size() && nodes[node].num_children > 0) {
+        auto first = this->completions.begin() + nodes[node].first_completion;
+        completions.assign(first, first + num_completions);
+        return;
+    }
+
+    for (term_id term = nodes[node].range_begin; term < nodes[node].range_end; term++) {
+        if (index.getTerm(term).starts_with(prefix)) {
+            completions.push_back(term);
+        }
+    }
+    std::sort(completions.begin(), completions.end(), [this](term_id a, term_id b) {
+        return isBetterCompletion(a, b);
+    });
+    if (completions.size() > num_completions) {
+        completions.resize(num_completions);
+    }
+}
+
+std::pair<term_id, term_id> CompletionTrie::getPrefixRange(std::string_view prefix) const {
+    // Binary search the sorted dictionary for the first term not before the prefix, then for the first after its terms
+    term_id begin = 0;
+    term_id end = static_cast<term_id>(index.getNumTerms());
+    term_id low = begin;
+    term_id high = end;
+    while (low < high) {
+        term_id middle = low + (high - low) / 2;
+        if (std::string_view(index.getTerm(middle)) < prefix) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    begin = low;
+    high = end;
+    while (low < high) {
+        term_id middle = low + (high - low) / 2;
+        if (index.getTerm(middle).starts_with(prefix)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return {begin, low};
+}
@@ -0,0 +1,170 @@
+#include "concurrent_inverted_index.h"
+#include <algorithm>
+
+// Initial number of dictionary buckets (a power of two), and capacity of a new posting list
+static const size_t initial_dictionary_buckets = 1024;
+static const size_t initial_posting_list_capacity = 4;
+
+// Number of retirements between attempts to free retired versions
+static const size_t retirements_per_reclaim = 64;
+
+ConcurrentInvertedIndex::ConcurrentInvertedIndex() {
+    auto table = new dictionary_table{
+        initial_dictionary_buckets - 1,
+        0,
+        std::make_unique<std::atomic<dictionary_node*>[]>(initial_dictionary_buckets)
+    };
+    for (size_t b = 0; b < initial_dictionary_buckets; b++) {
+        table->buckets[b].store(nullptr, std::memory_order_relaxed);
+    }
+    dictionary.store(table);
+}
+
+ConcurrentInvertedIndex::Reader::Reader(const ConcurrentInvertedIndex& index)
+    : index(index), guard(index.epochs.enter()), num_documents(index.getNumDocuments()) {}
+
+bool ConcurrentInvertedIndex::Reader::findTerm(const std::string& term, term_id& id) const {
+    size_t hash = std::hash<std::string>()(term);
+    const dictionary_table* table = index.dictionary.load(std::memory_order_acquire);
+    for (auto node = table->buckets[hash & table->mask].load(std::memory_order_acquire); node; node = node->next) {
+        if (node->hash == hash && index.terms[node->term].term == term) {
+            id = node->term;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::span<const posting> ConcurrentInvertedIndex::Reader::getPostings(const term_id term) const {
+    const posting_list_version* version = index.terms[term].postings.load(std::memory_order_acquire);
+    const posting* begin = version->postings.get();
+    const posting* end = begin + version->size.load(std::memory_order_acquire);
+
+    // Postings appended after the snapshot sit at the end of the list, since document ids only increase
+    if (begin != end && (end - 1)->document >= num_documents) {
+        end = std::lower_bound(begin, end, num_documents, [](const posting& entry, size_t document) {
+            return entry.document < document;
+        });
+    }
+    return std::span<const posting>(begin, end);
+}
+
+document_id ConcurrentInvertedIndex::addDocument(const indexed_document& document) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+
+    // Fill in the document's entry, unpublished until every posting is in place
+    document_id id = static_cast<document_id>(num_documents.load(std::memory_order_relaxed));
+    documents.reserve(id);
+    documents[id].path = document.path;
+    documents[id].num_terms = document.num_terms;
+
+    for (auto& [term, frequency] : document.term_frequencies) {
+        appendPosting(findOrAddTerm(term), {id, frequency});
+    }
+
+    num_documents.store(id + 1, std::memory_order_release);
+
+    if (epochs.getNumRetired() >= retirements_per_reclaim) {
+        epochs.reclaim();
+    }
+    return id;
+}
+
+term_id ConcurrentInvertedIndex::findOrAddTerm(const std::string& term) {
+    size_t hash = std::hash<std::string>()(term);
+    dictionary_table* table = dictionary.load(std::memory_order_relaxed);
+    for (auto node = table->buckets[hash & table->mask].load(std::memory_order_relaxed); node; node = node->next) {
+        if (node->hash == hash && terms[node->term].term == term) {
+            return node->term;
+        }
+    }
+
+    // Create the term's entry with an empty posting list before any reader can find it
+    term_id id = static_cast<term_id>(num_terms++);
+    terms.reserve(id);
+    terms[id].term = term;
+    terms[id].postings.store(new posting_list_version{
+        initial_posting_list_capacity,
+        0,
+        std::make_unique<posting[]>(initial_posting_list_capacity)
+    }, std::memory_order_release);
+
+    // Keep chains short
+    if (table->size + 1 > (table->mask + 1) * 3 / 4) {
+        growDictionary();
+        table = dictionary.load(std::memory_order_relaxed);
+    }
+
+    // Publish the term by pushing it onto the front of its chain
+    auto& bucket = table->buckets[hash & table->mask];
+    bucket.store(new dictionary_node{id, hash, bucket.load(std::memory_order_relaxed)}, std::memory_order_release);
+    table->size++;
+    return id;
+}
+
+void ConcurrentInvertedIndex::appendPosting(const term_id term, const posting& entry) {
+    posting_list_version* version = terms[term].postings.load(std::memory_order_relaxed);
+    size_t size = version->size.load(std::memory_order_relaxed);
+
+    if (size == version->capacity) {
+        // Copy into a version with twice the room, publish it, and retire the full one
+        auto grown = new posting_list_version{
+            version->capacity * 2,
+            size,
+            std::make_unique<posting[]>(version->capacity * 2)
+        };
+        std::copy(version->postings.get(), version->postings.get() + size, grown->postings.get());
+        terms[term].postings.store(grown, std::memory_order_release);
+        epochs.retire([version] { delete version; });
+        version = grown;
+    }
+
+    // Readers only look below `size`, so the new slot can be written before it is published
+    version->postings[size] = entry;
+    version->size.store(size + 1, std::memory_order_release);
+}
+
+void ConcurrentInvertedIndex::growDictionary() {
+    dictionary_table* table = dictionary.load(std::memory_order_relaxed);
+    size_t num_buckets = (table->mask + 1) * 2;
+    auto grown = new dictionary_table{
+        num_buckets - 1,
+        table->size,
+        std::make_unique<std::atomic<dictionary_node*>[]>(num_buckets)
+    };
+    for (size_t b = 0; b < num_buckets; b++) {
+        grown->buckets[b].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Rehash copies of every node into the new table
+    for (size_t b = 0; b <= table->mask; b++) {
+        for (auto node = table->buckets[b].load(std::memory_order_relaxed); node; node = node->next) {
+            auto& bucket = grown->buckets[node->hash & grown->mask];
+            bucket.store(new dictionary_node{node->term, node->hash, bucket.load(std::memory_order_relaxed)}, std::memory_order_relaxed);
+        }
+    }
+
+    dictionary.store(grown, std::memory_order_release);
+    epochs.retire([table] { deleteDictionaryTable(table); });
+}
+
+void ConcurrentInvertedIndex::deleteDictionaryTable(dictionary_table* table) {
+    for (size_t b = 0; b <= table->mask; b++) {
+        auto node = table->buckets[b].load(std::memory_order_relaxed);
+        while (node) {
+            auto next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+    delete table;
+}
+
+ConcurrentInvertedIndex::~ConcurrentInvertedIndex() {
+    // No reader may be active, so everything retired can go
+    epochs.reclaim();
+    for (size_t t = 0; t < num_terms; t++) {
+        delete terms[t].postings.load(std::memory_order_relaxed);
+    }
+    deleteDictionaryTable(dictionary.load(std::memory_order_relaxed));
+}
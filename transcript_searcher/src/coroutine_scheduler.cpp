@@ -0,0 +1,45 @@
+#include "coroutine_scheduler.h"
+#include <algorithm>
+
+CoroutineScheduler::CoroutineScheduler(const unsigned int num_threads) {
+    unsigned int count = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 0; t < count; t++) {
+        threads.emplace_back(&CoroutineScheduler::run, this);
+    }
+}
+
+void CoroutineScheduler::resume(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(handle);
+    }
+    ready_available.notify_one();
+}
+
+void CoroutineScheduler::run() {
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready_available.wait(lock, [this] { return stopping || !ready.empty(); });
+            if (ready.empty()) {
+                // Stopping and nothing left to do
+                return;
+            }
+            handle = ready.front();
+            ready.pop_front();
+        }
+        handle.resume();
+    }
+}
+
+CoroutineScheduler::~CoroutineScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,283 @@
+#include "disk_tf_idf_search.h"
+#include "boolean_query.h"
+#include "search_interruption.h"
+#include "tf_idf_scoring.h"
+#include "transcript_tokenizer.h"
+#include <algorithm>
+#include <future>
+#include <semaphore>
+#include <set>
+#include <stdexcept>
+
+// Number of threads reading posting blocks when io_uring is unavailable, i.e. of reads in flight at once
+static const unsigned int num_read_threads = 16;
+
+// Largest number of searches of a batch in progress at once, which bounds the memory of their accumulators while
+// keeping enough reads in flight
+static const size_t max_batch_searches = 256;
+
+/**
+ * A search term's token in the posting file, along with its corpus IDF.
+*/
+struct disk_term {
+    token_id token;
+    double idf;
+};
+
+DiskTfIdfSearch::DiskTfIdfSearch(
+    const std::string database_path,
+    const unsigned int num_threads,
+    const buffer_pool_options& pool_options,
+    const index_warmup_options& warmup_options
+) {
+    // Direct reads must land in the pool's aligned pages
+    if (pool_options.direct_io && pool_options.num_pages == 0) {
+        throw std::runtime_error("Error: direct reads need a buffer pool\n");
+    }
+
+    std::string forward_index_path = database_path + ".forward";
+    std::string posting_file_path = database_path + ".postings";
+    if (!loadIndexes(forward_index_path, posting_file_path, warmup_options)) {
+        // The posting file is built against the forward index, which is rebuilt first if it is missing or turns out
+        // not to match the database
+        std::unique_ptr<ForwardIndex> built_forward_index;
+        try {
+            built_forward_index = std::make_unique<ForwardIndex>(forward_index_path);
+        } catch (const std::runtime_error&) {
+            ForwardIndex::build(database_path, forward_index_path);
+            built_forward_index = std::make_unique<ForwardIndex>(forward_index_path);
+        }
+        if (!PostingFile::build(database_path, *built_forward_index, posting_file_path)) {
+            built_forward_index.reset();
+            ForwardIndex::build(database_path, forward_index_path);
+            built_forward_index = std::make_unique<ForwardIndex>(forward_index_path);
+            if (!PostingFile::build(database_path, *built_forward_index, posting_file_path)) {
+                throw std::runtime_error("Error: forward index \"" + forward_index_path + "\" does not match the database\n");
+            }
+        }
+        built_forward_index.reset();
+        if (!loadIndexes(forward_index_path, posting_file_path, warmup_options)) {
+            throw std::runtime_error("Error: posting file \"" + posting_file_path + "\" does not match the forward index\n");
+        }
+    }
+
+    scheduler = std::make_unique<CoroutineScheduler>(num_threads);
+    posting_reader = std::make_unique<AsyncFileReader>(posting_file_path, *scheduler, num_read_threads, true, pool_options.direct_io);
+    if (pool_options.num_pages > 0) {
+        buffer_pool = std::make_unique<BufferPool>(
+            *posting_reader, *scheduler, posting_file->getPostingsOffset(), posting_block_size, pool_options
+        );
+    }
+}
+
+bool DiskTfIdfSearch::loadIndexes(
+    const std::string& forward_index_path,
+    const std::string& posting_file_path,
+    const index_warmup_options& warmup_options
+) {
+    try {
+        forward_index = std::make_unique<ForwardIndex>(forward_index_path, warmup_options);
+        posting_file = std::make_unique<PostingFile>(posting_file_path, warmup_options);
+    } catch (const std::runtime_error&) {
+        forward_index.reset();
+        posting_file.reset();
+        return false;
+    }
+    if (posting_file->getNumDocuments() != forward_index->getNumDocuments()
+        || posting_file->getVocabularySize() != forward_index->getVocabularySize()) {
+        forward_index.reset();
+        posting_file.reset();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Adds the contributions of a term to the accumulators of a search, both sorted by document
+ *
+ * @param scores Accumulators of the documents of the terms so far, replaced by those including the term's documents
+ * @param term_scores Contribution of the term to each of its documents
+ * @param merged Buffer for the new accumulators, left with the old ones
+*/
+static void addTermScores(
+    std::vector<scored_document>& scores,
+    const std::vector<scored_document>& term_scores,
+    std::vector<scored_document>& merged
+) {
+    merged.clear();
+    merged.reserve(scores.size() + term_scores.size());
+    auto score = scores.begin();
+    auto term_score = term_scores.begin();
+    while (score != scores.end() && term_score != term_scores.end()) {
+        if (score->first < term_score->first) {
+            merged.push_back(*score++);
+        } else if (term_score->first < score->first) {
+            merged.push_back(*term_score++);
+        } else {
+            merged.emplace_back(score->first, score->second + term_score->second);
+            score++;
+            term_score++;
+        }
+    }
+    merged.insert(merged.end(), score, scores.end());
+    merged.insert(merged.end(), term_score, term_scores.end());
+    scores.swap(merged);
+}
+
+AsyncTask<std::vector<scored_transcript>> DiskTfIdfSearch::searchAsync(
+    const std::vector<std::string> search_terms,
+    const unsigned int k,
+    const search_options options
+) {
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Keep the non stop word tokens of every search term, each once
+    std::vector<disk_term> query_terms;
+    std::set<token_id> seen;
+    auto included_terms = isBooleanQuery(search_terms) ? getIncludedTerms(search_terms) : search_terms;
+    for (auto& search_term : included_terms) {
+        for (auto& word : TranscriptTokenizer::tokenize(TranscriptTokenizer::normalize(search_term))) {
+            token_id token;
+            if (TranscriptTokenizer::isStopWord(word) || !forward_index->findToken(word, token)) {
+                continue;
+            }
+            uint32_t document_frequency = posting_file->getDocumentFrequency(token);
+            if (document_frequency > 0 && seen.insert(token).second) {
+                query_terms.push_back({token, inverseDocumentFrequency(posting_file->getNumDocuments(), document_frequency)});
+            }
+        }
+    }
+    // Scores add up the terms rarest first, like InMemoryTfIdfSearch does
+    std::stable_sort(query_terms.begin(), query_terms.end(), [](const disk_term& a, const disk_term& b) { return a.idf > b.idf; });
+
+    // Accumulators of the documents the terms appear in only, sorted by document, so that a search takes memory in
+    // proportion to the postings it reads rather than to the corpus: each term's contributions (in the document order
+    // of its postings) are merged into them once the term is read
+    std::vector<scored_document> scores;
+    std::vector<scored_document> term_scores;
+    std::vector<scored_document> merged;
+    std::vector<posting> block(postings_per_block);
+    for (auto& query_term : query_terms) {
+        term_scores.clear();
+        uint64_t position = posting_file->getFirstPosting(query_term.token);
+        uint64_t end = position + posting_file->getDocumentFrequency(query_term.token);
+        while (position < end && !interruption.check()) {
+            // Get the whole block holding the next posting, of which the term may only own a part
+            uint64_t block_start = position - position % postings_per_block;
+            const posting* block_postings = block.data();
+            size_t bytes;
+            PinnedBlock pinned;
+            if (buffer_pool) {
+                pinned = co_await buffer_pool->pin(block_start / postings_per_block, (end - 1) / postings_per_block);
+                block_postings = reinterpret_cast<const posting*>(pinned.getData());
+                bytes = pinned.getSize();
+            } else {
+                bytes = co_await posting_reader->read(
+                    posting_file->getPostingsOffset() + block_start * sizeof(posting), block.data(), posting_block_size
+                );
+            }
+            uint64_t block_end = std::min(end, block_start + postings_per_block);
+            if (block_end - block_start > bytes / sizeof(posting)) {
+                throw std::runtime_error("Error: posting file \"" + posting_reader->getPath() + "\" is truncated\n");
+            }
+            for (; position < block_end; position++) {
+                auto& entry = block_postings[position - block_start];
+                double tf = (1.0 * entry.frequency) / posting_file->getDocumentNumTerms(entry.document);
+                term_scores.emplace_back(entry.document, tf * query_term.idf);
+            }
+        }
+        addTermScores(scores, term_scores, merged);
+    }
+
+    TopKDocuments best_documents(k);
+    for (auto& [document, score] : scores) {
+        best_documents.push(document, score);
+    }
+
+    if (options.statistics) {
+        options.statistics->strategy = STRATEGY_TERM_AT_A_TIME;
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
+
+    std::vector<scored_transcript> best_matches;
+    for (auto& [document, score] : best_documents.getSortedDocuments()) {
+        best_matches.emplace_back(std::string(forward_index->getDocumentPath(document)), score);
+    }
+    co_return best_matches;
+}
+
+void DiskTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    getBestTranscriptMatches(search_terms, k, search_options(), best_matches);
+}
+
+void DiskTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    best_matches = scheduler->spawn(searchAsync(search_terms, k, options)).get();
+}
+
+// Runs a search of a batch, giving its slot back once it finishes
+static AsyncTask<std::vector<scored_transcript>> runInSlot(
+    AsyncTask<std::vector<scored_transcript>> search,
+    std::counting_semaphore<>& slots
+) {
+    std::vector<scored_transcript> best_matches;
+    try {
+        best_matches = co_await search;
+    } catch (...) {
+        slots.release();
+        throw;
+    }
+    slots.release();
+    co_return best_matches;
+}
+
+void DiskTfIdfSearch::getBatchTranscriptMatches(
+    const std::vector<std::vector<std::string>>& queries,
+    const unsigned int k,
+    const search_options& options,
+    const unsigned int num_threads,
+    std::vector<std::vector<scored_transcript>>& best_matches
+) {
+    search_options query_options = options;
+    query_options.statistics = nullptr;
+
+    // Searches start as earlier ones finish, at most `max_batch_searches` at once
+    std::counting_semaphore<> slots(max_batch_searches);
+    std::vector<std::future<std::vector<scored_transcript>>> results;
+    results.reserve(queries.size());
+    for (auto& query : queries) {
+        slots.acquire();
+        results.push_back(scheduler->spawn(runInSlot(searchAsync(query, k, query_options), slots)));
+    }
+
+    // Every search is waited for, even once one fails, as they read into their own frames
+    best_matches.assign(queries.size(), {});
+    std::exception_ptr failure;
+    for (size_t q = 0; q < queries.size(); q++) {
+        try {
+            best_matches[q] = results[q].get();
+        } catch (...) {
+            failure = failure ? failure : std::current_exception();
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+bool DiskTfIdfSearch::getBufferPoolStatistics(buffer_pool_statistics& statistics) {
+    if (!buffer_pool) {
+        return false;
+    }
+    statistics = buffer_pool->getStatistics();
+    return true;
+}
@@ -0,0 +1,124 @@
+#include "document_partitioned_tf_idf_search.h"
+#include "tf_idf_scoring.h"
+#include <algorithm>
+#include <future>
+#include <set>
+#include <stdexcept>
+
+// Local K-best of a shard, and how its scoring stopped
+struct shard_result {
+    std::vector<scored_transcript> best_matches;
+    bool interrupted;
+    bool cancelled;
+};
+
+DocumentPartitionedTfIdfSearch::DocumentPartitionedTfIdfSearch(
+    const std::string database_path,
+    const unsigned int num_partitions
+) {
+    if (num_partitions == 0) {
+        throw std::runtime_error("Error: number of partitions must be positive\n");
+    }
+
+    // Deal documents round-robin across the shards
+    std::vector<InvertedIndexBuilder> builders(num_partitions);
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builders[num_documents_total % num_partitions].addDocument(document);
+        num_documents_total++;
+    });
+
+    for (auto& builder : builders) {
+        shards.push_back(builder.build());
+        workers.push_back(std::make_unique<WorkerThread>());
+    }
+}
+
+void DocumentPartitionedTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(search_terms, k, search_options(), best_matches);
+}
+
+void DocumentPartitionedTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(getIncludedTerms(search_terms), k, options, best_matches);
+}
+
+void DocumentPartitionedTfIdfSearch::searchTerms(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Duplicate search terms only count once
+    std::set<std::string> unique_terms(search_terms.begin(), search_terms.end());
+
+    // Compute each term's corpus IDF from the sum of its per-shard document frequencies
+    std::vector<double> term_idfs;
+    for (auto& term : unique_terms) {
+        size_t num_documents_term = 0;
+        for (auto& shard : shards) {
+            term_id id;
+            if (shard->findTerm(term, id)) {
+                num_documents_term += shard->getDocumentFrequency(id);
+            }
+        }
+        term_idfs.push_back(num_documents_term > 0 ? inverseDocumentFrequency(num_documents_total, num_documents_term) : 0.0);
+    }
+
+    // Have every shard score its own documents and keep its local K-best (each shard checking for interruption on its own)
+    std::vector<std::future<shard_result>> shard_results;
+    for (size_t s = 0; s < shards.size(); s++) {
+        auto task = std::make_shared<std::packaged_task<shard_result()>>([&, s] {
+            const InvertedIndex& shard = *shards[s];
+            SearchInterruption interruption(options, start_time);
+
+            // Resolve the terms against this shard's dictionary
+            std::vector<weighted_term> query_terms;
+            size_t t = 0;
+            for (auto& term : unique_terms) {
+                term_id id;
+                if (shard.findTerm(term, id)) {
+                    query_terms.push_back({id, term_idfs[t]});
+                }
+                t++;
+            }
+
+            TopKDocuments best_documents(k);
+            scoreTermAtATime(shard, query_terms, interruption, best_documents);
+
+            shard_result result = {{}, interruption.isInterrupted(), interruption.isCancelled()};
+            for (auto& [document, score] : best_documents.getSortedDocuments()) {
+                result.best_matches.emplace_back(shard.getDocumentPath(document), score);
+            }
+            return result;
+        });
+        shard_results.push_back(task->get_future());
+        workers[s]->submit([task] { (*task)(); });
+    }
+
+    // Merge the local results into the global K-best
+    std::vector<scored_transcript> merged;
+    bool interrupted = false;
+    bool cancelled = false;
+    for (auto& future_result : shard_results) {
+        auto result = future_result.get();
+        merged.insert(merged.end(), result.best_matches.begin(), result.best_matches.end());
+        interrupted = interrupted || result.interrupted;
+        cancelled = cancelled || result.cancelled;
+    }
+    keepBestTranscripts(merged, k);
+    if (options.statistics) {
+        options.statistics->approximate = interrupted && !cancelled;
+        options.statistics->cancelled = cancelled;
+    }
+    best_matches = std::move(merged);
+}
@@ -0,0 +1,85 @@
+#include "epoch_manager.h"
+#include <algorithm>
+#include <thread>
+
+EpochManager::Guard::Guard(EpochManager* manager, size_t slot) : manager(manager), slot(slot) {}
+
+EpochManager::Guard::Guard(Guard&& other) noexcept : manager(other.manager), slot(other.slot) {
+    other.manager = nullptr;
+}
+
+EpochManager::Guard::~Guard() {
+    if (manager) {
+        manager->leave(slot);
+    }
+}
+
+EpochManager::Guard EpochManager::enter() {
+    // Start probing from a per-thread hint so that threads tend to reuse uncontended slots
+    static thread_local size_t slot_hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+    size_t slot = slot_hint % max_readers;
+    while (true) {
+        bool expected = false;
+        if (!slots[slot].claimed.load(std::memory_order_relaxed) &&
+            slots[slot].claimed.compare_exchange_weak(expected, true, std::memory_order_acquire)) {
+            break;
+        }
+        slot = (slot + 1) % max_readers;
+        if (slot == slot_hint % max_readers) {
+            // Every slot is taken, wait for a reader to leave
+            std::this_thread::yield();
+        }
+    }
+    slot_hint = slot;
+
+    // Announce the epoch, making sure it is still current once the announcement is visible to writers
+    uint64_t epoch = global_epoch.load();
+    while (true) {
+        slots[slot].epoch.store(epoch);
+        uint64_t current_epoch = global_epoch.load();
+        if (current_epoch == epoch) {
+            break;
+        }
+        epoch = current_epoch;
+    }
+    return Guard(this, slot);
+}
+
+void EpochManager::leave(const size_t slot) {
+    slots[slot].epoch.store(idle_epoch, std::memory_order_release);
+    slots[slot].claimed.store(false, std::memory_order_release);
+}
+
+void EpochManager::retire(std::function<void()> deleter) {
+    // Readers which entered at or before this epoch may still hold the object; later readers cannot reach it
+    uint64_t retire_epoch = global_epoch.fetch_add(1);
+    retired.emplace_back(retire_epoch, std::move(deleter));
+}
+
+size_t EpochManager::reclaim() {
+    // Find the oldest epoch any active reader is in
+    uint64_t oldest_active_epoch = idle_epoch;
+    for (auto& slot : slots) {
+        oldest_active_epoch = std::min(oldest_active_epoch, slot.epoch.load());
+    }
+
+    // Free everything retired before that epoch
+    size_t num_freed = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++) {
+        if (retired[i].first < oldest_active_epoch) {
+            retired[i].second();
+            num_freed++;
+        } else {
+            retired[kept++] = std::move(retired[i]);
+        }
+    }
+    retired.resize(kept);
+    return num_freed;
+}
+
+EpochManager::~EpochManager() {
+    for (auto& [retire_epoch, deleter] : retired) {
+        deleter();
+    }
+}
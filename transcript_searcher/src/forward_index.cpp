@@ -0,0 +1,177 @@
+#include "forward_index.h"
+#include "transcript_tokenizer.h"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+// How a forward index reads each of its sections
+static const section_profile forward_index_profiles[] = {
+    {FORWARD_VOCABULARY_OFFSETS, SECTION_ACCESS_RANDOM, true, true},
+    {FORWARD_VOCABULARY, SECTION_ACCESS_RANDOM, true, true},
+    {FORWARD_TOKEN_HASH_SEED, SECTION_ACCESS_RANDOM, true, true},
+    {FORWARD_TOKEN_HASH_PILOTS, SECTION_ACCESS_RANDOM, true, true},
+    {FORWARD_TOKEN_SLOTS, SECTION_ACCESS_RANDOM, true, true},
+    {FORWARD_PATH_OFFSETS, SECTION_ACCESS_RANDOM, true, false},
+    {FORWARD_TOKEN_OFFSETS, SECTION_ACCESS_RANDOM, true, false},
+    {FORWARD_TEXT_OFFSETS, SECTION_ACCESS_RANDOM, false, false},
+    {FORWARD_PATHS, SECTION_ACCESS_RANDOM, false, false},
+    {FORWARD_TEXT, SECTION_ACCESS_RANDOM, false, false},
+    {FORWARD_TOKENS, SECTION_ACCESS_SEQUENTIAL, false, false},
+    {FORWARD_TOKEN_TEXT_OFFSETS, SECTION_ACCESS_SEQUENTIAL, false, false}
+};
+
+ForwardIndex::ForwardIndex(const std::string& path, const index_warmup_options& warmup_options) {
+    file = std::make_unique<IndexFile>(path);
+    // Before the sections are fetched, as the dictionary may be moved to huge pages
+    warmup = std::make_unique<IndexWarmup>(*file, forward_index_profiles, warmup_options);
+    vocabulary_offsets = file->getSection<uint64_t>(FORWARD_VOCABULARY_OFFSETS);
+    vocabulary = file->getSection<char>(FORWARD_VOCABULARY);
+    path_offsets = file->getSection<uint64_t>(FORWARD_PATH_OFFSETS);
+    paths = file->getSection<char>(FORWARD_PATHS);
+    token_offsets = file->getSection<uint64_t>(FORWARD_TOKEN_OFFSETS);
+    tokens = file->getSection<token_id>(FORWARD_TOKENS);
+    token_text_offsets = file->getSection<uint32_t>(FORWARD_TOKEN_TEXT_OFFSETS);
+    text_offsets = file->getSection<uint64_t>(FORWARD_TEXT_OFFSETS);
+    text = file->getSection<char>(FORWARD_TEXT);
+
+    if (vocabulary_offsets.empty() || path_offsets.empty() || token_offsets.size() != path_offsets.size()
+        || text_offsets.size() != path_offsets.size() || token_text_offsets.size() != tokens.size()) {
+        throw std::runtime_error("Error: \"" + path + "\" is not a valid forward index\n");
+    }
+
+    if (file->hasSection(FORWARD_TOKEN_SLOTS) && getVocabularySize() > 0) {
+        auto seed = file->getSection<uint64_t>(FORWARD_TOKEN_HASH_SEED);
+        token_slots = file->getSection<token_slot>(FORWARD_TOKEN_SLOTS);
+        if (seed.size() != 1 || token_slots.size() != getVocabularySize()) {
+            throw std::runtime_error("Error: \"" + path + "\" is not a valid forward index\n");
+        }
+        token_hash = std::make_unique<MinimalPerfectHash>(seed[0], getVocabularySize(), file->getSection<uint32_t>(FORWARD_TOKEN_HASH_PILOTS));
+    }
+}
+
+// Fingerprint of a token, the high half of its hash
+static uint32_t tokenFingerprint(const uint64_t token_hash) {
+    return static_cast<uint32_t>(token_hash >> 32);
+}
+
+bool ForwardIndex::findToken(const std::string_view token, token_id& id) const {
+    // One hash and one slot; the token itself is only compared when the fingerprint matches
+    if (token_hash) {
+        uint64_t hash = MinimalPerfectHash::hash(token, token_hash->getSeed());
+        const token_slot& slot = token_slots[token_hash->getSlot(hash)];
+        if (slot.fingerprint != tokenFingerprint(hash) || getToken(slot.token) != token) {
+            return false;
+        }
+        id = slot.token;
+        return true;
+    }
+
+    // Binary search the sorted vocabulary in place
+    size_t low = 0;
+    size_t high = getVocabularySize();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (getToken(middle) < token) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < getVocabularySize() && getToken(low) == token) {
+        id = static_cast<token_id>(low);
+        return true;
+    }
+    return false;
+}
+
+// Appends a string to a concatenation, recording its end offset
+static void appendString(const std::string_view value, std::vector<char>& blob, std::vector<uint64_t>& offsets) {
+    blob.insert(blob.end(), value.begin(), value.end());
+    offsets.push_back(blob.size());
+}
+
+void ForwardIndex::build(const std::string& database_path, const std::string& path) {
+    std::vector<char> paths;
+    std::vector<uint64_t> path_offsets = {0};
+    std::vector<token_id> tokens;
+    std::vector<uint64_t> token_offsets = {0};
+    std::vector<uint32_t> token_text_offsets;
+    std::vector<char> text;
+    std::vector<uint64_t> text_offsets = {0};
+
+    // Tokenize every transcription, numbering tokens in order of first appearance for now
+    std::unordered_map<std::string, token_id> first_appearance_ids;
+    std::vector<std::string> first_appearance_vocabulary;
+    {
+        SQLite::Database db(database_path);
+        SQLite::Statement documents_query(db, "SELECT file, transcription FROM documents");
+        std::vector<std::string> document_tokens;
+        std::vector<uint32_t> document_offsets;
+        while (documents_query.executeStep()) {
+            std::string transcription = documents_query.getColumn(1).getString();
+            TranscriptTokenizer::tokenize(transcription, document_tokens, document_offsets);
+            for (auto& token : document_tokens) {
+                auto [it, inserted] = first_appearance_ids.emplace(token, static_cast<token_id>(first_appearance_vocabulary.size()));
+                if (inserted) {
+                    first_appearance_vocabulary.push_back(token);
+                }
+                tokens.push_back(it->second);
+            }
+            token_text_offsets.insert(token_text_offsets.end(), document_offsets.begin(), document_offsets.end());
+            token_offsets.push_back(tokens.size());
+
+            appendString(documents_query.getColumn(0).getString(), paths, path_offsets);
+            appendString(transcription, text, text_offsets);
+        }
+    }
+
+    // Sort the vocabulary and renumber the tokens accordingly
+    std::vector<token_id> order(first_appearance_vocabulary.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](token_id a, token_id b) {
+        return first_appearance_vocabulary[a] < first_appearance_vocabulary[b];
+    });
+    std::vector<token_id> sorted_ids(order.size());
+    std::vector<char> vocabulary;
+    std::vector<uint64_t> vocabulary_offsets = {0};
+    for (token_id sorted_id = 0; sorted_id < order.size(); sorted_id++) {
+        sorted_ids[order[sorted_id]] = sorted_id;
+        appendString(first_appearance_vocabulary[order[sorted_id]], vocabulary, vocabulary_offsets);
+    }
+    for (auto& token : tokens) {
+        token = sorted_ids[token];
+    }
+
+    // Hash every token to its own slot
+    std::vector<std::string_view> keys;
+    for (token_id token = 0; token < order.size(); token++) {
+        keys.emplace_back(vocabulary.data() + vocabulary_offsets[token], vocabulary_offsets[token + 1] - vocabulary_offsets[token]);
+    }
+    uint64_t seed = 0;
+    std::vector<uint32_t> pilots;
+    std::vector<token_slot> slots(keys.size());
+    MinimalPerfectHash::build(keys, seed, pilots);
+    if (!keys.empty()) {
+        MinimalPerfectHash token_hash(seed, keys.size(), pilots);
+        for (token_id token = 0; token < keys.size(); token++) {
+            uint64_t hash = MinimalPerfectHash::hash(keys[token], seed);
+            slots[token_hash.getSlot(hash)] = {token, tokenFingerprint(hash)};
+        }
+    }
+
+    IndexFileWriter writer(path);
+    writer.addSection(FORWARD_VOCABULARY_OFFSETS, vocabulary_offsets);
+    writer.addSection(FORWARD_VOCABULARY, vocabulary);
+    writer.addSection(FORWARD_PATH_OFFSETS, path_offsets);
+    writer.addSection(FORWARD_PATHS, paths);
+    writer.addSection(FORWARD_TOKEN_OFFSETS, token_offsets);
+    writer.addSection(FORWARD_TOKENS, tokens);
+    writer.addSection(FORWARD_TOKEN_TEXT_OFFSETS, token_text_offsets);
+    writer.addSection(FORWARD_TEXT_OFFSETS, text_offsets);
+    writer.addSection(FORWARD_TEXT, text);
+    writer.addSection(FORWARD_TOKEN_HASH_SEED, std::vector<uint64_t>{seed});
+    writer.addSection(FORWARD_TOKEN_HASH_PILOTS, pilots);
+    writer.addSection(FORWARD_TOKEN_SLOTS, slots);
+    writer.finish();
+}
@@ -0,0 +1,117 @@
+#include "fuzzy_term_index.h"
+#include <algorithm>
+#include <numeric>
+
+// Number of leading characters of a word whose deletions are indexed
+static const size_t prefix_length = 7;
+
+// 32-bit FNV-1a hash of a deletion
+static uint32_t hashDeletion(std::string_view deletion) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : deletion) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+template <typename Callback>
+void FuzzyTermIndex::forEachDeletion(std::string_view word, const unsigned int max_deletions, Callback on_deletion) {
+    // Deletions one level at a time, each level made by deleting one more character from the one before
+    std::vector<std::string> deletions{std::string(word.substr(0, prefix_length))};
+    size_t level_begin = 0;
+    for (unsigned int level = 0; level < max_deletions; level++) {
+        size_t level_end = deletions.size();
+        for (size_t d = level_begin; d < level_end; d++) {
+            for (size_t c = 0; c < deletions[d].size(); c++) {
+                std::string deletion = deletions[d];
+                deletion.erase(c, 1);
+                deletions.push_back(std::move(deletion));
+            }
+        }
+        level_begin = level_end;
+    }
+
+    std::sort(deletions.begin(), deletions.end());
+    deletions.erase(std::unique(deletions.begin(), deletions.end()), deletions.end());
+    for (auto& deletion : deletions) {
+        on_deletion(deletion);
+    }
+}
+
+FuzzyTermIndex::FuzzyTermIndex(const InvertedIndex& index, const unsigned int max_distance)
+    : index(index), max_distance(max_distance) {
+    std::vector<std::pair<uint32_t, term_id>> deletions;
+    for (term_id term = 0; term < index.getNumTerms(); term++) {
+        forEachDeletion(index.getTerm(term), max_distance, [&](const std::string& deletion) {
+            deletions.emplace_back(hashDeletion(deletion), term);
+        });
+    }
+    std::sort(deletions.begin(), deletions.end());
+
+    deletion_hashes.reserve(deletions.size());
+    deletion_terms.reserve(deletions.size());
+    for (auto& [hash, term] : deletions) {
+        deletion_hashes.push_back(hash);
+        deletion_terms.push_back(term);
+    }
+}
+
+void FuzzyTermIndex::findTerms(const std::string& word, const unsigned int max_distance, std::vector<fuzzy_match>& matches) const {
+    unsigned int distance_bound = std::min(max_distance, this->max_distance);
+
+    // Every term sharing a deletion with the word is a candidate
+    std::vector<term_id> candidates;
+    forEachDeletion(word, distance_bound, [&](const std::string& deletion) {
+        auto range = std::equal_range(deletion_hashes.begin(), deletion_hashes.end(), hashDeletion(deletion));
+        for (auto it = range.first; it != range.second; it++) {
+            candidates.push_back(deletion_terms[it - deletion_hashes.begin()]);
+        }
+    });
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Shared deletions only bound the distance (and hashes may collide), so verify each candidate
+    matches.clear();
+    for (auto term : candidates) {
+        const std::string& candidate = index.getTerm(term);
+        size_t length_difference = candidate.size() > word.size() ? candidate.size() - word.size() : word.size() - candidate.size();
+        if (length_difference > distance_bound) {
+            continue;
+        }
+        unsigned int distance = editDistance(word, candidate, distance_bound);
+        if (distance <= distance_bound) {
+            matches.push_back({term, distance});
+        }
+    }
+    std::stable_sort(matches.begin(), matches.end(), [](const fuzzy_match& a, const fuzzy_match& b) {
+        return a.distance < b.distance;
+    });
+}
+
+unsigned int FuzzyTermIndex::editDistance(std::string_view a, std::string_view b, const unsigned int max_distance) {
+    // Three rows of the dynamic programming table, as transpositions look two rows back
+    std::vector<unsigned int> before_previous(b.size() + 1);
+    std::vector<unsigned int> previous(b.size() + 1);
+    std::vector<unsigned int> current(b.size() + 1);
+    std::iota(previous.begin(), previous.end(), 0u);
+
+    for (size_t i = 1; i <= a.size(); i++) {
+        current[0] = i;
+        unsigned int row_minimum = current[0];
+        for (size_t j = 1; j <= b.size(); j++) {
+            unsigned int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+                current[j] = std::min(current[j], before_previous[j - 2] + 1);
+            }
+            row_minimum = std::min(row_minimum, current[j]);
+        }
+        // Distances never decrease from one row to the next
+        if (row_minimum > max_distance) {
+            return max_distance + 1;
+        }
+        std::swap(before_previous, previous);
+        std::swap(previous, current);
+    }
+    return std::min(previous[b.size()], max_distance + 1);
+}
@@ -0,0 +1,22 @@
+#include "impact_ordered_index.h"
+#include <algorithm>
+
+ImpactOrderedIndex::ImpactOrderedIndex(const InvertedIndex& index) {
+    posting_offsets.reserve(index.getNumTerms() + 1);
+    posting_offsets.push_back(0);
+    for (term_id term = 0; term < index.getNumTerms(); term++) {
+        auto term_postings = index.getPostings(term);
+        postings.insert(postings.end(), term_postings.begin(), term_postings.end());
+        posting_offsets.push_back(postings.size());
+        sortByImpact(index, std::span<posting>(postings.data() + posting_offsets[term], postings.data() + posting_offsets[term + 1]));
+    }
+}
+
+void ImpactOrderedIndex::sortByImpact(const InvertedIndex& index, std::span<posting> postings) {
+    // Compares a / m against b / n as a * n against b * m, so that equal frequencies compare equal
+    std::sort(postings.begin(), postings.end(), [&index](const posting& a, const posting& b) {
+        uint64_t impact_a = static_cast<uint64_t>(a.frequency) * index.getDocumentNumTerms(b.document);
+        uint64_t impact_b = static_cast<uint64_t>(b.frequency) * index.getDocumentNumTerms(a.document);
+        return impact_a != impact_b ? impact_a > impact_b : a.document < b.document;
+    });
+}
@@ -0,0 +1,1377 @@
+#include "in_memory_tf_idf_search.h"
+#include "boolean_query.h"
+#include "galloping_search.h"
+#include "snippet_extraction.h"
+#include "tf_idf_scoring.h"
+#include "transcript_tokenizer.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+// Term of a token which is not in the inverted index (e.g. a stop word)
+static const term_id no_term = std::numeric_limits<term_id>::max();
+
+// Number of results from which snippets are extracted on several threads
+static const size_t parallel_snippet_results = 32;
+
+// Number of completions precomputed per prefix
+static const unsigned int max_completions = 10;
+
+// Largest number of terms a wildcard or a substring expands to
+static const size_t max_expanded_terms = 1024;
+
+// Largest edit distance of fuzzy matches the fuzzy term index supports
+static const unsigned int max_fuzzy_distance = 2;
+
+// Costs of the query planner, relative to accumulating one posting term at a time: clearing and collecting one
+// document's accumulator, moving a WAND cursor over one posting, skipping one cursor to a pivot, and comparing one
+// token of the forward index against the query
+static const double accumulator_cost = 0.2;
+static const double wand_posting_cost = 4.0;
+static const double wand_skip_cost = 1.0;
+static const double scan_token_cost = 0.4;
+
+// Number of postings of a unit accumulated at once score at a time, between which the next unit is chosen
+static const size_t impact_block_size = 64;
+
+// Number of postings accumulated score at a time before first checking whether the K-best are known (then at every
+// doubling, so that checks cost at most as much again as the accumulation)
+static const size_t first_termination_check = 256;
+
+// Time taken per candidate to select the K-best once a search runs out of time, which it sets aside out of its budget
+static const std::chrono::nanoseconds candidate_selection_time{6};
+
+// Number of accumulators of a block, whose largest value is found before comparing any of them to the K-best
+static const size_t accumulator_block_size = 64;
+
+// Number of WAND pivots between such checks, fewer since a pivot may gallop through many postings
+static const size_t pivot_check_interval = 256;
+
+// Number of accumulators (one per query and document) of a batch's block of documents, so that they stay in cache
+static const size_t batch_accumulator_budget = 1 << 17;
+
+// Fewest documents of a batch's block, so that posting lists are still gone through in runs with many queries
+static const size_t min_batch_block_documents = 64;
+
+/**
+ * Adds up the quantized impacts of the units' postings into an integer accumulator per document, and selects the
+ * documents with the K largest sums
+ *
+ * @param unit_postings Postings of each unit
+ * @param unit_impacts Impact of each posting of each unit
+ * @param num_documents Number of documents in the index
+ * @param k Number of documents to select
+ * @param interruption Stops the accumulation early, the K-best being selected from the sums so far
+ * @param best Appended with the K-best documents (ties going to the lower document id)
+*/
+template <typename Accumulator, typename Impact>
+static void selectByImpacts(
+    const std::vector<std::span<const posting>>& unit_postings,
+    const std::vector<std::span<const Impact>>& unit_impacts,
+    const size_t num_documents,
+    const unsigned int k,
+    SearchInterruption& interruption,
+    std::vector<document_id>& best
+) {
+    size_t num_blocks = (num_documents + accumulator_block_size - 1) / accumulator_block_size;
+    std::vector<Accumulator> accumulators(num_blocks * accumulator_block_size, 0);
+    for (size_t u = 0; u < unit_postings.size(); u++) {
+        auto postings = unit_postings[u];
+        auto impacts = unit_impacts[u];
+        for (size_t block = 0; block < postings.size() && !interruption.check(); block += interruption_check_interval) {
+            size_t end = std::min(postings.size(), block + interruption_check_interval);
+            for (size_t p = block; p < end; p++) {
+                accumulators[postings[p].document] += impacts[p];
+            }
+        }
+    }
+
+    // Heap of the K-best sums, the worst on top. A block is skipped whole unless its largest sum (found by a loop
+    // free of branches, which the compiler vectorizes) beats the worst of the K-best.
+    typedef std::pair<Accumulator, document_id> scored_accumulator;
+    auto better = [](const scored_accumulator& a, const scored_accumulator& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    std::vector<scored_accumulator> heap;
+    Accumulator threshold = 0;
+    for (size_t block = 0; block < accumulators.size(); block += accumulator_block_size) {
+        Accumulator block_max = 0;
+        for (size_t i = block; i < block + accumulator_block_size; i++) {
+            block_max = std::max(block_max, accumulators[i]);
+        }
+        if (block_max <= threshold) {
+            continue;
+        }
+        for (size_t i = block; i < block + accumulator_block_size; i++) {
+            if (accumulators[i] <= threshold) {
+                continue;
+            }
+            heap.emplace_back(accumulators[i], static_cast<document_id>(i));
+            std::push_heap(heap.begin(), heap.end(), better);
+            if (heap.size() > k) {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.pop_back();
+            }
+            if (heap.size() == k) {
+                threshold = heap.front().first;
+            }
+        }
+    }
+    for (auto& [sum, document] : heap) {
+        best.push_back(document);
+    }
+}
+
+// Largest edit distance worth matching for a word of a given length, so that short words don't match half the dictionary
+static unsigned int fuzzyDistanceBound(const std::string& word) {
+    if (word.size() <= 2) {
+        return 0;
+    }
+    return word.size() <= 5 ? 1 : max_fuzzy_distance;
+}
+
+/**
+ * Merges the posting lists of several terms into a single list, as if they were one term, by summing the
+ * frequencies of each document's postings
+*/
+static std::vector<posting> mergePostingLists(const InvertedIndex& index, std::span<const term_id> terms) {
+    // Min-heap of the next posting of each list, by document id
+    typedef std::pair<std::span<const posting>::iterator, std::span<const posting>::iterator> list_cursor;
+    auto later = [](const list_cursor& a, const list_cursor& b) { return a.first->document > b.first->document; };
+    std::vector<list_cursor> cursors;
+    size_t num_postings = 0;
+    for (auto term : terms) {
+        auto postings = index.getPostings(term);
+        if (!postings.empty()) {
+            cursors.emplace_back(postings.begin(), postings.end());
+            num_postings += postings.size();
+        }
+    }
+    std::make_heap(cursors.begin(), cursors.end(), later);
+
+    std::vector<posting> merged;
+    merged.reserve(num_postings);
+    while (!cursors.empty()) {
+        std::pop_heap(cursors.begin(), cursors.end(), later);
+        auto& cursor = cursors.back();
+        if (!merged.empty() && merged.back().document == cursor.first->document) {
+            merged.back().frequency += cursor.first->frequency;
+        } else {
+            merged.push_back(*cursor.first);
+        }
+        if (++cursor.first == cursor.second) {
+            cursors.pop_back();
+        } else {
+            std::push_heap(cursors.begin(), cursors.end(), later);
+        }
+    }
+    return merged;
+}
+
+// Keeps the most frequent of a wildcard or substring's terms, which make up most of the postings anyway
+static void keepMostFrequentTerms(const InvertedIndex& index, std::vector<term_id>& terms) {
+    if (terms.size() > max_expanded_terms) {
+        std::nth_element(terms.begin(), terms.begin() + max_expanded_terms, terms.end(), [&index](term_id a, term_id b) {
+            return index.getDocumentFrequency(a) > index.getDocumentFrequency(b);
+        });
+        terms.resize(max_expanded_terms);
+        std::sort(terms.begin(), terms.end());
+    }
+}
+
+InMemoryTfIdfSearch::InMemoryTfIdfSearch(const std::string database_path, const index_warmup_options& warmup_options) {
+    std::string forward_index_path = database_path + ".forward";
+    if (!loadIndexes(database_path, forward_index_path, warmup_options)) {
+        ForwardIndex::build(database_path, forward_index_path);
+        if (!loadIndexes(database_path, forward_index_path, warmup_options)) {
+            throw std::runtime_error("Error: forward index \"" + forward_index_path + "\" does not match the database\n");
+        }
+    }
+}
+
+bool InMemoryTfIdfSearch::loadIndexes(
+    const std::string& database_path,
+    const std::string& forward_index_path,
+    const index_warmup_options& warmup_options
+) {
+    try {
+        forward_index = std::make_unique<ForwardIndex>(forward_index_path, warmup_options);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+
+    // Slot of each token in the current document's term list, or -1
+    std::vector<int64_t> term_slots(forward_index->getVocabularySize(), -1);
+    std::vector<token_id> slotted_tokens;
+
+    InvertedIndexBuilder builder;
+    bool matches = true;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& database_document) {
+        document_id id = static_cast<document_id>(builder.getNumDocuments());
+        if (!matches || id >= forward_index->getNumDocuments() || forward_index->getDocumentPath(id) != database_document.path) {
+            matches = false;
+            return;
+        }
+
+        // Collect each term's positions with a single scan of the document's tokens
+        indexed_document document = database_document;
+        document.term_positions.resize(document.term_frequencies.size());
+        for (size_t t = 0; t < document.term_frequencies.size(); t++) {
+            token_id token;
+            if (forward_index->findToken(document.term_frequencies[t].first, token)) {
+                term_slots[token] = t;
+                slotted_tokens.push_back(token);
+            }
+        }
+        auto tokens = forward_index->getTokens(id);
+        for (uint32_t position = 0; position < tokens.size(); position++) {
+            if (term_slots[tokens[position]] >= 0) {
+                document.term_positions[term_slots[tokens[position]]].push_back(position);
+            }
+        }
+        for (auto token : slotted_tokens) {
+            term_slots[token] = -1;
+        }
+        slotted_tokens.clear();
+
+        builder.addDocument(document);
+    });
+    if (!matches || builder.getNumDocuments() != forward_index->getNumDocuments()) {
+        forward_index.reset();
+        return false;
+    }
+
+    index = builder.build();
+    token_terms.assign(forward_index->getVocabularySize(), no_term);
+    for (term_id term = 0; term < index->getNumTerms(); term++) {
+        token_id token;
+        if (forward_index->findToken(index->getTerm(term), token)) {
+            token_terms[token] = term;
+        }
+    }
+    impact_index = std::make_unique<ImpactOrderedIndex>(*index);
+    phonetic_index = std::make_unique<PhoneticIndex>(*index);
+    completion_trie = std::make_unique<CompletionTrie>(*index, max_completions);
+    document_ids.clear();
+    for (document_id document = 0; document < forward_index->getNumDocuments(); document++) {
+        document_ids.emplace(forward_index->getDocumentPath(document), document);
+    }
+    return true;
+}
+
+const FuzzyTermIndex& InMemoryTfIdfSearch::getFuzzyIndex() const {
+    std::call_once(fuzzy_index_built, [this] {
+        fuzzy_index = std::make_unique<FuzzyTermIndex>(*index, max_fuzzy_distance);
+    });
+    return *fuzzy_index;
+}
+
+void InMemoryTfIdfSearch::buildTrigramIndexes() const {
+    std::call_once(trigram_indexes_built, [this] {
+        term_trigrams = std::make_unique<TrigramIndex>(index->getNumTerms(), [this](uint32_t term) {
+            return std::string_view(index->getTerm(term));
+        });
+        path_trigrams = std::make_unique<TrigramIndex>(forward_index->getNumDocuments(), [this](uint32_t document) {
+            return forward_index->getDocumentPath(document);
+        });
+    });
+}
+
+template <typename Impact>
+const QuantizedImpactIndex<Impact>& InMemoryTfIdfSearch::getQuantizedImpacts() const {
+    if constexpr (std::is_same_v<Impact, uint8_t>) {
+        std::call_once(impacts_8bit_built, [this] {
+            impacts_8bit = std::make_unique<QuantizedImpactIndex<uint8_t>>(*index);
+        });
+        return *impacts_8bit;
+    } else {
+        std::call_once(impacts_16bit_built, [this] {
+            impacts_16bit = std::make_unique<QuantizedImpactIndex<uint16_t>>(*index);
+        });
+        return *impacts_16bit;
+    }
+}
+
+bool InMemoryTfIdfSearch::resolvePhrase(query_unit& unit, const std::vector<uint32_t>& offsets) const {
+    for (size_t w = 0; w < unit.words.size(); w++) {
+        token_id token = 0;
+        if (!forward_index->findToken(unit.words[w], token) || token_terms[token] == no_term) {
+            return false;
+        }
+        term_id id = token_terms[token];
+        unit.phrase.push_back({id, offsets[w]});
+        unit.forward_phrase.push_back({token, offsets[w]});
+    }
+
+    if (unit.phrase.size() == 1) {
+        unit.postings = index->getPostings(unit.phrase[0].term);
+    } else {
+        unit.phrase_postings = matchPhrase(*index, unit.phrase);
+        unit.postings = std::span<const posting>(unit.phrase_postings);
+    }
+    if (unit.postings.empty()) {
+        return false;
+    }
+    unit.idf = inverseDocumentFrequency(index->getNumDocuments(), unit.postings.size());
+    return true;
+}
+
+bool InMemoryTfIdfSearch::resolveSoundAlikes(query_unit& unit) const {
+    auto sound_alikes = phonetic_index->findTerms(unit.words[0]);
+    if (sound_alikes.empty()) {
+        return false;
+    }
+
+    // Proximity looks for the word itself if the transcripts contain it, otherwise for its first sound-alike
+    token_id token;
+    if (!forward_index->findToken(unit.words[0], token) && !forward_index->findToken(index->getTerm(sound_alikes[0]), token)) {
+        return false;
+    }
+    unit.phrase.push_back({sound_alikes[0], 0});
+    unit.forward_phrase.push_back({token, 0});
+    unit.countable = false;
+
+    if (sound_alikes.size() == 1) {
+        unit.postings = index->getPostings(sound_alikes[0]);
+    } else {
+        unit.phrase_postings = mergePostingLists(*index, sound_alikes);
+        unit.postings = std::span<const posting>(unit.phrase_postings);
+    }
+    unit.idf = inverseDocumentFrequency(index->getNumDocuments(), unit.postings.size());
+    return true;
+}
+
+void InMemoryTfIdfSearch::findWildcardTerms(const std::string& prefix, std::vector<term_id>& terms) const {
+    auto [begin, end] = completion_trie->getPrefixRange(prefix);
+    terms.clear();
+    for (term_id term = begin; term < end; term++) {
+        terms.push_back(term);
+    }
+    keepMostFrequentTerms(*index, terms);
+}
+
+void InMemoryTfIdfSearch::findSubstringTerms(const std::string& substring, std::vector<term_id>& terms) const {
+    buildTrigramIndexes();
+    std::vector<uint32_t> matches;
+    term_trigrams->findSubstring(substring, matches);
+    terms.assign(matches.begin(), matches.end());
+    keepMostFrequentTerms(*index, terms);
+}
+
+bool InMemoryTfIdfSearch::resolveSubstring(const std::string& substring, query_unit& unit) const {
+    // Terms are normalized, paths are matched as typed (ignoring case)
+    std::vector<term_id> terms;
+    std::vector<uint32_t> paths;
+    findSubstringTerms(TranscriptTokenizer::normalize(substring), terms);
+    path_trigrams->findSubstring(substring, paths);
+    if (terms.empty() && paths.empty()) {
+        return false;
+    }
+
+    // Proximity looks for the first matching term; a substring only found in paths has nothing to look for
+    unit.countable = false;
+    token_id token;
+    if (!terms.empty() && forward_index->findToken(index->getTerm(terms[0]), token)) {
+        unit.phrase.push_back({terms[0], 0});
+        unit.forward_phrase.push_back({token, 0});
+    }
+
+    // A path containing the substring counts as one more occurrence in its transcript
+    auto term_postings = mergePostingLists(*index, terms);
+    auto term_posting = term_postings.begin();
+    for (auto path : paths) {
+        for (; term_posting != term_postings.end() && term_posting->document < path; term_posting++) {
+            unit.phrase_postings.push_back(*term_posting);
+        }
+        if (term_posting != term_postings.end() && term_posting->document == path) {
+            unit.phrase_postings.push_back({path, term_posting->frequency + 1});
+            term_posting++;
+        } else {
+            unit.phrase_postings.push_back({path, 1});
+        }
+    }
+    unit.phrase_postings.insert(unit.phrase_postings.end(), term_posting, term_postings.end());
+    unit.postings = std::span<const posting>(unit.phrase_postings);
+    unit.idf = inverseDocumentFrequency(index->getNumDocuments(), unit.postings.size());
+    return true;
+}
+
+void InMemoryTfIdfSearch::resolveTerm(const std::string& search_term, const search_options& options, std::vector<query_unit>& units) const {
+    // A single word starting with `~` matches the terms and the paths containing it (checked before normalizing drops the `~`)
+    bool has_whitespace = TranscriptTokenizer::hasWhitespace(search_term);
+    if (search_term.size() > 1 && search_term[0] == '~' && !has_whitespace) {
+        query_unit unit;
+        unit.words = {search_term};
+        if (resolveSubstring(search_term.substr(1), unit)) {
+            units.push_back(std::move(unit));
+        }
+        return;
+    }
+
+    // A single word ending with a wildcard matches all the terms starting with it, as one merged posting list
+    bool is_wildcard = !search_term.empty() && search_term.back() == '*' && !has_whitespace;
+    if (is_wildcard) {
+        std::string prefix = TranscriptTokenizer::normalize(search_term);
+        std::vector<term_id> terms;
+        token_id token;
+        if (prefix.empty()) {
+            return;
+        }
+        findWildcardTerms(prefix, terms);
+        if (terms.empty() || !forward_index->findToken(index->getTerm(terms[0]), token)) {
+            return;
+        }
+
+        query_unit unit;
+        unit.words = {prefix + "*"};
+        unit.countable = false;
+        unit.phrase.push_back({terms[0], 0});
+        unit.forward_phrase.push_back({token, 0});
+        unit.phrase_postings = mergePostingLists(*index, terms);
+        unit.postings = std::span<const posting>(unit.phrase_postings);
+        unit.idf = inverseDocumentFrequency(index->getNumDocuments(), unit.postings.size());
+        units.push_back(std::move(unit));
+        return;
+    }
+
+    // Keep the non stop word tokens, and their offsets relative to the first kept one
+    auto tokens = TranscriptTokenizer::tokenize(TranscriptTokenizer::normalize(search_term));
+    std::vector<std::string> words;
+    std::vector<uint32_t> offsets;
+    for (uint32_t offset = 0; offset < tokens.size(); offset++) {
+        if (!TranscriptTokenizer::isStopWord(tokens[offset])) {
+            words.push_back(tokens[offset]);
+            offsets.push_back(offset);
+        }
+    }
+    if (words.empty()) {
+        return;
+    }
+    uint32_t first_offset = offsets[0];
+    for (auto& offset : offsets) {
+        offset -= first_offset;
+    }
+
+    query_unit unit;
+    unit.words = std::move(words);
+
+    // A single word may stand for all the terms which sound like it, as one merged posting list
+    if (unit.words.size() == 1 && options.phonetic && resolveSoundAlikes(unit)) {
+        units.push_back(std::move(unit));
+        return;
+    }
+
+    // A single word also matches the terms a few typos away, weighted down by their distance
+    unsigned int distance_bound = std::min(options.max_edit_distance, fuzzyDistanceBound(unit.words[0]));
+    if (unit.words.size() == 1 && distance_bound > 0) {
+        std::vector<fuzzy_match> matches;
+        getFuzzyIndex().findTerms(unit.words[0], distance_bound, matches);
+        for (auto& match : matches) {
+            query_unit match_unit;
+            match_unit.words = {index->getTerm(match.term)};
+            match_unit.weight = 1.0 / (1 + match.distance);
+            if (resolvePhrase(match_unit, {0})) {
+                units.push_back(std::move(match_unit));
+            }
+        }
+        return;
+    }
+
+    if (resolvePhrase(unit, offsets)) {
+        units.push_back(std::move(unit));
+    }
+}
+
+std::vector<InMemoryTfIdfSearch::query_unit> InMemoryTfIdfSearch::resolveQuery(
+    const std::vector<std::string>& search_terms,
+    const search_options& options
+) const {
+    std::vector<query_unit> query_units;
+    std::set<std::vector<std::string>> seen;
+    for (auto& search_term : search_terms) {
+        std::vector<query_unit> term_units;
+        resolveTerm(search_term, options, term_units);
+        for (auto& unit : term_units) {
+            if (seen.insert(unit.words).second) {
+                query_units.push_back(std::move(unit));
+            }
+        }
+    }
+    return query_units;
+}
+
+search_strategy InMemoryTfIdfSearch::planQuery(std::vector<query_unit>& query_units, const unsigned int k, const search_options& options) const {
+    // Whichever the strategy, scores add up the units in the same order, rarest first
+    std::stable_sort(query_units.begin(), query_units.end(), [](const query_unit& a, const query_unit& b) { return a.idf > b.idf; });
+
+    // A unit contributes at most its largest normalized frequency (kept by the index for plain terms)
+    for (auto& unit : query_units) {
+        double max_tf = 0.0;
+        if (unit.phrase_postings.empty() && unit.phrase.size() == 1) {
+            max_tf = index->getMaxTermFrequency(unit.phrase[0].term);
+        } else {
+            for (auto& entry : unit.postings) {
+                max_tf = std::max(max_tf, (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document));
+            }
+        }
+        unit.max_score = max_tf * unit.idf * unit.weight;
+    }
+
+    bool countable = std::all_of(query_units.begin(), query_units.end(), [](const query_unit& unit) { return unit.countable; });
+    if (options.strategy != STRATEGY_AUTOMATIC) {
+        return options.strategy == STRATEGY_FORWARD_SCAN && !countable ? STRATEGY_TERM_AT_A_TIME : options.strategy;
+    }
+
+    // Only score at a time can stop early and still return the best documents found so far
+    if (options.latency_budget.count() > 0 || options.deadline != std::chrono::steady_clock::time_point::max()) {
+        return STRATEGY_SCORE_AT_A_TIME;
+    }
+
+    // Quantized impacts are only added up term at a time
+    if (options.impact_bits != 0) {
+        return STRATEGY_TERM_AT_A_TIME;
+    }
+
+    double num_documents = index->getNumDocuments();
+    double num_postings = 0.0;
+    double num_phrases = 0.0;
+    for (auto& unit : query_units) {
+        num_postings += unit.postings.size();
+        num_phrases += unit.forward_phrase.size() > 1 ? 1.0 : 0.0;
+    }
+    double term_at_a_time_cost = num_documents * accumulator_cost + num_postings;
+
+    // WAND skips the postings of the weakest units while their bounds add up to less than the K-th best score,
+    // estimated as a quarter of the bound of the strongest unit found in at least K documents
+    double threshold = 0.0;
+    for (auto& unit : query_units) {
+        if (unit.postings.size() >= k) {
+            threshold = std::max(threshold, unit.max_score / 4);
+        }
+    }
+    std::vector<const query_unit*> by_bound;
+    for (auto& unit : query_units) {
+        by_bound.push_back(&unit);
+    }
+    std::sort(by_bound.begin(), by_bound.end(), [](const query_unit* a, const query_unit* b) { return a->max_score < b->max_score; });
+    double skipped_bound = 0.0;
+    double num_skipped = 0.0;
+    double essential_postings = 0.0;
+    for (auto unit : by_bound) {
+        if (skipped_bound + unit->max_score < threshold) {
+            skipped_bound += unit->max_score;
+            num_skipped++;
+        } else {
+            essential_postings += unit->postings.size();
+        }
+    }
+    double wand_cost = essential_postings * (wand_posting_cost + num_skipped * wand_skip_cost);
+
+    // Phrases are matched in a pass of their own over the tokens
+    double forward_scan_cost = num_documents * accumulator_cost + forward_index->getNumTokens() * scan_token_cost * (1.0 + num_phrases);
+
+    if (countable && forward_scan_cost < std::min(term_at_a_time_cost, wand_cost)) {
+        return STRATEGY_FORWARD_SCAN;
+    }
+    return wand_cost < term_at_a_time_cost ? STRATEGY_WAND : STRATEGY_TERM_AT_A_TIME;
+}
+
+void InMemoryTfIdfSearch::rankByWand(
+    const std::vector<query_unit>& query_units,
+    const search_options& options,
+    SearchInterruption& interruption,
+    TopKDocuments& best_documents
+) const {
+    // A cursor per unit, kept sorted by the document it is on
+    struct wand_cursor {
+        std::span<const posting>::iterator position;
+        std::span<const posting>::iterator end;
+        size_t unit;
+    };
+    std::vector<wand_cursor> cursors;
+    for (size_t u = 0; u < query_units.size(); u++) {
+        if (!query_units[u].postings.empty()) {
+            cursors.push_back({query_units[u].postings.begin(), query_units[u].postings.end(), u});
+        }
+    }
+    auto by_document = [](const wand_cursor& a, const wand_cursor& b) { return a.position->document < b.position->document; };
+    auto less = [](const posting& entry, document_id document) { return entry.document < document; };
+    std::sort(cursors.begin(), cursors.end(), by_document);
+
+    // Bounds hold for boosted scores too once multiplied by the largest boost
+    bool boost = options.proximity_boost > 0.0 && query_units.size() > 1;
+    double max_factor = boost ? 1.0 + options.proximity_boost : 1.0;
+    std::vector<double> contributions(query_units.size());
+    size_t num_pivots = 0;
+    while (!cursors.empty()) {
+        if (num_pivots++ % pivot_check_interval == 0 && interruption.check()) {
+            break;
+        }
+
+        // The pivot is the first cursor at which the bounds of the cursors so far could reach the K-best
+        double threshold = best_documents.getThreshold();
+        double bound = 0.0;
+        size_t pivot = 0;
+        for (; pivot < cursors.size(); pivot++) {
+            bound += query_units[cursors[pivot].unit].max_score * max_factor;
+            if (!best_documents.isFull() || bound >= threshold) {
+                break;
+            }
+        }
+        if (pivot == cursors.size()) {
+            break;
+        }
+
+        document_id pivot_document = cursors[pivot].position->document;
+        if (cursors[0].position->document == pivot_document) {
+            // Score the pivot with every unit it contains, adding them up in unit order like term at a time does
+            std::fill(contributions.begin(), contributions.end(), 0.0);
+            for (auto& cursor : cursors) {
+                if (cursor.position->document != pivot_document) {
+                    break;
+                }
+                auto& unit = query_units[cursor.unit];
+                double tf = (1.0 * cursor.position->frequency) / index->getDocumentNumTerms(pivot_document);
+                contributions[cursor.unit] = tf * unit.idf * unit.weight;
+                cursor.position++;
+            }
+            double score = 0.0;
+            for (auto contribution : contributions) {
+                score += contribution;
+            }
+            if (boost && (!best_documents.isFull() || score * max_factor >= threshold)) {
+                score *= proximityFactor(query_units, pivot_document, options.proximity_boost);
+            }
+            best_documents.push(pivot_document, score);
+        } else {
+            // No document before the pivot's can make it, so the cursors before the pivot skip to it
+            for (size_t c = 0; c < pivot; c++) {
+                cursors[c].position = gallopLowerBound(cursors[c].position, cursors[c].end, pivot_document, less);
+            }
+        }
+
+        cursors.erase(std::remove_if(cursors.begin(), cursors.end(), [](const wand_cursor& cursor) {
+            return cursor.position == cursor.end;
+        }), cursors.end());
+        std::sort(cursors.begin(), cursors.end(), by_document);
+    }
+}
+
+void InMemoryTfIdfSearch::scoreByImpact(
+    const std::vector<query_unit>& query_units,
+    const unsigned int k,
+    const search_options& options,
+    SearchInterruption& interruption,
+    std::vector<double>& scores,
+    std::vector<document_id>& candidates
+) const {
+    if (k == 0) {
+        return;
+    }
+
+    // Postings of each unit by decreasing contribution: plain terms keep theirs in the impact ordered index, and
+    // phrases and merged terms are sorted per query
+    std::vector<std::span<const posting>> unit_postings;
+    std::vector<std::vector<posting>> sorted_postings(query_units.size());
+    for (size_t u = 0; u < query_units.size(); u++) {
+        auto& unit = query_units[u];
+        if (unit.phrase.size() == 1 && unit.postings.data() == index->getPostings(unit.phrase[0].term).data()) {
+            unit_postings.push_back(impact_index->getPostings(unit.phrase[0].term));
+            continue;
+        }
+        sorted_postings[u].assign(unit.postings.begin(), unit.postings.end());
+        ImpactOrderedIndex::sortByImpact(*index, sorted_postings[u]);
+        unit_postings.push_back(sorted_postings[u]);
+    }
+    auto contribution = [&](const size_t u, const posting& entry) {
+        double tf = (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document);
+        return tf * query_units[u].idf * query_units[u].weight;
+    };
+
+    // The unit whose next block has the largest contribution goes next
+    std::vector<size_t> positions(query_units.size(), 0);
+    std::priority_queue<std::pair<double, size_t>> next_blocks;
+    for (size_t u = 0; u < query_units.size(); u++) {
+        if (!unit_postings[u].empty()) {
+            next_blocks.emplace(contribution(u, unit_postings[u][0]), u);
+        }
+    }
+
+    // Boosting multiplies a score by at most `max_factor`
+    bool boost = options.proximity_boost > 0.0 && query_units.size() > 1;
+    double max_factor = boost ? 1.0 + options.proximity_boost : 1.0;
+    bool has_deadline = interruption.hasDeadline();
+
+    // Units (of the first 63) already accumulated into each document, so that its score can only grow by the others,
+    // and a last bit set once the document is a candidate
+    std::vector<uint64_t> seen_units(index->getNumDocuments(), 0);
+    auto unit_bit = [](const size_t u) { return u < 63 ? 1ULL << u : 0; };
+    std::vector<double> next_contributions(query_units.size());
+    std::vector<document_id> ranked;
+    double best_score = 0.0;
+    std::chrono::steady_clock::duration check_duration{0};
+    size_t num_accumulated = 0;
+    size_t next_check = first_termination_check;
+    bool known = false;
+    while (!next_blocks.empty() && !known) {
+        size_t u = next_blocks.top().second;
+        next_blocks.pop();
+        auto list = unit_postings[u];
+        size_t end = std::min(list.size(), positions[u] + impact_block_size);
+        for (size_t p = positions[u]; p < end; p++) {
+            document_id document = list[p].document;
+            scores[document] += contribution(u, list[p]);
+            best_score = std::max(best_score, scores[document]);
+            if (seen_units[document] == 0) {
+                candidates.push_back(document);
+            }
+            seen_units[document] |= unit_bit(u) | 1ULL << 63;
+        }
+        num_accumulated += end - positions[u];
+        positions[u] = end;
+        if (end < list.size()) {
+            next_blocks.emplace(contribution(u, list[end]), u);
+        }
+
+        // Only interrupted while postings are left, so that a search which accumulated them all is not flagged approximate
+        if (!next_blocks.empty() && interruption.check(candidates.size() * candidate_selection_time)) {
+            break;
+        }
+        if (num_accumulated < next_check || next_blocks.empty() || candidates.size() < k) {
+            continue;
+        }
+        next_check = num_accumulated * 2;
+        auto now = has_deadline ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        if (has_deadline && now + 2 * check_duration >= interruption.getDeadline()) {
+            // A check costs about twice the last one, which would overrun the deadline
+            continue;
+        }
+
+        // A document can still gain the next contribution of every unit it has not been accumulated from. The K-best
+        // are known once the K-th best score so far beats the best any other document (seen or not) could reach.
+        double remaining = 0.0;
+        for (size_t v = 0; v < query_units.size(); v++) {
+            bool left = positions[v] < unit_postings[v].size();
+            next_contributions[v] = left ? contribution(v, unit_postings[v][positions[v]]) : 0.0;
+            remaining += next_contributions[v];
+        }
+        if (best_score <= remaining * max_factor) {
+            // Not even the best document so far beats a document no unit was accumulated into yet
+            continue;
+        }
+        ranked = candidates;
+        std::nth_element(ranked.begin(), ranked.begin() + (k - 1), ranked.end(), [&scores](document_id a, document_id b) {
+            return scores[a] > scores[b];
+        });
+        double kth_score = scores[ranked[k - 1]];
+        double outside_bound = ranked.size() < index->getNumDocuments() ? remaining : 0.0;
+        for (size_t r = k; r < ranked.size() && kth_score > outside_bound * max_factor; r++) {
+            double bound = scores[ranked[r]];
+            for (size_t v = 0; v < query_units.size(); v++) {
+                if (!(seen_units[ranked[r]] & unit_bit(v))) {
+                    bound += next_contributions[v];
+                }
+            }
+            outside_bound = std::max(outside_bound, bound);
+        }
+        known = kth_score > outside_bound * max_factor;
+        if (has_deadline) {
+            check_duration = std::chrono::steady_clock::now() - now;
+        }
+    }
+    if (next_blocks.empty()) {
+        // Every posting was accumulated, so the scores are complete
+        return;
+    }
+
+    // Keep the K-best so far, and score them exactly, adding the units up in scoring order like term at a time does
+    if (candidates.size() > k) {
+        std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end(), [&scores](document_id a, document_id b) {
+            return scores[a] > scores[b];
+        });
+        candidates.resize(k);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (auto document : candidates) {
+        scores[document] = 0.0;
+    }
+    for (auto& unit : query_units) {
+        scoreMatchingDocuments(unit, candidates, scores);
+    }
+}
+
+template <typename Impact>
+void InMemoryTfIdfSearch::scoreByQuantizedImpacts(
+    const std::vector<query_unit>& query_units,
+    const unsigned int k,
+    const QuantizedImpactIndex<Impact>& impacts,
+    SearchInterruption& interruption,
+    std::vector<double>& scores,
+    std::vector<document_id>& candidates
+) const {
+    if (k == 0) {
+        return;
+    }
+
+    // Plain terms have their impacts precomputed, and phrases, merged and fuzzy terms are quantized per query
+    std::vector<std::span<const posting>> unit_postings;
+    std::vector<std::span<const Impact>> unit_impacts;
+    std::vector<std::vector<Impact>> quantized_impacts(query_units.size());
+    for (size_t u = 0; u < query_units.size(); u++) {
+        auto& unit = query_units[u];
+        unit_postings.push_back(unit.postings);
+        if (unit.phrase.size() == 1 && unit.weight == 1.0 && unit.postings.data() == index->getPostings(unit.phrase[0].term).data()) {
+            unit_impacts.push_back(impacts.getImpacts(unit.phrase[0].term));
+            continue;
+        }
+        for (auto& entry : unit.postings) {
+            double tf = (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document);
+            quantized_impacts[u].push_back(impacts.quantize(tf * unit.idf * unit.weight));
+        }
+        unit_impacts.push_back(quantized_impacts[u]);
+    }
+
+    // 16-bit accumulators, half as many bytes to scan, hold the sums of up to 257 8-bit impacts
+    if (query_units.size() * std::numeric_limits<Impact>::max() <= std::numeric_limits<uint16_t>::max()) {
+        selectByImpacts<uint16_t>(unit_postings, unit_impacts, index->getNumDocuments(), k, interruption, candidates);
+    } else {
+        selectByImpacts<uint32_t>(unit_postings, unit_impacts, index->getNumDocuments(), k, interruption, candidates);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    for (auto& unit : query_units) {
+        scoreMatchingDocuments(unit, candidates, scores);
+    }
+}
+
+void InMemoryTfIdfSearch::scoreByForwardScan(
+    const std::vector<query_unit>& query_units,
+    SearchInterruption& interruption,
+    std::vector<double>& scores,
+    std::vector<document_id>& candidates
+) const {
+    // Single terms are counted in one pass over each transcript's tokens, and phrases matched on their own
+    std::vector<std::pair<token_id, size_t>> term_tokens;
+    std::vector<size_t> phrase_units;
+    for (size_t u = 0; u < query_units.size(); u++) {
+        if (query_units[u].forward_phrase.size() == 1) {
+            term_tokens.emplace_back(query_units[u].forward_phrase[0].term, u);
+        } else {
+            phrase_units.push_back(u);
+        }
+    }
+
+    std::vector<uint32_t> counts(query_units.size());
+    std::vector<uint32_t> positions;
+    size_t num_scanned = interruption_check_interval;
+    for (document_id document = 0; document < forward_index->getNumDocuments(); document++) {
+        if (num_scanned >= interruption_check_interval) {
+            num_scanned = 0;
+            if (interruption.check()) {
+                break;
+            }
+        }
+        std::fill(counts.begin(), counts.end(), 0);
+        auto tokens = forward_index->getTokens(document);
+        num_scanned += tokens.size();
+        for (auto token : tokens) {
+            for (auto& [term_token, unit] : term_tokens) {
+                counts[unit] += term_token == token;
+            }
+        }
+        for (auto unit : phrase_units) {
+            findPhraseInTokens(tokens, query_units[unit].forward_phrase, positions);
+            counts[unit] = positions.size();
+        }
+
+        bool matches = false;
+        for (size_t u = 0; u < query_units.size(); u++) {
+            if (counts[u] > 0) {
+                double tf = (1.0 * counts[u]) / index->getDocumentNumTerms(document);
+                scores[document] += tf * query_units[u].idf * query_units[u].weight;
+                matches = true;
+            }
+        }
+        if (matches) {
+            candidates.push_back(document);
+        }
+    }
+}
+
+void InMemoryTfIdfSearch::scoreBatchRange(
+    const std::vector<batch_list>& batch_lists,
+    const size_t num_queries,
+    const document_id begin,
+    const document_id end,
+    const search_options& options,
+    std::vector<TopKDocuments>& best_documents
+) const {
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Accumulators of the block, query by query, plus the documents each query touched in it
+    size_t block_size = std::max(min_batch_block_documents, batch_accumulator_budget / std::max<size_t>(1, num_queries));
+    std::vector<double> scores(num_queries * block_size, 0.0);
+    std::vector<uint8_t> touched(num_queries * block_size, 0);
+    std::vector<std::vector<uint32_t>> touched_offsets(num_queries);
+    std::vector<uint32_t> offsets;
+    std::vector<double> tfs;
+
+    // Each list's cursor moves through the range once, a block at a time
+    auto less = [](const posting& entry, document_id document) { return entry.document < document; };
+    std::vector<std::span<const posting>::iterator> cursors;
+    for (auto& list : batch_lists) {
+        cursors.push_back(std::lower_bound(list.postings.begin(), list.postings.end(), begin, less));
+    }
+    for (document_id block = begin; block < end && !interruption.check(); block += block_size) {
+        document_id block_end = static_cast<document_id>(std::min<size_t>(end, block + block_size));
+        for (size_t l = 0; l < batch_lists.size(); l++) {
+            // The list's postings in the block are read once, then added up into each unit's query in turn
+            auto& list = batch_lists[l];
+            auto& cursor = cursors[l];
+            offsets.clear();
+            tfs.clear();
+            for (; cursor != list.postings.end() && cursor->document < block_end; cursor++) {
+                offsets.push_back(cursor->document - block);
+                tfs.push_back((1.0 * cursor->frequency) / index->getDocumentNumTerms(cursor->document));
+            }
+            for (auto& unit : list.units) {
+                double* query_scores = scores.data() + unit.query * block_size;
+                uint8_t* query_touched = touched.data() + unit.query * block_size;
+                for (size_t p = 0; p < offsets.size(); p++) {
+                    query_scores[offsets[p]] += tfs[p] * unit.idf * unit.weight;
+                    if (!query_touched[offsets[p]]) {
+                        query_touched[offsets[p]] = 1;
+                        touched_offsets[unit.query].push_back(offsets[p]);
+                    }
+                }
+            }
+        }
+
+        // Offer the block's documents to each query's K-best (those below its K-th best score so far cannot get in),
+        // clearing the accumulators for the next block
+        for (size_t q = 0; q < num_queries; q++) {
+            double threshold = best_documents[q].getThreshold();
+            for (auto offset : touched_offsets[q]) {
+                size_t slot = q * block_size + offset;
+                if (scores[slot] >= threshold) {
+                    best_documents[q].push(block + offset, scores[slot]);
+                    threshold = best_documents[q].getThreshold();
+                }
+                scores[slot] = 0.0;
+                touched[slot] = 0;
+            }
+            touched_offsets[q].clear();
+        }
+    }
+}
+
+double InMemoryTfIdfSearch::proximityFactor(
+    const std::vector<query_unit>& query_units,
+    const document_id document,
+    const double proximity_boost
+) const {
+    // Gather the positions of each term or phrase the document contains
+    std::vector<std::vector<uint32_t>> position_lists;
+    std::vector<uint32_t> positions;
+    auto tokens = forward_index->getTokens(document);
+    for (auto& unit : query_units) {
+        findPhraseInTokens(tokens, unit.forward_phrase, positions);
+        if (!positions.empty()) {
+            position_lists.push_back(positions);
+        }
+    }
+    if (position_lists.size() < 2) {
+        return 1.0;
+    }
+    // A phrase and one of its own words can start at the same position, so cap the density at one
+    uint32_t span = minimumCoveringSpan(position_lists);
+    return 1.0 + proximity_boost * std::min(1.0, (1.0 * position_lists.size()) / span);
+}
+
+void InMemoryTfIdfSearch::scoreMatchingDocuments(
+    const query_unit& unit,
+    const std::vector<document_id>& documents,
+    std::vector<double>& scores
+) const {
+    auto score = [&](const posting& entry) {
+        double tf = (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document);
+        scores[entry.document] += tf * unit.idf * unit.weight;
+    };
+
+    // Walk the shorter list, galloping through the longer one
+    if (documents.size() < unit.postings.size()) {
+        auto it = unit.postings.begin();
+        for (auto document : documents) {
+            it = gallopLowerBound(it, unit.postings.end(), document, [](const posting& entry, document_id value) { return entry.document < value; });
+            if (it != unit.postings.end() && it->document == document) {
+                score(*it);
+            }
+        }
+    } else {
+        auto it = documents.begin();
+        for (auto& entry : unit.postings) {
+            it = gallopLowerBound(it, documents.end(), entry.document);
+            if (it != documents.end() && *it == entry.document) {
+                score(entry);
+            }
+        }
+    }
+}
+
+void InMemoryTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    getBestTranscriptMatches(search_terms, k, search_options(), best_matches);
+}
+
+void InMemoryTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    if (options.impact_bits != 0 && options.impact_bits != 8 && options.impact_bits != 16) {
+        throw std::runtime_error("Error: impacts can only be quantized to 8 or 16 bits\n");
+    }
+
+    std::vector<query_unit> query_units;
+    std::vector<double> scores;
+    std::vector<document_id> candidates;
+    TopKDocuments best_documents(k);
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+    search_strategy strategy = STRATEGY_TERM_AT_A_TIME;
+
+    if (isBooleanQuery(search_terms)) {
+        // Every term, excluded ones included, takes part in selecting the matching documents (a term with several
+        // fuzzy matches matches the union of their documents)
+        auto query = parseBooleanQuery(search_terms);
+        std::vector<std::vector<query_unit>> term_units(query.terms.size());
+        std::vector<std::vector<posting>> merged_postings(query.terms.size());
+        std::vector<std::span<const posting>> term_postings;
+        std::vector<const RoaringBitmap*> term_bitmaps(query.terms.size(), nullptr);
+        for (size_t t = 0; t < query.terms.size(); t++) {
+            resolveTerm(query.terms[t], options, term_units[t]);
+            if (term_units[t].size() == 1) {
+                // A plain term (not a phrase nor merged terms) may also have a bitmap of its documents
+                auto& unit = term_units[t][0];
+                if (unit.phrase.size() == 1 && unit.postings.data() == index->getPostings(unit.phrase[0].term).data()) {
+                    term_bitmaps[t] = index->getDocumentBitmap(unit.phrase[0].term);
+                }
+                term_postings.push_back(unit.postings);
+                continue;
+            }
+            for (auto& unit : term_units[t]) {
+                merged_postings[t].insert(merged_postings[t].end(), unit.postings.begin(), unit.postings.end());
+            }
+            std::sort(merged_postings[t].begin(), merged_postings[t].end(), [](const posting& a, const posting& b) {
+                return a.document < b.document;
+            });
+            merged_postings[t].erase(std::unique(merged_postings[t].begin(), merged_postings[t].end(), [](const posting& a, const posting& b) {
+                return a.document == b.document;
+            }), merged_postings[t].end());
+            term_postings.push_back(merged_postings[t]);
+        }
+        candidates = evaluateBooleanQuery(query, term_postings, term_bitmaps);
+        scores.assign(index->getNumDocuments(), 0.0);
+
+        // Only the matching documents are scored, by the terms which are not excluded
+        std::set<std::vector<std::string>> seen;
+        for (size_t t = 0; t < query.terms.size(); t++) {
+            for (auto& unit : term_units[t]) {
+                if (!query.excluded[t] && seen.insert(unit.words).second) {
+                    query_units.push_back(std::move(unit));
+                }
+            }
+        }
+        for (auto& unit : query_units) {
+            if (interruption.check()) {
+                break;
+            }
+            scoreMatchingDocuments(unit, candidates, scores);
+        }
+    } else {
+        query_units = resolveQuery(search_terms, options);
+        strategy = planQuery(query_units, k, options);
+        if (strategy == STRATEGY_WAND) {
+            rankByWand(query_units, options, interruption, best_documents);
+        } else if (strategy == STRATEGY_SCORE_AT_A_TIME) {
+            scores.assign(index->getNumDocuments(), 0.0);
+            scoreByImpact(query_units, k, options, interruption, scores, candidates);
+        } else if (strategy == STRATEGY_FORWARD_SCAN) {
+            scores.assign(index->getNumDocuments(), 0.0);
+            scoreByForwardScan(query_units, interruption, scores, candidates);
+        } else if (options.impact_bits == 8) {
+            scores.assign(index->getNumDocuments(), 0.0);
+            scoreByQuantizedImpacts(query_units, k, getQuantizedImpacts<uint8_t>(), interruption, scores, candidates);
+        } else if (options.impact_bits == 16) {
+            scores.assign(index->getNumDocuments(), 0.0);
+            scoreByQuantizedImpacts(query_units, k, getQuantizedImpacts<uint16_t>(), interruption, scores, candidates);
+        } else {
+            // Dense accumulator per document, plus the list of documents touched by any term or phrase
+            scores.assign(index->getNumDocuments(), 0.0);
+            std::vector<bool> touched(index->getNumDocuments(), false);
+            for (auto& unit : query_units) {
+                for (size_t block = 0; block < unit.postings.size() && !interruption.check(); block += interruption_check_interval) {
+                    size_t end = std::min(unit.postings.size(), block + interruption_check_interval);
+                    for (size_t p = block; p < end; p++) {
+                        auto& entry = unit.postings[p];
+                        double tf = (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document);
+                        scores[entry.document] += tf * unit.idf * unit.weight;
+                        if (!touched[entry.document]) {
+                            touched[entry.document] = true;
+                            candidates.push_back(entry.document);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // WAND ranks the documents itself, leaving no candidates here
+    if (options.proximity_boost > 0.0 && query_units.size() > 1) {
+        // Boosting never lowers a score, so the unboosted K-th best score is a floor for the boosted K-best
+        TopKDocuments unboosted_best(k);
+        for (auto document : candidates) {
+            unboosted_best.push(document, scores[document]);
+        }
+        double floor = unboosted_best.getThreshold();
+        double max_factor = 1.0 + options.proximity_boost;
+        for (auto document : candidates) {
+            if (scores[document] * max_factor >= floor) {
+                // Once interrupted, the remaining documents keep their unboosted scores
+                double factor = interruption.check() ? 1.0 : proximityFactor(query_units, document, options.proximity_boost);
+                best_documents.push(document, scores[document] * factor);
+            }
+        }
+    } else {
+        for (auto document : candidates) {
+            best_documents.push(document, scores[document]);
+        }
+    }
+
+    if (options.statistics) {
+        options.statistics->strategy = strategy;
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
+
+    best_matches.clear();
+    for (auto& [document, score] : best_documents.getSortedDocuments()) {
+        best_matches.emplace_back(index->getDocumentPath(document), score);
+    }
+}
+
+void InMemoryTfIdfSearch::getBatchTranscriptMatches(
+    const std::vector<std::vector<std::string>>& queries,
+    const unsigned int k,
+    const search_options& options,
+    const unsigned int num_threads,
+    std::vector<std::vector<scored_transcript>>& best_matches
+) {
+    if (options.impact_bits != 0 && options.impact_bits != 8 && options.impact_bits != 16) {
+        throw std::runtime_error("Error: impacts can only be quantized to 8 or 16 bits\n");
+    }
+
+    best_matches.assign(queries.size(), {});
+    size_t threads = num_threads != 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+    search_options query_options = options;
+    query_options.statistics = nullptr;
+
+    // Plain queries are scored together term at a time, unless the options call for another strategy
+    bool together = options.proximity_boost == 0.0 && options.impact_bits == 0 && options.latency_budget.count() == 0 &&
+        options.deadline == std::chrono::steady_clock::time_point::max() &&
+        (options.strategy == STRATEGY_AUTOMATIC || options.strategy == STRATEGY_TERM_AT_A_TIME);
+    std::vector<size_t> batched;
+    std::vector<size_t> separate;
+    std::vector<std::vector<query_unit>> query_units;
+    for (size_t q = 0; q < queries.size(); q++) {
+        if (together && !isBooleanQuery(queries[q])) {
+            batched.push_back(q);
+            query_units.push_back(resolveQuery(queries[q], query_options));
+        } else {
+            separate.push_back(q);
+        }
+    }
+
+    // Units with the same postings (the same term, in any query) share a list. Lists go rarest first, so that each
+    // query adds up its units in the order a single search does (but for units of equal IDF).
+    std::vector<batch_list> batch_lists;
+    std::unordered_map<const posting*, size_t> list_of;
+    for (size_t b = 0; b < batched.size(); b++) {
+        for (auto& unit : query_units[b]) {
+            if (unit.postings.empty()) {
+                continue;
+            }
+            auto [it, inserted] = list_of.emplace(unit.postings.data(), batch_lists.size());
+            if (inserted) {
+                batch_lists.push_back({unit.postings, {}});
+            }
+            batch_lists[it->second].units.push_back({static_cast<uint32_t>(b), unit.idf, unit.weight});
+        }
+    }
+    std::stable_sort(batch_lists.begin(), batch_lists.end(), [](const batch_list& a, const batch_list& b) {
+        return a.units[0].idf > b.units[0].idf;
+    });
+
+    // Each thread scores a range of documents for every query, and the K-best of the ranges are merged
+    size_t num_documents = index->getNumDocuments();
+    size_t range_size = (num_documents + threads - 1) / threads;
+    std::vector<std::future<std::vector<TopKDocuments>>> ranges;
+    for (size_t begin = 0; begin < num_documents && !batched.empty(); begin += range_size) {
+        size_t end = std::min(num_documents, begin + range_size);
+        ranges.push_back(std::async(std::launch::async, [&, begin, end] {
+            std::vector<TopKDocuments> range_best(batched.size(), TopKDocuments(k));
+            scoreBatchRange(batch_lists, batched.size(), begin, end, query_options, range_best);
+            return range_best;
+        }));
+    }
+    std::vector<TopKDocuments> best_documents(batched.size(), TopKDocuments(k));
+    for (auto& range : ranges) {
+        auto range_best = range.get();
+        for (size_t b = 0; b < batched.size(); b++) {
+            for (auto& [document, score] : range_best[b].getSortedDocuments()) {
+                best_documents[b].push(document, score);
+            }
+        }
+    }
+    for (size_t b = 0; b < batched.size(); b++) {
+        for (auto& [document, score] : best_documents[b].getSortedDocuments()) {
+            best_matches[batched[b]].emplace_back(index->getDocumentPath(document), score);
+        }
+    }
+
+    // The other queries are searched one by one, by as many threads
+    std::atomic<size_t> next_separate = 0;
+    std::vector<std::future<void>> searchers;
+    for (size_t t = 0; t < std::min(threads, separate.size()); t++) {
+        searchers.push_back(std::async(std::launch::async, [&] {
+            for (size_t s = next_separate++; s < separate.size(); s = next_separate++) {
+                getBestTranscriptMatches(queries[separate[s]], k, query_options, best_matches[separate[s]]);
+            }
+        }));
+    }
+    for (auto& searcher : searchers) {
+        searcher.get();
+    }
+}
+
+void InMemoryTfIdfSearch::getTranscriptSnippets(
+    const std::vector<std::string>& search_terms,
+    const std::vector<scored_transcript>& best_matches,
+    const search_options& options,
+    std::vector<std::vector<transcript_snippet>>& snippets
+) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    // Each search term is a pattern of token ids, stop words inside a phrase included but trimmed from its ends
+    AhoCorasickAutomaton automaton;
+    uint32_t num_patterns = 0;
+    for (auto& search_term : getIncludedTerms(search_terms)) {
+        auto tokens = TranscriptTokenizer::tokenize(TranscriptTokenizer::normalize(search_term));
+        auto first = std::find_if_not(tokens.begin(), tokens.end(), TranscriptTokenizer::isStopWord);
+        auto last = std::find_if_not(tokens.rbegin(), std::make_reverse_iterator(first), TranscriptTokenizer::isStopWord).base();
+
+        // A single word is also highlighted wherever one of the terms its wildcard, substring, sound-alikes or fuzzy matches stand for appears
+        std::vector<term_id> word_terms;
+        if (tokens.size() == 1 && !search_term.empty() && search_term.back() == '*') {
+            findWildcardTerms(tokens[0], word_terms);
+        } else if (tokens.size() == 1 && search_term[0] == '~') {
+            findSubstringTerms(tokens[0], word_terms);
+        } else if (last - first == 1 && options.phonetic) {
+            auto sound_alikes = phonetic_index->findTerms(*first);
+            word_terms.assign(sound_alikes.begin(), sound_alikes.end());
+        }
+        if (!word_terms.empty()) {
+            for (auto term : word_terms) {
+                token_id token;
+                if (forward_index->findToken(index->getTerm(term), token)) {
+                    automaton.addPattern({token}, num_patterns);
+                }
+            }
+            num_patterns++;
+            continue;
+        }
+        unsigned int distance_bound = (last - first == 1) ? std::min(options.max_edit_distance, fuzzyDistanceBound(*first)) : 0;
+        if (distance_bound > 0) {
+            std::vector<fuzzy_match> matches;
+            getFuzzyIndex().findTerms(*first, distance_bound, matches);
+            for (auto& match : matches) {
+                token_id token;
+                if (forward_index->findToken(index->getTerm(match.term), token)) {
+                    automaton.addPattern({token}, num_patterns);
+                }
+            }
+            num_patterns += matches.empty() ? 0 : 1;
+            continue;
+        }
+
+        std::vector<uint32_t> pattern;
+        for (auto it = first; it != last; it++) {
+            token_id token;
+            if (!forward_index->findToken(*it, token)) {
+                pattern.clear();
+                break;
+            }
+            pattern.push_back(token);
+        }
+        if (!pattern.empty()) {
+            automaton.addPattern(pattern, num_patterns++);
+        }
+    }
+    automaton.build();
+
+    snippets.assign(best_matches.size(), {});
+    auto extract = [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            auto it = document_ids.find(best_matches[r].first);
+            if (it != document_ids.end()) {
+                snippets[r] = extractSnippets(*forward_index, it->second, automaton, options.max_snippets, options.snippet_words);
+            }
+        }
+    };
+
+    // A handful of results is quicker done than handed to other threads
+    if (num_patterns > 0 && best_matches.size() >= parallel_snippet_results) {
+        size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunk_size = (best_matches.size() + num_threads - 1) / num_threads;
+        std::vector<std::future<void>> chunks;
+        for (size_t begin = 0; begin < best_matches.size(); begin += chunk_size) {
+            chunks.push_back(std::async(std::launch::async, extract, begin, std::min(begin + chunk_size, best_matches.size())));
+        }
+        for (auto& chunk : chunks) {
+            chunk.get();
+        }
+    } else if (num_patterns > 0) {
+        extract(0, best_matches.size());
+    }
+
+    if (options.statistics) {
+        options.statistics->snippet_duration = std::chrono::high_resolution_clock::now() - start_time;
+    }
+}
+
+void InMemoryTfIdfSearch::getCompletions(const std::string& prefix, const unsigned int n, std::vector<term_completion>& completions) {
+    completions.clear();
+
+    // Only the word being typed is completed, and only once it has started
+    std::string normalized_prefix = TranscriptTokenizer::normalize(prefix);
+    std::vector<std::string> tokens;
+    std::vector<uint32_t> offsets;
+    TranscriptTokenizer::tokenize(normalized_prefix, tokens, offsets);
+    if (tokens.empty() || offsets.back() + tokens.back().size() != normalized_prefix.size()) {
+        return;
+    }
+
+    std::vector<term_id> terms;
+    completion_trie->complete(tokens.back(), n, terms);
+    for (auto term : terms) {
+        completions.push_back({index->getTerm(term), index->getDocumentFrequency(term)});
+    }
+}
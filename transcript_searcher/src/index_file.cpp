@@ -0,0 +1,168 @@
+#include "index_file.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+
+IndexFileWriter::IndexFileWriter(const std::string& path) : path(path), temporary_path(path + ".tmp") {
+    file.open(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Error: unable to create \"" + temporary_path + "\"\n");
+    }
+
+    // Reserve the header, which is only known once every section is written
+    index_file_header header = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void IndexFileWriter::addSection(const uint32_t id, const void* elements, const size_t element_size, const size_t num_elements) {
+    beginSection(id, element_size);
+    appendToSection(elements, num_elements);
+}
+
+void IndexFileWriter::beginSection(const uint32_t id, const size_t element_size) {
+    align();
+    sections.push_back({id, static_cast<uint32_t>(element_size), static_cast<uint64_t>(file.tellp()), 0});
+}
+
+void IndexFileWriter::appendToSection(const void* elements, const size_t num_elements) {
+    auto& section = sections.back();
+    uint64_t size = section.element_size * num_elements;
+    file.write(static_cast<const char*>(elements), size);
+    if (!file) {
+        throw std::runtime_error("Error: unable to write \"" + temporary_path + "\"\n");
+    }
+    section.size += size;
+}
+
+void IndexFileWriter::align() {
+    uint64_t position = file.tellp();
+    uint64_t padding = (index_file_alignment - position % index_file_alignment) % index_file_alignment;
+    static const char zeros[index_file_alignment] = {};
+    file.write(zeros, padding);
+}
+
+void IndexFileWriter::finish() {
+    // Append the section table, then fill in the header
+    align();
+    index_file_header header = {};
+    std::memcpy(header.magic, index_file_magic, sizeof(header.magic));
+    header.version = index_file_version;
+    header.num_sections = static_cast<uint32_t>(sections.size());
+    header.section_table_offset = file.tellp();
+    file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(index_file_section));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Error: unable to write \"" + temporary_path + "\"\n");
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Error: unable to move \"" + temporary_path + "\" to \"" + path + "\"\n");
+    }
+    finished = true;
+}
+
+IndexFileWriter::~IndexFileWriter() {
+    if (!finished) {
+        file.close();
+        std::remove(temporary_path.c_str());
+    }
+}
+
+IndexFile::IndexFile(const std::string& path) : path(path) {
+    mapping = std::make_unique<MappedFile>(path);
+
+    // Validate the header before trusting any offset in the file
+    index_file_header header;
+    if (mapping->getSize() < sizeof(header)) {
+        throw std::runtime_error("Error: \"" + path + "\" is not an index file\n");
+    }
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+    if (std::memcmp(header.magic, index_file_magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Error: \"" + path + "\" is not an index file\n");
+    }
+    if (header.version != index_file_version) {
+        throw std::runtime_error("Error: \"" + path + "\" has unsupported index version " + std::to_string(header.version) + "\n");
+    }
+    if (header.section_table_offset + header.num_sections * sizeof(index_file_section) > mapping->getSize()) {
+        throw std::runtime_error("Error: \"" + path + "\" is truncated\n");
+    }
+
+    auto table = reinterpret_cast<const index_file_section*>(mapping->getData() + header.section_table_offset);
+    for (uint32_t s = 0; s < header.num_sections; s++) {
+        if (table[s].offset + table[s].size > mapping->getSize()) {
+            throw std::runtime_error("Error: \"" + path + "\" is truncated\n");
+        }
+        sections.emplace(table[s].id, table[s]);
+    }
+}
+
+const index_file_section& IndexFile::findSection(const uint32_t id, const size_t element_size) const {
+    auto it = sections.find(id);
+    if (it == sections.end()) {
+        throw std::runtime_error("Error: \"" + path + "\" has no section " + std::to_string(id) + "\n");
+    }
+    if (it->second.element_size != element_size) {
+        throw std::runtime_error("Error: section " + std::to_string(id) + " of \"" + path + "\" has unexpected element size\n");
+    }
+    return it->second;
+}
+
+const uint8_t* IndexFile::getSectionData(const index_file_section& section) const {
+    auto copy = huge_page_copies.find(section.id);
+    return copy != huge_page_copies.end() ? copy->second.get() : mapping->getData() + section.offset;
+}
+
+std::pair<void*, size_t> IndexFile::getSectionPages(const uint32_t id) const {
+    auto& section = sections.at(id);
+    void* start = const_cast<uint8_t*>(getSectionData(section));
+    size_t size = (section.size + index_file_alignment - 1) / index_file_alignment * index_file_alignment;
+    return {start, size};
+}
+
+void IndexFile::adviseSection(const uint32_t id, const section_access access) const {
+    auto [start, size] = getSectionPages(id);
+    if (size == 0) {
+        return;
+    }
+    int advice = access == SECTION_ACCESS_RANDOM ? MADV_RANDOM : access == SECTION_ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_NORMAL;
+    // Advice only tunes read ahead, so a kernel refusing it changes nothing else
+    madvise(start, size, advice);
+}
+
+void IndexFile::prefaultSection(const uint32_t id, const std::atomic<bool>& stop) const {
+    auto [start, size] = getSectionPages(id);
+    if (size == 0) {
+        return;
+    }
+    // Start reading the whole section from disk at once, then touch every page so that each is mapped
+    madvise(start, size, MADV_WILLNEED);
+    auto* pages = static_cast<const volatile uint8_t*>(start);
+    for (size_t offset = 0; offset < size && !stop.load(std::memory_order_relaxed); offset += index_file_alignment) {
+        pages[offset];
+    }
+}
+
+bool IndexFile::lockSection(const uint32_t id) const {
+    auto [start, size] = getSectionPages(id);
+    return size == 0 || mlock(start, size) == 0;
+}
+
+void IndexFile::copySectionToHugePages(const uint32_t id) {
+    auto& section = sections.at(id);
+    if (section.size == 0 || huge_page_copies.count(id) > 0) {
+        return;
+    }
+    size_t size = (section.size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    std::unique_ptr<uint8_t, void (*)(void*)> copy(static_cast<uint8_t*>(std::aligned_alloc(huge_page_size, size)), std::free);
+    if (!copy) {
+        throw std::runtime_error("Error: unable to allocate huge pages for section " + std::to_string(id) + " of \"" + path + "\"\n");
+    }
+    // Advised before the copy first touches the memory, so that its pages are huge from the start
+    madvise(copy.get(), size, MADV_HUGEPAGE);
+    std::memcpy(copy.get(), mapping->getData() + section.offset, section.size);
+    huge_page_copies.emplace(id, std::move(copy));
+}
@@ -0,0 +1,100 @@
+#include "index_warmup.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+warmup_mode parseWarmupMode(const std::string& name) {
+    for (int mode = WARMUP_NONE; mode <= WARMUP_LOCK; mode++) {
+        if (name == warmup_mode_names[mode]) {
+            return static_cast<warmup_mode>(mode);
+        }
+    }
+    throw std::runtime_error("Error: invalid warm-up mode \"" + name + "\"\n");
+}
+
+// Size of a number of bytes in mebibytes
+static double mebibytes(const uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+IndexWarmup::IndexWarmup(IndexFile& file, std::span<const section_profile> profiles, const index_warmup_options& options)
+    : file(file), profiles(profiles), options(options), start_time(std::chrono::steady_clock::now()) {
+    if (options.huge_pages) {
+        for (auto& profile : profiles) {
+            if (profile.dictionary && file.hasSection(profile.id)) {
+                file.copySectionToHugePages(profile.id);
+            }
+        }
+        copy_duration = std::chrono::steady_clock::now() - start_time;
+    }
+    if (options.advise) {
+        for (auto& profile : profiles) {
+            if (file.hasSection(profile.id)) {
+                file.adviseSection(profile.id, profile.access);
+            }
+        }
+    }
+
+    if (options.mode != WARMUP_NONE && options.background) {
+        thread = std::thread(&IndexWarmup::warmHotSections, this);
+    } else if (options.mode != WARMUP_NONE || options.huge_pages) {
+        warmHotSections();
+    } else {
+        done = true;
+    }
+}
+
+void IndexWarmup::warmHotSections() {
+    uint64_t hot_bytes = 0;
+    size_t num_hot_sections = 0;
+    size_t num_unlocked_sections = 0;
+    for (auto& profile : profiles) {
+        if (options.mode == WARMUP_NONE || !profile.hot || !file.hasSection(profile.id)) {
+            continue;
+        }
+        if (options.mode == WARMUP_LOCK && !file.lockSection(profile.id)) {
+            num_unlocked_sections++;
+        }
+        file.prefaultSection(profile.id, stopping);
+        hot_bytes += file.getSections().at(profile.id).size;
+        num_hot_sections++;
+    }
+    auto duration = std::chrono::steady_clock::now() - start_time;
+
+    uint64_t dictionary_bytes = 0;
+    for (auto& profile : profiles) {
+        if (options.huge_pages && profile.dictionary && file.hasSection(profile.id)) {
+            dictionary_bytes += file.getSections().at(profile.id).size;
+        }
+    }
+
+    // Reported as a single write, as the report of a background warm-up may come in the middle of other output
+    if (!stopping) {
+        std::stringstream report;
+        report << std::setprecision(1) << std::fixed << "Warmed up \"" << file.getPath() << "\" in "
+            << std::chrono::duration<double, std::milli>(duration).count() << " ms"
+            << (options.background && options.mode != WARMUP_NONE ? " (in the background)" : "") << ":";
+        if (options.mode != WARMUP_NONE) {
+            report << " " << (options.mode == WARMUP_LOCK ? "locked " : "prefaulted ") << num_hot_sections << " hot sections ("
+                << mebibytes(hot_bytes) << " MiB)";
+            if (num_unlocked_sections > 0) {
+                report << ", " << num_unlocked_sections << " of which could only be prefaulted (RLIMIT_MEMLOCK)";
+            }
+        }
+        if (options.huge_pages) {
+            report << (options.mode != WARMUP_NONE ? ";" : "") << " copied the dictionary (" << mebibytes(dictionary_bytes)
+                << " MiB) to huge pages in " << std::chrono::duration<double, std::milli>(copy_duration).count() << " ms";
+        }
+        report << "\n";
+        std::cerr << report.str() << std::flush;
+    }
+    done.store(true, std::memory_order_release);
+}
+
+IndexWarmup::~IndexWarmup() {
+    stopping = true;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
@@ -0,0 +1,186 @@
+#include "inverted_index.h"
+#include "varint.h"
+#include "rapidjson/document.h"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <algorithm>
+
+// A term is dense, and gets a bitmap of its documents, when it appears in at least 1 in this many documents
+static const uint64_t dense_term_fraction = 16;
+
+InvertedIndex::InvertedIndex(
+    std::vector<std::string> document_paths,
+    std::vector<uint32_t> document_num_terms,
+    std::vector<std::string> terms,
+    std::vector<uint64_t> posting_offsets,
+    std::vector<posting> postings,
+    std::vector<uint64_t> position_offsets,
+    std::vector<uint8_t> positions
+) : document_paths(std::move(document_paths)),
+    document_num_terms(std::move(document_num_terms)),
+    terms(std::move(terms)),
+    posting_offsets(std::move(posting_offsets)),
+    postings(std::move(postings)),
+    position_offsets(std::move(position_offsets)),
+    positions(std::move(positions)) {
+    // Build reverse lookup of the dictionary
+    term_ids.reserve(this->terms.size());
+    for (term_id term = 0; term < this->terms.size(); term++) {
+        term_ids.emplace(this->terms[term], term);
+    }
+
+    // Precompute each term's maximum normalized frequency, used to bound its score contribution
+    max_term_frequencies.resize(this->terms.size(), 0.0);
+    for (term_id term = 0; term < this->terms.size(); term++) {
+        for (auto& entry : getPostings(term)) {
+            double tf = (1.0 * entry.frequency) / this->document_num_terms[entry.document];
+            max_term_frequencies[term] = std::max(max_term_frequencies[term], tf);
+        }
+    }
+
+    // Dense terms also get a bitmap of their documents
+    std::vector<uint32_t> documents;
+    for (term_id term = 0; term < this->terms.size(); term++) {
+        if (static_cast<uint64_t>(getDocumentFrequency(term)) * dense_term_fraction < getNumDocuments()) {
+            continue;
+        }
+        documents.clear();
+        for (auto& entry : getPostings(term)) {
+            documents.push_back(entry.document);
+        }
+        document_bitmaps.emplace(term, RoaringBitmap(documents));
+    }
+}
+
+const RoaringBitmap* InvertedIndex::getDocumentBitmap(const term_id term) const {
+    auto it = document_bitmaps.find(term);
+    return it == document_bitmaps.end() ? nullptr : &it->second;
+}
+
+bool InvertedIndex::findTerm(const std::string& term, term_id& id) const {
+    auto it = term_ids.find(term);
+    if (it == term_ids.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+void InvertedIndex::getPositions(const term_id term, const size_t index, std::vector<uint32_t>& term_positions) const {
+    size_t global_index = posting_offsets[term] + index;
+    const uint8_t* bytes = positions.data() + position_offsets[global_index];
+    const uint8_t* end = positions.data() + position_offsets[global_index + 1];
+
+    // Positions are only as many as were recorded, so decode up to the next posting's run
+    term_positions.clear();
+    uint32_t position = 0;
+    while (bytes < end) {
+        position += decodeVarint(bytes);
+        term_positions.push_back(position);
+    }
+}
+
+void InvertedIndexBuilder::readDatabaseDocuments(
+    const std::string& database_path,
+    const std::function<void(const indexed_document&)>& on_document
+) {
+    SQLite::Database db(database_path);
+    SQLite::Statement documents_query(db, "SELECT file, termFrequencies, numTerms FROM documents");
+
+    indexed_document document;
+    while (documents_query.executeStep()) {
+        document.path = documents_query.getColumn(0).getString();
+        document.num_terms = documents_query.getColumn(2).getInt();
+
+        // Convert the term frequency dict from its json form
+        rapidjson::Document termFrequencies_json;
+        std::string result = documents_query.getColumn(1);
+        termFrequencies_json.Parse(result.c_str());
+
+        document.term_frequencies.clear();
+        for (auto m_it = termFrequencies_json.MemberBegin(); m_it != termFrequencies_json.MemberEnd(); m_it++) {
+            document.term_frequencies.emplace_back(m_it->name.GetString(), m_it->value.GetUint());
+        }
+
+        on_document(document);
+    }
+}
+
+document_id InvertedIndexBuilder::addDocument(const indexed_document& document) {
+    document_id id = static_cast<document_id>(document_paths.size());
+    document_paths.push_back(document.path);
+    document_num_terms.push_back(document.num_terms);
+
+    // Documents are added in increasing id order, so each posting list stays sorted by document id
+    has_positions = has_positions || !document.term_positions.empty();
+    for (size_t t = 0; t < document.term_frequencies.size(); t++) {
+        auto& [term, frequency] = document.term_frequencies[t];
+        auto& term_posting_list = term_postings[term];
+        term_posting_list.postings.push_back({id, frequency});
+
+        // Delta encode the positions, if the document carries them
+        size_t size_before = term_posting_list.positions.size();
+        if (t < document.term_positions.size()) {
+            uint32_t previous = 0;
+            for (auto position : document.term_positions[t]) {
+                encodeVarint(position - previous, term_posting_list.positions);
+                previous = position;
+            }
+        }
+        term_posting_list.position_sizes.push_back(static_cast<uint32_t>(term_posting_list.positions.size() - size_before));
+    }
+    return id;
+}
+
+std::vector<std::pair<std::string, uint32_t>> InvertedIndexBuilder::getTermDocumentFrequencies() const {
+    std::vector<std::pair<std::string, uint32_t>> term_document_frequencies;
+    term_document_frequencies.reserve(term_postings.size());
+    for (auto& [term, term_posting_list] : term_postings) {
+        term_document_frequencies.emplace_back(term, static_cast<uint32_t>(term_posting_list.postings.size()));
+    }
+    return term_document_frequencies;
+}
+
+std::unique_ptr<InvertedIndex> InvertedIndexBuilder::build(const std::function<bool(const std::string&)>& term_filter) const {
+    // Select and sort the dictionary
+    std::vector<std::string> terms;
+    for (auto& [term, term_posting_list] : term_postings) {
+        if (!term_filter || term_filter(term)) {
+            terms.push_back(term);
+        }
+    }
+    std::sort(terms.begin(), terms.end());
+
+    // Lay out the posting lists back to back in dictionary order
+    std::vector<uint64_t> posting_offsets;
+    std::vector<posting> postings;
+    std::vector<uint64_t> position_offsets;
+    std::vector<uint8_t> positions;
+    posting_offsets.reserve(terms.size() + 1);
+    for (auto& term : terms) {
+        posting_offsets.push_back(postings.size());
+        auto& term_posting_list = term_postings.at(term);
+        postings.insert(postings.end(), term_posting_list.postings.begin(), term_posting_list.postings.end());
+
+        if (has_positions) {
+            for (auto size : term_posting_list.position_sizes) {
+                position_offsets.push_back(positions.size());
+                positions.resize(positions.size() + size);
+            }
+            std::copy(term_posting_list.positions.begin(), term_posting_list.positions.end(), positions.end() - term_posting_list.positions.size());
+        }
+    }
+    posting_offsets.push_back(postings.size());
+    if (has_positions) {
+        position_offsets.push_back(positions.size());
+    }
+
+    return std::make_unique<InvertedIndex>(
+        document_paths,
+        document_num_terms,
+        std::move(terms),
+        std::move(posting_offsets),
+        std::move(postings),
+        std::move(position_offsets),
+        std::move(positions)
+    );
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "transcript_searcher.h"
+#include "posting_file.h"
 #include "argparse/argparse.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/writer.h"
@@ -16,6 +17,27 @@ int main(int argc, char** argv) {
     argparse::ArgumentParser program("transcript_searcher");
     program.add_argument("-c", "--config_file").default_value(std::string{"config.json"});
     program.add_argument("-a", "--search_algorithm").default_value(std::string{"tf-idf"});
+    program.add_argument("--proximity_boost").default_value(0.0).scan<'g', double>();
+    program.add_argument("--snippets").help("number of snippets shown per result").default_value(1u).scan<'u', unsigned int>();
+    program.add_argument("--snippet_words").default_value(16u).scan<'u', unsigned int>();
+    program.add_argument("--fuzzy").help("largest edit distance at which search terms match mis-spelled terms (0 to 2, with tf-idf-memory)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--phonetic").help("also match the terms which sound like each search word (with tf-idf-memory)").default_value(false).implicit_value(true);
+    program.add_argument("--force_strategy").help("evaluate every query with this strategy: auto, taat, wand or forward (with tf-idf-memory)").default_value(std::string{"auto"});
+    program.add_argument("--latency_budget").help("microseconds after which a search returns its best results so far, flagged as approximate (with tf-idf-memory, 0 for no limit)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--impact_bits").help("rank by impacts quantized to 8 or 16 bits, faster but approximate (with tf-idf-memory, 0 for exact ranking)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--passages").help("show the best passage of each result (with tf-idf-passages)").default_value(false).implicit_value(true);
+    program.add_argument("--tag").help("search every query of this file (one per line) at once and print the results of each, instead of searching interactively").default_value(std::string{""});
+    program.add_argument("--batch").help("run every query of this JSON Lines file and print the results of each as JSON Lines, instead of searching interactively").default_value(std::string{""});
+    program.add_argument("--threads").help("number of threads --batch (and --tag, with tf-idf-memory) search on (0 for one per hardware thread)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--results").help("number of results per search (the default k of --batch queries)").default_value(3u).scan<'u', unsigned int>();
+    program.add_argument("--buffer_pool_mb").help("megabytes of posting blocks kept in memory (with tf-idf-disk, 0 to read every block each time)").default_value(64u).scan<'u', unsigned int>();
+    program.add_argument("--readahead").help("number of posting blocks read ahead of a missed one (with tf-idf-disk)").default_value(4u).scan<'u', unsigned int>();
+    program.add_argument("--direct_io").help("read posting blocks with O_DIRECT, bypassing the page cache (with tf-idf-disk)").default_value(false).implicit_value(true);
+    program.add_argument("--warmup").help("bring the hot sections of the index files into memory at startup: none, prefault or lock (with tf-idf-memory and tf-idf-disk)").default_value(std::string{"none"});
+    program.add_argument("--warmup_background").help("warm up the index files on a background thread, searching meanwhile").default_value(false).implicit_value(true);
+    program.add_argument("--madvise").help("advise the kernel of how each section of the index files is read").default_value(false).implicit_value(true);
+    program.add_argument("--huge_pages").help("copy the dictionary of the index files into transparent huge pages").default_value(false).implicit_value(true);
+    program.add_argument("--max_terms").help("largest number of terms of an interactive search").default_value(5u).scan<'u', unsigned int>();
     try {
         program.parse_args(argc, argv);
     }
@@ -46,10 +68,47 @@ int main(int argc, char** argv) {
     // Get search algorithm from args
     std::string search_algorithm = program.get<std::string>("search_algorithm");
 
+    // Get search options from args
+    search_options options;
+    options.proximity_boost = program.get<double>("--proximity_boost");
+    options.max_snippets = program.get<unsigned int>("--snippets");
+    options.snippet_words = program.get<unsigned int>("--snippet_words");
+    options.max_edit_distance = program.get<unsigned int>("--fuzzy");
+    options.phonetic = program.get<bool>("--phonetic");
+    options.latency_budget = std::chrono::microseconds(program.get<unsigned int>("--latency_budget"));
+    options.impact_bits = program.get<unsigned int>("--impact_bits");
+
+    // Get whether to search passages from args
+    bool show_passages = program.get<bool>("--passages");
+
+    // Get the buffer pool of algorithms reading their index from disk from args
+    buffer_pool_options pool_options;
+    pool_options.num_pages = program.get<unsigned int>("--buffer_pool_mb") * (1024 * 1024 / posting_block_size);
+    pool_options.readahead_blocks = program.get<unsigned int>("--readahead");
+    pool_options.direct_io = program.get<bool>("--direct_io");
+
+    // Get the warm-up of the memory mapped index files from args
+    index_warmup_options warmup_options;
+    warmup_options.background = program.get<bool>("--warmup_background");
+    warmup_options.advise = program.get<bool>("--madvise");
+    warmup_options.huge_pages = program.get<bool>("--huge_pages");
+
     // Initialize a TranscriptSearcher and launch the search process
     try {
-        TranscriptSearcher transcript_searcher(database_abspath, search_algorithm);
-        transcript_searcher.runSearch();
+        warmup_options.mode = parseWarmupMode(program.get<std::string>("--warmup"));
+        options.strategy = TranscriptSearcher::parseSearchStrategy(program.get<std::string>("--force_strategy"));
+        unsigned int max_search_terms = program.get<unsigned int>("--max_terms");
+        unsigned int num_best_results = program.get<unsigned int>("--results");
+        TranscriptSearcher transcript_searcher(database_abspath, search_algorithm, max_search_terms, num_best_results, options, show_passages, pool_options, warmup_options);
+        std::string tag_queries_path = program.get<std::string>("--tag");
+        std::string batch_queries_path = program.get<std::string>("--batch");
+        if (!tag_queries_path.empty()) {
+            transcript_searcher.runTagging(tag_queries_path, program.get<unsigned int>("--threads"));
+        } else if (!batch_queries_path.empty()) {
+            transcript_searcher.runBatch(batch_queries_path, program.get<unsigned int>("--threads"));
+        } else {
+            transcript_searcher.runSearch();
+        }
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
         std::exit(1);
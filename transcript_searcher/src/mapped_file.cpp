@@ -0,0 +1,39 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error: unable to open \"" + path + "\"\n");
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Error: unable to stat \"" + path + "\"\n");
+    }
+    size = static_cast<size_t>(file_stat.st_size);
+
+    // An empty file cannot be mapped, and holds nothing anyway
+    if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Error: unable to map \"" + path + "\"\n");
+        }
+        data = static_cast<const uint8_t*>(mapping);
+    }
+
+    // The mapping keeps the file alive on its own
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+}
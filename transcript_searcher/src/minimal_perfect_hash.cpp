@@ -0,0 +1,127 @@
+#include "minimal_perfect_hash.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// Average number of keys per bucket: fewer means more pilots to store, more means longer searches for them
+static const uint64_t keys_per_bucket = 5;
+
+// Number of seeds tried before giving up, which only happens with duplicate keys
+static const uint64_t max_seeds = 16;
+
+// Finalizer of MurmurHash3, spreading every bit of its input over every bit of its output
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+// Slot of a key given its hash and its bucket's pilot
+static uint64_t slotOf(const uint64_t key_hash, const uint32_t pilot, const uint64_t num_keys) {
+    return mix(key_hash ^ (pilot * 0x9e3779b97f4a7c15ULL)) % num_keys;
+}
+
+/**
+ * Chooses the pilot of every bucket, largest buckets first
+ *
+ * @return `false` if two keys of a bucket have the same hash, so no pilot can separate them
+*/
+static bool placeBuckets(
+    const std::vector<uint64_t>& bucketed_hashes,
+    const std::vector<uint64_t>& bucket_offsets,
+    std::vector<uint32_t>& pilots
+) {
+    uint64_t num_keys = bucketed_hashes.size();
+    uint64_t num_buckets = pilots.size();
+    std::vector<uint32_t> order(num_buckets);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return bucket_offsets[a + 1] - bucket_offsets[a] > bucket_offsets[b + 1] - bucket_offsets[b];
+    });
+
+    std::vector<bool> taken(num_keys, false);
+    std::vector<uint64_t> slots;
+    for (auto bucket : order) {
+        auto first = bucketed_hashes.begin() + bucket_offsets[bucket];
+        auto last = bucketed_hashes.begin() + bucket_offsets[bucket + 1];
+        if (first == last) {
+            break;
+        }
+        if (std::adjacent_find(first, last) != last) {
+            return false;
+        }
+
+        // Try pilots until every key of the bucket lands on its own free slot
+        for (uint32_t pilot = 0; ; pilot++) {
+            slots.clear();
+            bool free = true;
+            for (auto it = first; it != last && free; it++) {
+                uint64_t slot = slotOf(*it, pilot, num_keys);
+                free = !taken[slot] && std::find(slots.begin(), slots.end(), slot) == slots.end();
+                slots.push_back(slot);
+            }
+            if (free) {
+                for (auto slot : slots) {
+                    taken[slot] = true;
+                }
+                pilots[bucket] = pilot;
+                break;
+            }
+            if (pilot == std::numeric_limits<uint32_t>::max()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+MinimalPerfectHash::MinimalPerfectHash(const uint64_t seed, const uint64_t num_keys, std::span<const uint32_t> pilots)
+    : seed(seed), num_keys(num_keys), pilots(pilots) {
+    if (num_keys == 0 || pilots.empty()) {
+        throw std::runtime_error("Error: a perfect hash function needs at least one key\n");
+    }
+}
+
+void MinimalPerfectHash::build(std::span<const std::string_view> keys, uint64_t& seed, std::vector<uint32_t>& pilots) {
+    uint64_t num_keys = keys.size();
+    uint64_t num_buckets = std::max<uint64_t>(1, (num_keys + keys_per_bucket - 1) / keys_per_bucket);
+    std::vector<uint64_t> hashes(num_keys);
+    std::vector<uint64_t> bucket_offsets;
+    for (seed = 0; seed < max_seeds; seed++) {
+        // Group the hashes by bucket, each bucket's sorted
+        for (uint64_t k = 0; k < num_keys; k++) {
+            hashes[k] = hash(keys[k], seed);
+        }
+        std::sort(hashes.begin(), hashes.end(), [num_buckets](uint64_t a, uint64_t b) {
+            return a % num_buckets != b % num_buckets ? a % num_buckets < b % num_buckets : a < b;
+        });
+        bucket_offsets.assign(num_buckets + 1, 0);
+        for (auto key_hash : hashes) {
+            bucket_offsets[key_hash % num_buckets + 1]++;
+        }
+        std::partial_sum(bucket_offsets.begin(), bucket_offsets.end(), bucket_offsets.begin());
+
+        pilots.assign(num_buckets, 0);
+        if (placeBuckets(hashes, bucket_offsets, pilots)) {
+            return;
+        }
+    }
+    throw std::runtime_error("Error: unable to build a perfect hash function, the keys are not distinct\n");
+}
+
+uint64_t MinimalPerfectHash::hash(std::string_view key, const uint64_t seed) {
+    // FNV-1a from a seeded basis, so that keys colliding under one seed do not under the next
+    uint64_t value = 14695981039346656037ULL ^ mix(seed + 1);
+    for (unsigned char c : key) {
+        value = (value ^ c) * 1099511628211ULL;
+    }
+    return mix(value);
+}
+
+uint64_t MinimalPerfectHash::getSlot(const uint64_t key_hash) const {
+    return slotOf(key_hash, pilots[key_hash % pilots.size()], num_keys);
+}
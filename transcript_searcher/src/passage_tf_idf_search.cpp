@@ -0,0 +1,163 @@
+#include "passage_tf_idf_search.h"
+#include "search_interruption.h"
+#include "tf_idf_scoring.h"
+#include "transcript_tokenizer.h"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+PassageTfIdfSearch::PassageTfIdfSearch(const std::string database_path, const double passage_seconds)
+    : passage_seconds(passage_seconds) {
+    if (passage_seconds <= 0.0) {
+        throw std::runtime_error("Error: passage length must be positive\n");
+    }
+
+    SQLite::Database db(database_path);
+    if (!db.tableExists("segments")) {
+        throw std::runtime_error("Error: database has no segments table, run database/setup.py to add it\n");
+    }
+
+    // Gather the segments of each transcript, in time order
+    std::unordered_map<std::string, std::vector<timed_segment>> transcript_segments;
+    SQLite::Statement segments_query(db, "SELECT file, start, end, transcription FROM segments ORDER BY file, start");
+    while (segments_query.executeStep()) {
+        transcript_segments[segments_query.getColumn(0).getString()].push_back({
+            segments_query.getColumn(1).getDouble(),
+            segments_query.getColumn(2).getDouble(),
+            segments_query.getColumn(3).getString()
+        });
+    }
+
+    // Passages of a transcript take consecutive document ids, in transcript table order
+    InvertedIndexBuilder builder;
+    SQLite::Statement documents_query(db, "SELECT file, transcription FROM documents");
+    while (documents_query.executeStep()) {
+        uint32_t transcript = static_cast<uint32_t>(transcript_paths.size());
+        transcript_paths.push_back(documents_query.getColumn(0).getString());
+
+        auto it = transcript_segments.find(transcript_paths.back());
+        if (it != transcript_segments.end() && !it->second.empty()) {
+            addPassages(transcript, it->second, builder);
+        } else {
+            // Transcribed before segments were kept: the whole transcript is a single passage
+            builder.addDocument(TranscriptTokenizer::countTerms(transcript_paths.back(), documents_query.getColumn(1).getString()));
+            passages.push_back({transcript, 0.0, 0.0, false});
+        }
+    }
+    index = builder.build();
+}
+
+void PassageTfIdfSearch::addPassages(const uint32_t transcript, const std::vector<timed_segment>& segments, InvertedIndexBuilder& builder) {
+    size_t first = 0;
+    while (first < segments.size()) {
+        // Take every segment starting within the passage's length (always at least the first)
+        double passage_start = segments[first].start_time;
+        size_t last = first + 1;
+        std::string passage_text = segments[first].text;
+        while (last < segments.size() && segments[last].start_time < passage_start + passage_seconds) {
+            passage_text += " " + segments[last].text;
+            last++;
+        }
+
+        indexed_document passage = TranscriptTokenizer::countTerms(transcript_paths[transcript], TranscriptTokenizer::normalize(passage_text));
+        builder.addDocument(passage);
+        passages.push_back({transcript, passage_start, segments[last - 1].end_time, true});
+        if (last == segments.size()) {
+            return;
+        }
+
+        // The next passage starts half a passage later
+        size_t next = first + 1;
+        while (next < segments.size() && segments[next].start_time < passage_start + passage_seconds / 2) {
+            next++;
+        }
+        first = next;
+    }
+}
+
+void PassageTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    std::vector<scored_passage> best_passages;
+    getBestPassageMatches(search_terms, k, search_options(), best_passages);
+
+    best_matches.clear();
+    for (auto& passage : best_passages) {
+        best_matches.emplace_back(passage.path, passage.score);
+    }
+}
+
+void PassageTfIdfSearch::getBestPassageMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_passage>& best_passages
+) {
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Search terms are normalized like passages are, and duplicates only count once (the operators of a boolean
+    // query are ignored, and its excluded terms dropped)
+    std::set<std::string> unique_terms;
+    for (auto& search_term : getIncludedTerms(search_terms)) {
+        for (auto& token : TranscriptTokenizer::tokenize(TranscriptTokenizer::normalize(search_term))) {
+            if (!TranscriptTokenizer::isStopWord(token)) {
+                unique_terms.insert(token);
+            }
+        }
+    }
+
+    std::vector<weighted_term> query_terms;
+    for (auto& term : unique_terms) {
+        term_id id;
+        if (index->findTerm(term, id)) {
+            query_terms.push_back({id, inverseDocumentFrequency(index->getNumDocuments(), index->getDocumentFrequency(id))});
+        }
+    }
+
+    // Score every passage containing a query term (those scored so far, if the search is interrupted)
+    std::vector<double> scores(index->getNumDocuments(), 0.0);
+    std::vector<bool> touched(index->getNumDocuments(), false);
+    std::vector<document_id> candidates;
+    for (auto& query_term : query_terms) {
+        auto postings = index->getPostings(query_term.term);
+        for (size_t block = 0; block < postings.size() && !interruption.check(); block += interruption_check_interval) {
+            size_t end = std::min(postings.size(), block + interruption_check_interval);
+            for (size_t p = block; p < end; p++) {
+                auto& entry = postings[p];
+                double tf = (1.0 * entry.frequency) / index->getDocumentNumTerms(entry.document);
+                scores[entry.document] += tf * query_term.idf;
+                if (!touched[entry.document]) {
+                    touched[entry.document] = true;
+                    candidates.push_back(entry.document);
+                }
+            }
+        }
+    }
+    if (options.statistics) {
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
+
+    // Keep each transcript's best passage (ties go to the earliest), then the K best of those
+    std::unordered_map<uint32_t, document_id> best_passage_of;
+    for (auto passage : candidates) {
+        auto [it, inserted] = best_passage_of.emplace(passages[passage].transcript, passage);
+        if (!inserted && (scores[passage] > scores[it->second] || (scores[passage] == scores[it->second] && passage < it->second))) {
+            it->second = passage;
+        }
+    }
+    TopKDocuments best_documents(k);
+    for (auto& [transcript, passage] : best_passage_of) {
+        best_documents.push(passage, scores[passage]);
+    }
+
+    best_passages.clear();
+    for (auto& [passage, score] : best_documents.getSortedDocuments()) {
+        auto& location = passages[passage];
+        best_passages.push_back({transcript_paths[location.transcript], location.start_time, location.end_time, location.timed, score});
+    }
+}
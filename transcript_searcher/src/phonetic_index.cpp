@@ -0,0 +1,186 @@
+#include "phonetic_index.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// `true` if a letter is one of the given (upper case) letters
+static bool isOneOf(const char letter, const char* letters) {
+    return letter != '\0' && std::strchr(letters, letter) != nullptr;
+}
+
+static bool isVowel(const char letter) {
+    return isOneOf(letter, "AEIOU");
+}
+
+PhoneticIndex::PhoneticIndex(const InvertedIndex& index) {
+    std::vector<std::pair<std::string, term_id>> keyed_terms;
+    keyed_terms.reserve(index.getNumTerms());
+    for (term_id term = 0; term < index.getNumTerms(); term++) {
+        std::string key = encode(index.getTerm(term));
+        if (!key.empty()) {
+            keyed_terms.emplace_back(std::move(key), term);
+        }
+    }
+    std::sort(keyed_terms.begin(), keyed_terms.end());
+
+    for (auto& [key, term] : keyed_terms) {
+        if (keys.empty() || keys.back() != key) {
+            keys.push_back(key);
+            key_offsets.push_back(key_terms.size());
+        }
+        key_terms.push_back(term);
+    }
+    key_offsets.push_back(key_terms.size());
+}
+
+std::span<const term_id> PhoneticIndex::findTerms(const std::string& word) const {
+    std::string key = encode(word);
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (key.empty() || it == keys.end() || *it != key) {
+        return {};
+    }
+    size_t k = it - keys.begin();
+    return std::span<const term_id>(key_terms.data() + key_offsets[k], key_terms.data() + key_offsets[k + 1]);
+}
+
+std::string PhoneticIndex::encode(const std::string& word) {
+    std::string letters;
+    for (unsigned char c : word) {
+        letters.push_back(std::toupper(c));
+    }
+    auto at = [&](const size_t i) { return i < letters.size() ? letters[i] : '\0'; };
+
+    std::string key;
+    size_t i = 0;
+
+    // Silent or special first letters
+    std::string start = letters.substr(0, 2);
+    if (start == "AE" || start == "GN" || start == "KN" || start == "PN" || start == "WR") {
+        i = 1;
+    } else if (start[0] == 'X') {
+        key.push_back('S');
+        i = 1;
+    } else if (start == "WH") {
+        key.push_back('W');
+        i = 2;
+    }
+
+    for (; i < letters.size(); i++) {
+        char letter = letters[i];
+        char previous = i > 0 ? letters[i - 1] : '\0';
+        char next = at(i + 1);
+
+        // Doubled letters sound once, except C (as in "accept")
+        if (letter == previous && letter != 'C') {
+            continue;
+        }
+
+        switch (letter) {
+            case 'A': case 'E': case 'I': case 'O': case 'U':
+                // Vowels only count at the start of a word, where they all sound alike
+                if (i == 0) {
+                    key.push_back('A');
+                }
+                break;
+            case 'B':
+                // Silent in a final "mb"
+                if (!(previous == 'M' && i + 1 == letters.size())) {
+                    key.push_back('B');
+                }
+                break;
+            case 'C':
+                if (next == 'I' && at(i + 2) == 'A') {
+                    key.push_back('X');
+                } else if (next == 'H') {
+                    key.push_back(previous == 'S' ? 'K' : 'X');
+                    i++;
+                } else if (isOneOf(next, "IEY")) {
+                    if (previous != 'S') {
+                        key.push_back('S');
+                    }
+                } else {
+                    key.push_back('K');
+                }
+                break;
+            case 'D':
+                if (next == 'G' && isOneOf(at(i + 2), "IEY")) {
+                    key.push_back('J');
+                    i += 2;
+                } else {
+                    key.push_back('T');
+                }
+                break;
+            case 'G':
+                // Silent in "gh" before a consonant or at the end, and in a final "gn" or "gned"
+                if (next == 'H' && !isVowel(at(i + 2))) {
+                    break;
+                }
+                if (next == 'N' && (i + 2 == letters.size() || letters.compare(i + 1, std::string::npos, "NED") == 0)) {
+                    break;
+                }
+                key.push_back(isOneOf(next, "IEY") ? 'J' : 'K');
+                break;
+            case 'H':
+                // Only sounded before a vowel, and not as part of "ch", "gh", "ph", "sh" or "th"
+                if (isVowel(next) && !isOneOf(previous, "CGPST")) {
+                    key.push_back('H');
+                }
+                break;
+            case 'K':
+                if (previous != 'C') {
+                    key.push_back('K');
+                }
+                break;
+            case 'P':
+                if (next == 'H') {
+                    key.push_back('F');
+                    i++;
+                } else {
+                    key.push_back('P');
+                }
+                break;
+            case 'Q':
+                key.push_back('K');
+                break;
+            case 'S':
+                if (next == 'H') {
+                    key.push_back('X');
+                    i++;
+                } else if (next == 'I' && isOneOf(at(i + 2), "AO")) {
+                    key.push_back('X');
+                } else {
+                    key.push_back('S');
+                }
+                break;
+            case 'T':
+                if (next == 'I' && isOneOf(at(i + 2), "AO")) {
+                    key.push_back('X');
+                } else if (next == 'H') {
+                    key.push_back('0');
+                    i++;
+                } else if (!(next == 'C' && at(i + 2) == 'H')) {
+                    key.push_back('T');
+                }
+                break;
+            case 'V':
+                key.push_back('F');
+                break;
+            case 'W':
+            case 'Y':
+                if (isVowel(next)) {
+                    key.push_back(letter);
+                }
+                break;
+            case 'X':
+                key.append("KS");
+                break;
+            case 'Z':
+                key.push_back('S');
+                break;
+            default:
+                key.push_back(letter);
+                break;
+        }
+    }
+    return key;
+}
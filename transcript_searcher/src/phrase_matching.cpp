@@ -0,0 +1,153 @@
+#include "phrase_matching.h"
+#include "galloping_search.h"
+#include <algorithm>
+#include <limits>
+
+// Compares a posting against a document id, for searching posting lists
+static bool isBeforeDocument(const posting& entry, const document_id document) {
+    return entry.document < document;
+}
+
+/**
+ * Intersects the position lists of a phrase's terms within one document
+ *
+ * @param index Index to search
+ * @param phrase Terms of the phrase
+ * @param posting_indexes Index of the document's posting in each term's posting list
+ * @param term_positions Scratch buffer for decoded positions
+ * @param starts Set to the position of the start of each occurrence
+*/
+static void intersectPhrasePositions(
+    const InvertedIndex& index,
+    const std::vector<phrase_term>& phrase,
+    const std::vector<size_t>& posting_indexes,
+    std::vector<uint32_t>& term_positions,
+    std::vector<uint32_t>& starts
+) {
+    // Candidate starts come from the first term, shifted back by its offset
+    index.getPositions(phrase[0].term, posting_indexes[0], term_positions);
+    starts.clear();
+    for (auto position : term_positions) {
+        if (position >= phrase[0].offset) {
+            starts.push_back(position - phrase[0].offset);
+        }
+    }
+
+    // Every other term must appear at its offset from each surviving start
+    for (size_t t = 1; t < phrase.size() && !starts.empty(); t++) {
+        index.getPositions(phrase[t].term, posting_indexes[t], term_positions);
+        auto cursor = term_positions.begin();
+        size_t kept = 0;
+        for (auto start : starts) {
+            uint32_t target = start + phrase[t].offset;
+            cursor = gallopLowerBound(cursor, term_positions.end(), target);
+            if (cursor == term_positions.end()) {
+                break;
+            }
+            if (*cursor == target) {
+                starts[kept++] = start;
+            }
+        }
+        starts.resize(kept);
+    }
+}
+
+std::vector<posting> matchPhrase(const InvertedIndex& index, const std::vector<phrase_term>& phrase) {
+    std::vector<posting> matches;
+    if (phrase.empty()) {
+        return matches;
+    }
+
+    // Drive the intersection from the rarest term, which bounds the number of candidate documents
+    std::vector<phrase_term> terms(phrase);
+    std::sort(terms.begin(), terms.end(), [&](const phrase_term& a, const phrase_term& b) {
+        return index.getDocumentFrequency(a.term) < index.getDocumentFrequency(b.term);
+    });
+
+    std::vector<std::span<const posting>> posting_lists;
+    for (auto& term : terms) {
+        posting_lists.push_back(index.getPostings(term.term));
+    }
+
+    std::vector<size_t> posting_indexes(terms.size(), 0);
+    std::vector<uint32_t> term_positions;
+    std::vector<uint32_t> starts;
+    for (size_t i = 0; i < posting_lists[0].size(); i++) {
+        document_id document = posting_lists[0][i].document;
+        posting_indexes[0] = i;
+
+        // Gallop every other list forward to the document
+        bool in_all = true;
+        for (size_t t = 1; t < terms.size(); t++) {
+            auto& posting_list = posting_lists[t];
+            auto it = gallopLowerBound(posting_list.begin() + posting_indexes[t], posting_list.end(), document, isBeforeDocument);
+            posting_indexes[t] = it - posting_list.begin();
+            if (it == posting_list.end()) {
+                return matches;
+            }
+            if (it->document != document) {
+                in_all = false;
+                break;
+            }
+        }
+        if (!in_all) {
+            continue;
+        }
+
+        intersectPhrasePositions(index, terms, posting_indexes, term_positions, starts);
+        if (!starts.empty()) {
+            matches.push_back({document, static_cast<uint32_t>(starts.size())});
+        }
+    }
+    return matches;
+}
+
+void findPhraseInTokens(std::span<const uint32_t> tokens, const std::vector<phrase_term>& phrase, std::vector<uint32_t>& starts) {
+    starts.clear();
+    if (phrase.empty()) {
+        return;
+    }
+
+    // Offsets are relative to the first term, so a phrase only fits where its last term still fits
+    uint32_t length = phrase.back().offset + 1;
+    for (size_t start = 0; start + length <= tokens.size(); start++) {
+        if (tokens[start] != phrase[0].term) {
+            continue;
+        }
+        bool matches = true;
+        for (size_t t = 1; t < phrase.size() && matches; t++) {
+            matches = tokens[start + phrase[t].offset] == phrase[t].term;
+        }
+        if (matches) {
+            starts.push_back(static_cast<uint32_t>(start));
+        }
+    }
+}
+
+uint32_t minimumCoveringSpan(const std::vector<std::vector<uint32_t>>& position_lists) {
+    if (position_lists.empty()) {
+        return 0;
+    }
+
+    // Slide a window over the merged lists: repeatedly advance the list holding the window's first position
+    std::vector<size_t> cursors(position_lists.size(), 0);
+    uint32_t best_span = std::numeric_limits<uint32_t>::max();
+    while (true) {
+        size_t first_list = 0;
+        uint32_t first = std::numeric_limits<uint32_t>::max();
+        uint32_t last = 0;
+        for (size_t l = 0; l < position_lists.size(); l++) {
+            uint32_t position = position_lists[l][cursors[l]];
+            if (position < first) {
+                first = position;
+                first_list = l;
+            }
+            last = std::max(last, position);
+        }
+        best_span = std::min(best_span, last - first + 1);
+
+        if (++cursors[first_list] == position_lists[first_list].size()) {
+            return best_span;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include "posting_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+// How a posting file reads the sections it uses in place (the postings being read through their own reader)
+static const section_profile posting_file_profiles[] = {
+    {POSTING_FILE_TERM_OFFSETS, SECTION_ACCESS_RANDOM, true, true},
+    {POSTING_FILE_DOCUMENT_NUM_TERMS, SECTION_ACCESS_RANDOM, true, false}
+};
+
+// Number of postings collected in memory while building, before they are sorted and spilled to disk as a run
+static const size_t max_run_postings = 4 * 1024 * 1024;
+// Number of postings buffered per run while merging the runs, and before writing merged postings
+static const size_t merge_buffer_postings = 64 * 1024;
+
+// Posting of a run, tagged with the token its list is for
+struct run_posting {
+    token_id token;
+    posting entry;
+};
+
+// Sequential reader over one of the runs of the temporary run file
+struct run_reader {
+    std::ifstream file;
+    uint64_t remaining;
+    std::vector<run_posting> buffer;
+    size_t position;
+};
+
+// Temporary file holding the runs of a build, removed once done with
+struct run_file {
+    std::string path;
+    std::ofstream file;
+
+    explicit run_file(const std::string& path) : path(path), file(path, std::ios::binary | std::ios::trunc) {}
+    ~run_file() { std::remove(path.c_str()); }
+};
+
+// Sorts the postings collected in memory by token (keeping their document order) and appends them to the run file
+static void spillRun(std::vector<run_posting>& run, run_file& runs, std::vector<uint64_t>& run_sizes) {
+    std::stable_sort(run.begin(), run.end(), [](const run_posting& a, const run_posting& b) { return a.token < b.token; });
+    runs.file.write(reinterpret_cast<const char*>(run.data()), run.size() * sizeof(run_posting));
+    if (!runs.file) {
+        throw std::runtime_error("Error: unable to write \"" + runs.path + "\"\n");
+    }
+    run_sizes.push_back(run.size());
+    run.clear();
+}
+
+// Makes the reader's next posting available, returning `false` at the end of its run
+static bool fillRunBuffer(run_reader& reader, const std::string& path) {
+    if (reader.position < reader.buffer.size()) {
+        return true;
+    }
+    if (reader.remaining == 0) {
+        return false;
+    }
+    size_t count = static_cast<size_t>(std::min<uint64_t>(reader.remaining, merge_buffer_postings));
+    reader.buffer.resize(count);
+    reader.file.read(reinterpret_cast<char*>(reader.buffer.data()), count * sizeof(run_posting));
+    if (!reader.file) {
+        throw std::runtime_error("Error: unable to read \"" + path + "\"\n");
+    }
+    reader.remaining -= count;
+    reader.position = 0;
+    return true;
+}
+
+PostingFile::PostingFile(const std::string& path, const index_warmup_options& warmup_options) {
+    file = std::make_unique<IndexFile>(path);
+    // Before the sections are fetched, as the dictionary may be moved to huge pages
+    warmup = std::make_unique<IndexWarmup>(*file, posting_file_profiles, warmup_options);
+    term_offsets = file->getSection<uint64_t>(POSTING_FILE_TERM_OFFSETS);
+    document_num_terms = file->getSection<uint32_t>(POSTING_FILE_DOCUMENT_NUM_TERMS);
+    // Checks the section's element size, without touching its pages
+    file->getSection<posting>(POSTING_FILE_POSTINGS);
+    postings = file->getSections().at(POSTING_FILE_POSTINGS);
+
+    if (term_offsets.empty() || term_offsets.back() != getNumPostings() || postings.offset % posting_block_size != 0) {
+        throw std::runtime_error("Error: \"" + path + "\" is not a valid posting file\n");
+    }
+}
+
+bool PostingFile::build(const std::string& database_path, const ForwardIndex& forward_index, const std::string& path) {
+    // Postings are collected in bounded runs, each sorted by token and spilled to disk, then merged token by token
+    // straight into the postings section: runs hold increasing documents, so taking them in order keeps each list sorted
+    run_file runs(path + ".runs");
+    if (!runs.file) {
+        throw std::runtime_error("Error: unable to create \"" + runs.path + "\"\n");
+    }
+    std::vector<run_posting> run;
+    run.reserve(max_run_postings);
+    std::vector<uint64_t> run_sizes;
+    std::vector<uint64_t> document_frequencies(forward_index.getVocabularySize(), 0);
+    std::vector<uint32_t> document_num_terms;
+    bool matches = true;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        document_id id = static_cast<document_id>(document_num_terms.size());
+        if (!matches || id >= forward_index.getNumDocuments() || forward_index.getDocumentPath(id) != document.path) {
+            matches = false;
+            return;
+        }
+        document_num_terms.push_back(document.num_terms);
+        // Terms missing from the forward index's vocabulary have no token to be keyed by
+        for (auto& [term, frequency] : document.term_frequencies) {
+            token_id token;
+            if (forward_index.findToken(term, token)) {
+                run.push_back({token, {id, frequency}});
+                document_frequencies[token]++;
+            }
+        }
+        if (run.size() >= max_run_postings) {
+            spillRun(run, runs, run_sizes);
+        }
+    });
+    if (!matches || document_num_terms.size() != forward_index.getNumDocuments()) {
+        return false;
+    }
+    if (!run.empty()) {
+        spillRun(run, runs, run_sizes);
+    }
+    run = std::vector<run_posting>();
+    runs.file.close();
+    if (!runs.file) {
+        throw std::runtime_error("Error: unable to write \"" + runs.path + "\"\n");
+    }
+
+    std::vector<uint64_t> term_offsets = {0};
+    for (auto frequency : document_frequencies) {
+        term_offsets.push_back(term_offsets.back() + frequency);
+    }
+    IndexFileWriter writer(path);
+    writer.addSection(POSTING_FILE_TERM_OFFSETS, term_offsets);
+    writer.addSection(POSTING_FILE_DOCUMENT_NUM_TERMS, document_num_terms);
+
+    std::vector<run_reader> readers(run_sizes.size());
+    uint64_t run_offset = 0;
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i].file.open(runs.path, std::ios::binary);
+        readers[i].file.seekg(run_offset * sizeof(run_posting));
+        if (!readers[i].file) {
+            throw std::runtime_error("Error: unable to read \"" + runs.path + "\"\n");
+        }
+        readers[i].remaining = run_sizes[i];
+        readers[i].position = 0;
+        run_offset += run_sizes[i];
+    }
+    writer.beginSection(POSTING_FILE_POSTINGS, sizeof(posting));
+    std::vector<posting> postings;
+    postings.reserve(merge_buffer_postings);
+    for (token_id token = 0; token < forward_index.getVocabularySize(); token++) {
+        for (auto& reader : readers) {
+            while (fillRunBuffer(reader, runs.path) && reader.buffer[reader.position].token == token) {
+                postings.push_back(reader.buffer[reader.position++].entry);
+                if (postings.size() == merge_buffer_postings) {
+                    writer.appendToSection(postings.data(), postings.size());
+                    postings.clear();
+                }
+            }
+        }
+    }
+    writer.appendToSection(postings.data(), postings.size());
+    writer.finish();
+    return true;
+}
@@ -0,0 +1,37 @@
+#include "quantized_impact_index.h"
+#include "tf_idf_scoring.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+template <typename Impact>
+QuantizedImpactIndex<Impact>::QuantizedImpactIndex(const InvertedIndex& index) {
+    // The largest contribution of any posting sets the scale
+    double max_contribution = 0.0;
+    for (term_id term = 0; term < index.getNumTerms(); term++) {
+        double idf = inverseDocumentFrequency(index.getNumDocuments(), index.getDocumentFrequency(term));
+        max_contribution = std::max(max_contribution, index.getMaxTermFrequency(term) * idf);
+    }
+    scale = max_contribution > 0.0 ? std::numeric_limits<Impact>::max() / max_contribution : 0.0;
+
+    impact_offsets.reserve(index.getNumTerms() + 1);
+    impact_offsets.push_back(0);
+    for (term_id term = 0; term < index.getNumTerms(); term++) {
+        double idf = inverseDocumentFrequency(index.getNumDocuments(), index.getDocumentFrequency(term));
+        for (auto& entry : index.getPostings(term)) {
+            double tf = (1.0 * entry.frequency) / index.getDocumentNumTerms(entry.document);
+            impacts.push_back(quantize(tf * idf));
+        }
+        impact_offsets.push_back(impacts.size());
+    }
+}
+
+template <typename Impact>
+Impact QuantizedImpactIndex<Impact>::quantize(const double contribution) const {
+    double impact = std::round(contribution * scale);
+    return static_cast<Impact>(std::clamp(impact, 1.0, static_cast<double>(std::numeric_limits<Impact>::max())));
+}
+
+template class QuantizedImpactIndex<uint8_t>;
+template class QuantizedImpactIndex<uint16_t>;
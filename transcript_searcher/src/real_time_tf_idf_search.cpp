@@ -0,0 +1,103 @@
+#include "real_time_tf_idf_search.h"
+#include "tf_idf_scoring.h"
+#include "transcript_tokenizer.h"
+#include <set>
+
+RealTimeTfIdfSearch::RealTimeTfIdfSearch(const std::string database_path) {
+    InvertedIndexBuilder builder;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builder.addDocument(document);
+        indexed_paths.insert(document.path);
+    });
+    base_segment = builder.build();
+    delta_segment = std::make_unique<ConcurrentInvertedIndex>();
+    database_writer = std::make_unique<TranscriptDatabaseWriter>(database_path);
+}
+
+bool RealTimeTfIdfSearch::indexDocument(const std::string& path, const std::string& transcript) {
+    // Tokenize and count outside the lock
+    std::string normalized_transcript = TranscriptTokenizer::normalize(transcript);
+    indexed_document document = TranscriptTokenizer::countTerms(path, normalized_transcript);
+
+    {
+        std::lock_guard<std::mutex> lock(index_mutex);
+        if (!indexed_paths.insert(path).second) {
+            return false;
+        }
+        delta_segment->addDocument(document);
+    }
+    database_writer->enqueue(document, normalized_transcript);
+    return true;
+}
+
+void RealTimeTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(search_terms, k, search_options(), best_matches);
+}
+
+void RealTimeTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(getIncludedTerms(search_terms), k, options, best_matches);
+}
+
+void RealTimeTfIdfSearch::searchTerms(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Pin the delta segment's current documents for the whole search
+    ConcurrentInvertedIndex::Reader delta(*delta_segment);
+    size_t num_documents_total = base_segment->getNumDocuments() + delta.getNumDocuments();
+
+    // Resolve each term in both segments, with an IDF over the combined corpus
+    std::vector<weighted_term> base_terms;
+    std::vector<weighted_term> delta_terms;
+    for (auto& term : std::set<std::string>(search_terms.begin(), search_terms.end())) {
+        term_id base_id;
+        term_id delta_id;
+        bool in_base = base_segment->findTerm(term, base_id);
+        bool in_delta = delta.findTerm(term, delta_id);
+        size_t num_documents_term = (in_base ? base_segment->getDocumentFrequency(base_id) : 0)
+            + (in_delta ? delta.getDocumentFrequency(delta_id) : 0);
+        if (num_documents_term == 0) {
+            continue;
+        }
+        double idf = inverseDocumentFrequency(num_documents_total, num_documents_term);
+        if (in_base) {
+            base_terms.push_back({base_id, idf});
+        }
+        if (in_delta) {
+            delta_terms.push_back({delta_id, idf});
+        }
+    }
+
+    TopKDocuments base_best(k);
+    TopKDocuments delta_best(k);
+    scoreTermAtATime(*base_segment, base_terms, interruption, base_best);
+    scoreTermAtATime(delta, delta_terms, interruption, delta_best);
+    if (options.statistics) {
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
+
+    // Merge the two segments' K-best
+    std::vector<scored_transcript> merged;
+    for (auto& [document, score] : base_best.getSortedDocuments()) {
+        merged.emplace_back(base_segment->getDocumentPath(document), score);
+    }
+    for (auto& [document, score] : delta_best.getSortedDocuments()) {
+        merged.emplace_back(delta.getDocumentPath(document), score);
+    }
+    keepBestTranscripts(merged, k);
+    best_matches = std::move(merged);
+}
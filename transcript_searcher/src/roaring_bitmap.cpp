@@ -0,0 +1,219 @@
+#include "roaring_bitmap.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+// Largest number of values stored as an array, beyond which a bitmap is smaller
+static const uint32_t max_array_cardinality = 4096;
+
+// Number of 64-bit words in a bitmap container
+static const size_t bitmap_words = 65536 / 64;
+
+// Number of bits set in a bitmap container
+static uint32_t countBits(const std::vector<uint64_t>& words) {
+    uint32_t count = 0;
+    for (auto word : words) {
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+// Turns a container into an array or a bitmap, whichever its cardinality calls for
+static void normalizeContainer(roaring_container& container) {
+    if (!container.words.empty() && container.cardinality <= max_array_cardinality) {
+        container.array.clear();
+        container.array.reserve(container.cardinality);
+        for (size_t w = 0; w < bitmap_words; w++) {
+            for (uint64_t word = container.words[w]; word != 0; word &= word - 1) {
+                container.array.push_back(static_cast<uint16_t>(w * 64 + std::countr_zero(word)));
+            }
+        }
+        container.words = {};
+    } else if (container.words.empty() && container.cardinality > max_array_cardinality) {
+        container.words.assign(bitmap_words, 0);
+        for (auto low : container.array) {
+            container.words[low >> 6] |= 1ULL << (low & 63);
+        }
+        container.array = {};
+    }
+}
+
+static bool containerContains(const roaring_container& container, const uint16_t low) {
+    if (!container.words.empty()) {
+        return (container.words[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(container.array.begin(), container.array.end(), low);
+}
+
+// Bitmap of a container, converting an array container
+static std::vector<uint64_t> containerWords(const roaring_container& container) {
+    if (!container.words.empty()) {
+        return container.words;
+    }
+    std::vector<uint64_t> words(bitmap_words, 0);
+    for (auto low : container.array) {
+        words[low >> 6] |= 1ULL << (low & 63);
+    }
+    return words;
+}
+
+// Keeps the values of an array container which are (or are not) in another container
+static roaring_container filterArray(const roaring_container& array, const roaring_container& other, const bool keep_contained) {
+    roaring_container result{array.key, 0, {}, {}};
+    for (auto low : array.array) {
+        if (containerContains(other, low) == keep_contained) {
+            result.array.push_back(low);
+        }
+    }
+    result.cardinality = result.array.size();
+    return result;
+}
+
+// Combines two bitmaps word by word, in a loop free of branches so that it vectorizes
+template <typename Operation>
+static roaring_container combineWords(const uint16_t key, const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, Operation operation) {
+    roaring_container result{key, 0, {}, std::vector<uint64_t>(bitmap_words)};
+    for (size_t w = 0; w < bitmap_words; w++) {
+        result.words[w] = operation(a[w], b[w]);
+    }
+    result.cardinality = countBits(result.words);
+    normalizeContainer(result);
+    return result;
+}
+
+static roaring_container intersectContainers(const roaring_container& a, const roaring_container& b) {
+    if (!a.words.empty() && !b.words.empty()) {
+        return combineWords(a.key, a.words, b.words, [](uint64_t x, uint64_t y) { return x & y; });
+    }
+    // Probe the values of the array (of the smaller array, for two arrays) in the other container
+    bool probe_a = a.words.empty() && (!b.words.empty() || a.array.size() <= b.array.size());
+    return probe_a ? filterArray(a, b, true) : filterArray(b, a, true);
+}
+
+static roaring_container uniteContainers(const roaring_container& a, const roaring_container& b) {
+    if (a.words.empty() && b.words.empty()) {
+        roaring_container result{a.key, 0, {}, {}};
+        result.array.reserve(a.array.size() + b.array.size());
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+        normalizeContainer(result);
+        return result;
+    }
+    return combineWords(a.key, containerWords(a), containerWords(b), [](uint64_t x, uint64_t y) { return x | y; });
+}
+
+static roaring_container subtractContainers(const roaring_container& a, const roaring_container& b) {
+    if (a.words.empty()) {
+        return filterArray(a, b, false);
+    }
+    return combineWords(a.key, a.words, containerWords(b), [](uint64_t x, uint64_t y) { return x & ~y; });
+}
+
+/**
+ * Applies an operation to the containers of two sets with the same key, and takes those of only one set as they are
+ * (or drops them), which is how every set operation combines the chunks of two sets
+*/
+template <typename Operation>
+static std::vector<roaring_container> mergeContainers(
+    const std::vector<roaring_container>& a,
+    const std::vector<roaring_container>& b,
+    const bool keep_only_a,
+    const bool keep_only_b,
+    Operation operation
+) {
+    std::vector<roaring_container> result;
+    auto it_a = a.begin();
+    auto it_b = b.begin();
+    while (it_a != a.end() || it_b != b.end()) {
+        if (it_b == b.end() || (it_a != a.end() && it_a->key < it_b->key)) {
+            if (keep_only_a) {
+                result.push_back(*it_a);
+            }
+            it_a++;
+        } else if (it_a == a.end() || it_b->key < it_a->key) {
+            if (keep_only_b) {
+                result.push_back(*it_b);
+            }
+            it_b++;
+        } else {
+            roaring_container container = operation(*it_a, *it_b);
+            if (container.cardinality > 0) {
+                result.push_back(std::move(container));
+            }
+            it_a++;
+            it_b++;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap::RoaringBitmap(std::span<const uint32_t> values) {
+    for (auto value : values) {
+        uint16_t key = static_cast<uint16_t>(value >> 16);
+        if (containers.empty() || containers.back().key != key) {
+            if (!containers.empty()) {
+                normalizeContainer(containers.back());
+            }
+            containers.push_back({key, 0, {}, {}});
+        }
+        containers.back().array.push_back(static_cast<uint16_t>(value));
+        containers.back().cardinality++;
+    }
+    if (!containers.empty()) {
+        normalizeContainer(containers.back());
+    }
+    cardinality = values.size();
+}
+
+RoaringBitmap::RoaringBitmap(std::vector<roaring_container> containers) : containers(std::move(containers)) {
+    for (auto& container : this->containers) {
+        cardinality += container.cardinality;
+    }
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return RoaringBitmap(mergeContainers(a.containers, b.containers, false, false, intersectContainers));
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return RoaringBitmap(mergeContainers(a.containers, b.containers, true, true, uniteContainers));
+}
+
+RoaringBitmap RoaringBitmap::subtract(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return RoaringBitmap(mergeContainers(a.containers, b.containers, true, false, subtractContainers));
+}
+
+bool RoaringBitmap::contains(const uint32_t value) const {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    auto it = std::lower_bound(containers.begin(), containers.end(), key, [](const roaring_container& container, uint16_t key) {
+        return container.key < key;
+    });
+    return it != containers.end() && it->key == key && containerContains(*it, static_cast<uint16_t>(value));
+}
+
+void RoaringBitmap::getValues(std::vector<uint32_t>& values) const {
+    values.clear();
+    values.reserve(cardinality);
+    for (auto& container : containers) {
+        uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (container.words.empty()) {
+            for (auto low : container.array) {
+                values.push_back(high | low);
+            }
+            continue;
+        }
+        for (size_t w = 0; w < bitmap_words; w++) {
+            for (uint64_t word = container.words[w]; word != 0; word &= word - 1) {
+                values.push_back(high | static_cast<uint32_t>(w * 64 + std::countr_zero(word)));
+            }
+        }
+    }
+}
+
+size_t RoaringBitmap::getSizeInBytes() const {
+    size_t size = containers.size() * sizeof(roaring_container);
+    for (auto& container : containers) {
+        size += container.array.size() * sizeof(uint16_t) + container.words.size() * sizeof(uint64_t);
+    }
+    return size;
+}
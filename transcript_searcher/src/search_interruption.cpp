@@ -0,0 +1,17 @@
+#include "search_interruption.h"
+#include <algorithm>
+
+SearchInterruption::SearchInterruption(const search_options& options, const std::chrono::steady_clock::time_point start_time)
+    : deadline(options.deadline), cancellation(options.cancellation) {
+    if (options.latency_budget.count() > 0) {
+        deadline = std::min(deadline, start_time + options.latency_budget);
+    }
+}
+
+bool SearchInterruption::check(const std::chrono::nanoseconds reserve) {
+    if (interrupted) {
+        return true;
+    }
+    interrupted = isCancelled() || (hasDeadline() && std::chrono::steady_clock::now() + reserve >= deadline);
+    return interrupted;
+}
@@ -0,0 +1,287 @@
+#include "shared_nothing_tf_idf_search.h"
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+// Capacity of every queue between two cores. Each core caps its searches in flight at half of this, which
+// guarantees that a core never finds another core's inbound queue full (see pollCore)
+static const size_t core_queue_capacity = 1024;
+static const size_t max_in_flight_per_core = core_queue_capacity / 2;
+
+// Number of empty polls a core makes before going to sleep
+static const unsigned int idle_polls_before_sleep = 256;
+
+// Pins the calling thread to a core (best effort, only supported on Linux)
+static void pinToCore(const unsigned int core) {
+#if defined(__linux__)
+    unsigned int num_hardware_cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core % num_hardware_cores, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+SharedNothingTfIdfSearch::SharedNothingTfIdfSearch(
+    const std::string database_path,
+    const unsigned int num_cores
+) {
+    if (num_cores == 0) {
+        throw std::runtime_error("Error: number of cores must be positive\n");
+    }
+
+    // Deal documents round-robin across the cores' shards
+    std::vector<InvertedIndexBuilder> builders(num_cores);
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builders[num_documents_total % num_cores].addDocument(document);
+        num_documents_total++;
+    });
+
+    // Sum each term's document frequency over all shards, so every shard can compute corpus wide IDFs by itself
+    std::unordered_map<std::string, uint32_t> global_document_frequencies;
+    for (auto& builder : builders) {
+        for (auto& [term, document_frequency] : builder.getTermDocumentFrequencies()) {
+            global_document_frequencies[term] += document_frequency;
+        }
+    }
+
+    // Set up every core's queues before any core starts
+    for (unsigned int core = 0; core < num_cores; core++) {
+        auto state = std::make_unique<core_state>();
+        state->ingress = std::make_unique<SpscQueue<search_query*>>(max_in_flight_per_core);
+        for (unsigned int sender = 0; sender < num_cores; sender++) {
+            state->inbound.push_back(std::make_unique<SpscQueue<core_message>>(core_queue_capacity));
+        }
+        cores.push_back(std::move(state));
+    }
+
+    // Start the cores, and wait for each to build its own shard
+    std::latch ready(num_cores);
+    for (unsigned int core = 0; core < num_cores; core++) {
+        cores[core]->thread = std::thread(&SharedNothingTfIdfSearch::runCore, this, core, &builders[core], &global_document_frequencies, &ready);
+    }
+    ready.wait();
+}
+
+void SharedNothingTfIdfSearch::runCore(
+    const unsigned int core,
+    const InvertedIndexBuilder* builder,
+    const std::unordered_map<std::string, uint32_t>* global_document_frequencies,
+    std::latch* ready
+) {
+    pinToCore(core);
+    core_state& state = *cores[core];
+
+    // Build the shard from this core, so that its memory is first touched (and placed) here
+    state.allocator = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    state.shard = builder->build();
+    state.global_document_frequencies.resize(state.shard->getNumTerms());
+    for (term_id term = 0; term < state.shard->getNumTerms(); term++) {
+        state.global_document_frequencies[term] = global_document_frequencies->at(state.shard->getTerm(term));
+    }
+    ready->count_down();
+
+    // Poll for messages, sleeping once idle for a while
+    unsigned int idle_polls = 0;
+    while (!stopping.load()) {
+        if (pollCore(core)) {
+            idle_polls = 0;
+            continue;
+        }
+        if (++idle_polls < idle_polls_before_sleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Announce that this core is going to sleep, then check once more for work which raced the announcement
+        uint32_t observed_signal = state.signal.load();
+        state.sleeping.store(true);
+        if (!pollCore(core) && !stopping.load()) {
+            state.signal.wait(observed_signal);
+        }
+        state.sleeping.store(false);
+        idle_polls = 0;
+    }
+}
+
+bool SharedNothingTfIdfSearch::pollCore(const unsigned int core) {
+    core_state& state = *cores[core];
+    bool handled = false;
+
+    // Serve requests and replies from the other cores
+    for (auto& inbound_queue : state.inbound) {
+        core_message message;
+        while (inbound_queue->pop(message)) {
+            handled = true;
+            if (message.kind == core_message::search) {
+                scoreShard(core, *message.query);
+                sendMessage(message.sender, {core_message::reply, core, message.query});
+            } else if (--message.query->pending_replies == 0) {
+                completeQuery(message.query);
+                state.in_flight--;
+            }
+        }
+    }
+
+    // Accept new searches from outside, but only while this core's searches in flight can't fill a queue:
+    // each one puts at most one message on each queue to or from this core
+    search_query* query;
+    while (state.in_flight < max_in_flight_per_core && state.ingress->pop(query)) {
+        handled = true;
+        state.in_flight++;
+        query->shard_results.resize(cores.size());
+        query->shard_interrupted.resize(cores.size(), false);
+        query->pending_replies = cores.size() - 1;
+
+        // Fan the search out to every other core, then score this core's own shard while they work
+        for (unsigned int target = 0; target < cores.size(); target++) {
+            if (target != core) {
+                sendMessage(target, {core_message::search, core, query});
+            }
+        }
+        scoreShard(core, *query);
+        if (query->pending_replies == 0) {
+            completeQuery(query);
+            state.in_flight--;
+        }
+    }
+    return handled;
+}
+
+void SharedNothingTfIdfSearch::sendMessage(const unsigned int target, const core_message& message) {
+    // Bounded searches in flight guarantee room, but never drop a message if that reasoning is ever broken
+    while (!cores[target]->inbound[message.sender]->push(message)) {
+        std::this_thread::yield();
+    }
+    wakeCore(target);
+}
+
+void SharedNothingTfIdfSearch::wakeCore(const unsigned int core) {
+    core_state& state = *cores[core];
+    state.signal.fetch_add(1);
+    if (state.sleeping.load()) {
+        state.signal.notify_one();
+    }
+}
+
+void SharedNothingTfIdfSearch::scoreShard(const unsigned int core, search_query& query) {
+    core_state& state = *cores[core];
+    const InvertedIndex& shard = *state.shard;
+
+    // Scratch space for this search comes from the core's own allocator
+    std::pmr::vector<double> scores(shard.getNumDocuments(), 0.0, state.allocator.get());
+    std::pmr::vector<bool> touched(shard.getNumDocuments(), false, state.allocator.get());
+    std::pmr::vector<document_id> candidates(state.allocator.get());
+    SearchInterruption interruption(query.options, query.start_time);
+
+    for (auto& term : query.terms) {
+        term_id id;
+        if (!shard.findTerm(term, id)) {
+            continue;
+        }
+        double idf = inverseDocumentFrequency(num_documents_total, state.global_document_frequencies[id]);
+        auto postings = shard.getPostings(id);
+        for (size_t block = 0; block < postings.size() && !interruption.check(); block += interruption_check_interval) {
+            size_t end = std::min(postings.size(), block + interruption_check_interval);
+            for (size_t p = block; p < end; p++) {
+                auto& entry = postings[p];
+                double tf = (1.0 * entry.frequency) / shard.getDocumentNumTerms(entry.document);
+                scores[entry.document] += tf * idf;
+                if (!touched[entry.document]) {
+                    touched[entry.document] = true;
+                    candidates.push_back(entry.document);
+                }
+            }
+        }
+    }
+    query.shard_interrupted[core] = interruption.isInterrupted();
+
+    TopKDocuments best_documents(query.k);
+    for (auto document : candidates) {
+        best_documents.push(document, scores[document]);
+    }
+    query.shard_results[core] = best_documents.getSortedDocuments();
+}
+
+void SharedNothingTfIdfSearch::completeQuery(search_query* query) {
+    // Gather every shard's K-best, resolving documents to their paths
+    search_result result = {{}, false, false};
+    for (unsigned int core = 0; core < cores.size(); core++) {
+        for (auto& [document, score] : query->shard_results[core]) {
+            result.best_matches.emplace_back(cores[core]->shard->getDocumentPath(document), score);
+        }
+        result.interrupted = result.interrupted || query->shard_interrupted[core];
+    }
+    keepBestTranscripts(result.best_matches, query->k);
+    result.cancelled = query->options.cancellation && query->options.cancellation->isCancelled();
+
+    query->result.set_value(std::move(result));
+    delete query;
+}
+
+void SharedNothingTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(search_terms, k, search_options(), best_matches);
+}
+
+void SharedNothingTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(getIncludedTerms(search_terms), k, options, best_matches);
+}
+
+void SharedNothingTfIdfSearch::searchTerms(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    // Duplicate search terms only count once
+    std::set<std::string> unique_terms(search_terms.begin(), search_terms.end());
+
+    search_query* query = new search_query();
+    query->terms.assign(unique_terms.begin(), unique_terms.end());
+    query->k = k;
+    query->options = options;
+    query->options.statistics = nullptr;
+    query->start_time = std::chrono::steady_clock::now();
+    auto result = query->result.get_future();
+
+    // Hand the search to the next core in turn, waiting for room if it is saturated
+    unsigned int core = next_receiving_core.fetch_add(1) % cores.size();
+    {
+        std::lock_guard<std::mutex> lock(cores[core]->ingress_mutex);
+        while (!cores[core]->ingress->push(query)) {
+            std::this_thread::yield();
+        }
+    }
+    wakeCore(core);
+
+    auto search = result.get();
+    best_matches = std::move(search.best_matches);
+    if (options.statistics) {
+        options.statistics->approximate = search.interrupted && !search.cancelled;
+        options.statistics->cancelled = search.cancelled;
+    }
+}
+
+SharedNothingTfIdfSearch::~SharedNothingTfIdfSearch() {
+    stopping.store(true);
+    for (auto& state : cores) {
+        state->signal.fetch_add(1);
+        state->signal.notify_one();
+    }
+    for (auto& state : cores) {
+        state->thread.join();
+    }
+}
@@ -0,0 +1,129 @@
+#include "snippet_extraction.h"
+#include <algorithm>
+#include <cctype>
+
+// A chosen window, as a range [first, last] of token positions
+struct token_window {
+    uint32_t first;
+    uint32_t last;
+};
+
+/**
+ * Cuts a window out of a transcript's text and places the highlights of the matches inside it
+ *
+ * @param forward_index Forward index holding the transcript
+ * @param document Document id of the transcript
+ * @param window Token positions of the window
+ * @param matches Matches of the transcript, sorted by start
+ * @return Snippet of the window
+*/
+static transcript_snippet cutSnippet(
+    const ForwardIndex& forward_index,
+    const document_id document,
+    const token_window& window,
+    const std::vector<pattern_match>& matches
+) {
+    auto tokens = forward_index.getTokens(document);
+    auto token_text_offsets = forward_index.getTokenTextOffsets(document);
+    auto text = forward_index.getText(document);
+    auto token_end = [&](uint32_t position) {
+        return token_text_offsets[position] + static_cast<uint32_t>(forward_index.getToken(tokens[position]).size());
+    };
+
+    transcript_snippet snippet;
+    uint32_t base = token_text_offsets[window.first];
+    snippet.text = std::string(text.substr(base, token_end(window.last) - base));
+    for (auto& c : snippet.text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            c = ' ';
+        }
+    }
+
+    // Highlight every match inside the window, merging overlaps (e.g. a word inside a matched phrase)
+    for (auto& match : matches) {
+        if (match.start < window.first || match.start + match.length - 1 > window.last) {
+            continue;
+        }
+        uint32_t begin = token_text_offsets[match.start] - base;
+        uint32_t end = token_end(match.start + match.length - 1) - base;
+        if (!snippet.highlights.empty() && begin <= snippet.highlights.back().second) {
+            snippet.highlights.back().second = std::max(snippet.highlights.back().second, end);
+        } else {
+            snippet.highlights.emplace_back(begin, end);
+        }
+    }
+    return snippet;
+}
+
+std::vector<transcript_snippet> extractSnippets(
+    const ForwardIndex& forward_index,
+    const document_id document,
+    const AhoCorasickAutomaton& automaton,
+    const unsigned int max_snippets,
+    const unsigned int snippet_words
+) {
+    std::vector<transcript_snippet> snippets;
+    auto tokens = forward_index.getTokens(document);
+    std::vector<pattern_match> matches;
+    automaton.findMatches(tokens, matches);
+    if (matches.empty() || snippet_words == 0) {
+        return snippets;
+    }
+    std::sort(matches.begin(), matches.end(), [](const pattern_match& a, const pattern_match& b) {
+        return a.start < b.start || (a.start == b.start && a.length > b.length);
+    });
+
+    uint32_t num_patterns = 0;
+    for (auto& match : matches) {
+        num_patterns = std::max(num_patterns, match.pattern + 1);
+    }
+
+    // Part of each window shown before its first match
+    uint32_t context = snippet_words / 4;
+    std::vector<token_window> windows;
+    std::vector<uint32_t> pattern_counts(num_patterns, 0);
+    while (windows.size() < max_snippets) {
+        // Slide over the matches: the window starting at match `i` covers the matches up to `j`
+        bool found = false;
+        size_t best_score = 0;
+        token_window best_window = {0, 0};
+        std::fill(pattern_counts.begin(), pattern_counts.end(), 0);
+        size_t j = 0;
+        size_t num_distinct = 0;
+        for (size_t i = 0; i < matches.size(); i++) {
+            uint32_t first = matches[i].start > context ? matches[i].start - context : 0;
+            uint32_t last = std::min<uint32_t>(first + snippet_words, tokens.size()) - 1;
+            j = std::max(j, i);
+            while (j < matches.size() && matches[j].start + matches[j].length - 1 <= last) {
+                if (pattern_counts[matches[j].pattern]++ == 0) {
+                    num_distinct++;
+                }
+                j++;
+            }
+
+            bool overlaps = std::any_of(windows.begin(), windows.end(), [&](const token_window& window) {
+                return first <= window.last && window.first <= last;
+            });
+            size_t score = num_distinct * (matches.size() + 1) + (j - i);
+            if (!overlaps && j > i && (!found || score > best_score)) {
+                found = true;
+                best_score = score;
+                best_window = {first, last};
+            }
+
+            // Drop match `i` before the window moves on
+            if (j > i && --pattern_counts[matches[i].pattern] == 0) {
+                num_distinct--;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        windows.push_back(best_window);
+    }
+
+    for (auto& window : windows) {
+        snippets.push_back(cutSnippet(forward_index, document, window, matches));
+    }
+    return snippets;
+}
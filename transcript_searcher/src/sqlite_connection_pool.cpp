@@ -0,0 +1,51 @@
+#include "sqlite_connection_pool.h"
+#include <stdexcept>
+
+PooledConnection::PooledConnection(SQLiteConnectionPool* pool, SQLite::Database* connection)
+    : pool(pool), connection(connection) {}
+
+PooledConnection::PooledConnection(PooledConnection&& other) noexcept
+    : pool(other.pool), connection(other.connection) {
+    other.connection = nullptr;
+}
+
+PooledConnection::~PooledConnection() {
+    if (connection) {
+        pool->release(connection);
+    }
+}
+
+SQLiteConnectionPool::SQLiteConnectionPool(const std::string database_path, const unsigned int num_connections) {
+    if (num_connections == 0) {
+        throw std::runtime_error("Error: connection pool must hold at least one connection\n");
+    }
+
+    // Switching to write-ahead logging needs a writable connection, but persists in the database file.
+    // If the database can't be written to, readers simply fall back to the existing journal mode.
+    try {
+        SQLite::Database writable_db(database_path, SQLite::OPEN_READWRITE);
+        writable_db.exec("PRAGMA journal_mode=WAL");
+    } catch (const SQLite::Exception&) {}
+
+    // Each connection is only ever used by the one thread which checked it out, so SQLite's own locking is unneeded
+    for (unsigned int i = 0; i < num_connections; i++) {
+        connections.push_back(std::make_unique<SQLite::Database>(database_path, SQLite::OPEN_READONLY | SQLite::OPEN_NOMUTEX));
+        available_connections.push_back(connections.back().get());
+    }
+}
+
+PooledConnection SQLiteConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    connection_available.wait(lock, [this] { return !available_connections.empty(); });
+    SQLite::Database* connection = available_connections.back();
+    available_connections.pop_back();
+    return PooledConnection(this, connection);
+}
+
+void SQLiteConnectionPool::release(SQLite::Database* connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        available_connections.push_back(connection);
+    }
+    connection_available.notify_one();
+}
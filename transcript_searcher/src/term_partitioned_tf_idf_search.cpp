@@ -0,0 +1,216 @@
+#include "term_partitioned_tf_idf_search.h"
+#include "tf_idf_scoring.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+TermPartitionedTfIdfSearch::TermPartitionedTfIdfSearch(
+    const std::string database_path,
+    const unsigned int num_partitions
+) {
+    if (num_partitions == 0) {
+        throw std::runtime_error("Error: number of partitions must be positive\n");
+    }
+
+    // Every partition shares the same documents, so read them once
+    InvertedIndexBuilder builder;
+    InvertedIndexBuilder::readDatabaseDocuments(database_path, [&](const indexed_document& document) {
+        builder.addDocument(document);
+    });
+    num_documents_total = builder.getNumDocuments();
+
+    // Balance posting volume across partitions by greedily assigning the longest posting lists first
+    // to the least loaded partition
+    auto term_document_frequencies = builder.getTermDocumentFrequencies();
+    std::sort(term_document_frequencies.begin(), term_document_frequencies.end(), [](auto& a, auto& b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    std::unordered_map<std::string, unsigned int> term_owners;
+    std::vector<uint64_t> partition_loads(num_partitions, 0);
+    for (auto& [term, document_frequency] : term_document_frequencies) {
+        unsigned int owner = std::min_element(partition_loads.begin(), partition_loads.end()) - partition_loads.begin();
+        term_owners[term] = owner;
+        partition_loads[owner] += document_frequency;
+    }
+
+    // Lay out each partition's index and record where its terms live
+    for (unsigned int p = 0; p < num_partitions; p++) {
+        partitions.push_back(builder.build([&](const std::string& term) { return term_owners[term] == p; }));
+        const InvertedIndex& partition = *partitions.back();
+        for (term_id term = 0; term < partition.getNumTerms(); term++) {
+            term_directory[partition.getTerm(term)] = {
+                p,
+                term,
+                partition.getDocumentFrequency(term),
+                partition.getMaxTermFrequency(term)
+            };
+        }
+        workers.push_back(std::make_unique<WorkerThread>());
+    }
+}
+
+// Finds the K-th highest score held in an accumulator, or negative infinity if it holds fewer than K documents
+template <typename Accumulator>
+static double kthHighestScore(const std::vector<Accumulator>& accumulators, const unsigned int k) {
+    if (k == 0 || accumulators.size() < k) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    std::vector<double> scores;
+    scores.reserve(accumulators.size());
+    for (auto& entry : accumulators) {
+        scores.push_back(entry.score);
+    }
+    std::nth_element(scores.begin(), scores.begin() + (k - 1), scores.end(), std::greater<double>());
+    return scores[k - 1];
+}
+
+void TermPartitionedTfIdfSearch::runStage(
+    const pipeline_stage& stage,
+    const double remaining_max_score,
+    pipeline_query& query
+) {
+    const InvertedIndex& partition = *partitions[stage.partition];
+    auto term_postings = partition.getPostings(stage.term);
+
+    // A document not yet in the accumulator can only reach the K-best if this and the remaining terms
+    // could lift it above the current K-th best score
+    double threshold = kthHighestScore(query.accumulators, query.k);
+    bool accept_new_documents = stage.max_score + remaining_max_score >= threshold;
+
+    // Merge the postings (sorted by document id) into the accumulator (sorted by document id)
+    std::vector<accumulator> merged;
+    merged.reserve(query.accumulators.size() + (accept_new_documents ? term_postings.size() : 0));
+    auto a_it = query.accumulators.begin();
+    auto p_it = term_postings.begin();
+    size_t num_postings = 0;
+    while (a_it != query.accumulators.end() || p_it != term_postings.end()) {
+        if (p_it == term_postings.end() || (a_it != query.accumulators.end() && a_it->document < p_it->document)) {
+            merged.push_back(*a_it);
+            a_it++;
+        } else {
+            // An interrupted stage merges in no more postings, keeping the documents accumulated so far
+            if (num_postings++ % interruption_check_interval == 0 && query.interruption->check()) {
+                merged.insert(merged.end(), a_it, query.accumulators.end());
+                break;
+            }
+            double tf = (1.0 * p_it->frequency) / partition.getDocumentNumTerms(p_it->document);
+            if (a_it != query.accumulators.end() && a_it->document == p_it->document) {
+                merged.push_back({a_it->document, a_it->score + tf * stage.idf});
+                a_it++;
+            } else if (accept_new_documents) {
+                merged.push_back({p_it->document, tf * stage.idf});
+            }
+            p_it++;
+        }
+    }
+
+    // Drop documents which can no longer reach the K-th best score, even gaining the maximum from every remaining term
+    threshold = kthHighestScore(merged, query.k);
+    std::erase_if(merged, [&](const accumulator& entry) {
+        return entry.score + remaining_max_score < threshold;
+    });
+
+    query.accumulators = std::move(merged);
+}
+
+void TermPartitionedTfIdfSearch::runStages(std::shared_ptr<pipeline_query> query) {
+    unsigned int partition = query->stages[query->next_stage].partition;
+
+    // Run every consecutive stage owned by this partition
+    while (query->next_stage < query->stages.size() && query->stages[query->next_stage].partition == partition
+        && !query->interruption->isInterrupted()) {
+        double remaining_max_score = 0.0;
+        for (size_t s = query->next_stage + 1; s < query->stages.size(); s++) {
+            remaining_max_score += query->stages[s].max_score;
+        }
+        runStage(query->stages[query->next_stage], remaining_max_score, *query);
+        query->next_stage++;
+    }
+
+    // Hand the accumulator to the owner of the next term, or complete the query (early, if it was interrupted)
+    if (query->next_stage < query->stages.size() && !query->interruption->isInterrupted()) {
+        workers[query->stages[query->next_stage].partition]->submit([this, query] { runStages(query); });
+    } else {
+        query->result.set_value(std::move(query->accumulators));
+    }
+}
+
+void TermPartitionedTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(search_terms, k, search_options(), best_matches);
+}
+
+void TermPartitionedTfIdfSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(getIncludedTerms(search_terms), k, options, best_matches);
+}
+
+void TermPartitionedTfIdfSearch::searchTerms(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    best_matches.clear();
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Plan the pipeline from the broker's dictionary (terms which appear in no document contribute nothing)
+    auto query = std::make_shared<pipeline_query>();
+    query->k = k;
+    query->interruption = &interruption;
+    std::vector<uint32_t> document_frequencies;
+    std::set<std::string> unique_terms(search_terms.begin(), search_terms.end());
+    for (auto& term : unique_terms) {
+        auto it = term_directory.find(term);
+        if (it != term_directory.end()) {
+            const term_location& location = it->second;
+            double idf = inverseDocumentFrequency(num_documents_total, location.document_frequency);
+            query->stages.push_back({location.partition, location.term, idf, idf * location.max_term_frequency});
+            document_frequencies.push_back(location.document_frequency);
+        }
+    }
+    if (query->stages.empty() || k == 0) {
+        return;
+    }
+
+    // Visit terms rarest first, so the accumulator starts small and later stages can prune it early
+    std::vector<size_t> order(query->stages.size());
+    for (size_t s = 0; s < order.size(); s++) {
+        order[s] = s;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return document_frequencies[a] < document_frequencies[b];
+    });
+    std::vector<pipeline_stage> ordered_stages;
+    for (auto s : order) {
+        ordered_stages.push_back(query->stages[s]);
+    }
+    query->stages = std::move(ordered_stages);
+
+    // Launch the pipeline at the owner of the rarest term and wait for it to come out the other end
+    auto result = query->result.get_future();
+    workers[query->stages.front().partition]->submit([this, query] { runStages(query); });
+    std::vector<accumulator> accumulators = result.get();
+    if (options.statistics) {
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
+
+    // Pick the K-best of the surviving documents
+    TopKDocuments best_documents(k);
+    for (auto& entry : accumulators) {
+        best_documents.push(entry.document, entry.score);
+    }
+    const InvertedIndex& documents = *partitions.front();
+    for (auto& [document, score] : best_documents.getSortedDocuments()) {
+        best_matches.emplace_back(documents.getDocumentPath(document), score);
+    }
+}
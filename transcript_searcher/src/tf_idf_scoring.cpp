@@ -0,0 +1,47 @@
+#include "tf_idf_scoring.h"
+#include <algorithm>
+#include <cmath>
+
+double inverseDocumentFrequency(const size_t num_documents_total, const size_t num_documents_term) {
+    return log2((1.0 + num_documents_total) / (1.0 + num_documents_term));
+}
+
+// Orders documents so that the worse of the two compares greater, turning std heap functions into a minheap
+static bool isBetterDocument(const scored_document& a, const scored_document& b) {
+    return a.second > b.second || (a.second == b.second && a.first < b.first);
+}
+
+TopKDocuments::TopKDocuments(const unsigned int k) : k(k) {
+    heap.reserve(k);
+}
+
+void TopKDocuments::push(const document_id document, const double score) {
+    if (k == 0) {
+        return;
+    }
+    scored_document candidate(document, score);
+    if (heap.size() < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end(), isBetterDocument);
+    } else if (isBetterDocument(candidate, heap.front())) {
+        // Replace the worst document held
+        std::pop_heap(heap.begin(), heap.end(), isBetterDocument);
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end(), isBetterDocument);
+    }
+}
+
+std::vector<scored_document> TopKDocuments::getSortedDocuments() const {
+    std::vector<scored_document> sorted_documents(heap);
+    std::sort(sorted_documents.begin(), sorted_documents.end(), isBetterDocument);
+    return sorted_documents;
+}
+
+void keepBestTranscripts(std::vector<scored_transcript>& transcripts, const unsigned int k) {
+    std::sort(transcripts.begin(), transcripts.end(), [](const scored_transcript& a, const scored_transcript& b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    if (transcripts.size() > k) {
+        transcripts.resize(k);
+    }
+}
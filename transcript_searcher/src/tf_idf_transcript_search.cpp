@@ -6,31 +6,37 @@
 #include <queue>
 #include <functional>
 #include <algorithm>
+#include <thread>
 
-TfIdfTranscriptSearch::TfIdfTranscriptSearch(const std::string database_path) {
-    connectDatabase(database_path);
-}
-
-void TfIdfTranscriptSearch::connectDatabase(const std::string database_path) {
-    // Create unique pointer for database object
-    db = std::make_unique<SQLite::Database>(database_path);
+TfIdfTranscriptSearch::TfIdfTranscriptSearch(const std::string database_path, const unsigned int num_connections) {
+    // Default to one connection per hardware thread
+    unsigned int connections = num_connections;
+    if (connections == 0) {
+        connections = std::max(1u, std::thread::hardware_concurrency());
+    }
+    connection_pool = std::make_unique<SQLiteConnectionPool>(database_path, connections);
 }
 
 void TfIdfTranscriptSearch::preprocessTermsCandidates(
+    SQLite::Database& db,
     const std::vector<std::string>& search_terms,
+    SearchInterruption& interruption,
     std::unordered_map<std::string, double>& search_terms_idfs,
     std::unordered_map<std::string, double>& candidate_documents
 ) {
     // Get the number of documents for use in IDF calculation
-    SQLite::Statement count_query(*db, "SELECT COUNT(*) FROM documents");
+    SQLite::Statement count_query(db, "SELECT COUNT(*) FROM documents");
     count_query.executeStep();
     int num_documents_total = count_query.getColumn(0).getInt();
 
     // For each term, we will consider list of all documents it appears in, and calculate its corpus IDF
     for (auto term : search_terms) {
+        if (interruption.check()) {
+            return;
+        }
 
         // Find this term's DB entry and retrieve its list of inverse-indexed documents
-        SQLite::Statement term_query(*db, "SELECT documents FROM terms WHERE term = ?");
+        SQLite::Statement term_query(db, "SELECT documents FROM terms WHERE term = ?");
         term_query.bind(1, term);
 
         // Resolves to true if we had a result from query meaning this term appears in the corpus of documents
@@ -62,12 +68,13 @@ void TfIdfTranscriptSearch::preprocessTermsCandidates(
 }
 
 int TfIdfTranscriptSearch::getDocumentTermFrequencies(
+    SQLite::Database& db,
     const std::string& document,
     const std::vector<std::string>& search_terms,
     std::unordered_map<std::string, int>& document_term_frequencies
 ) {
     // Get term frequency dict and total number of terms in this document
-    SQLite::Statement document_query(*db, "SELECT termFrequencies, numTerms FROM documents WHERE file = ?");
+    SQLite::Statement document_query(db, "SELECT termFrequencies, numTerms FROM documents WHERE file = ?");
     document_query.bind(1, document);
 
     int document_num_terms = 0;
@@ -95,16 +102,24 @@ int TfIdfTranscriptSearch::getDocumentTermFrequencies(
 }
 
 void TfIdfTranscriptSearch::calculateTfIdfScores(
+    SQLite::Database& db,
     const std::vector<std::string>& search_terms,
     const std::unordered_map<std::string, double>& search_terms_idfs,
+    SearchInterruption& interruption,
     std::unordered_map<std::string, double>& candidate_documents_scores
 ) {
     // Compute document-sum TF-IDF for each candidate document
     for (auto d_it = candidate_documents_scores.begin(); d_it != candidate_documents_scores.end(); d_it++) {
+        // An interrupted search only ranks the documents scored so far
+        if (interruption.check()) {
+            candidate_documents_scores.erase(d_it, candidate_documents_scores.end());
+            return;
+        }
+
         // Get number of terms in document, and frequency of each search term in that document
         std::string document = d_it->first;
         std::unordered_map<std::string, int> document_term_frequencies;
-        int document_num_terms = getDocumentTermFrequencies(document, search_terms, document_term_frequencies);
+        int document_num_terms = getDocumentTermFrequencies(db, document, search_terms, document_term_frequencies);
 
         // Accumulate TF-IDF of each search term for this document
         for (auto t_it = search_terms_idfs.begin(); t_it != search_terms_idfs.end(); t_it++) {
@@ -159,13 +174,45 @@ void TfIdfTranscriptSearch::getBestTranscriptMatches(
     const unsigned int k,
     std::vector<scored_transcript>& best_matches
 ) {
+    searchTerms(search_terms, k, search_options(), best_matches);
+}
+
+void TfIdfTranscriptSearch::getBestTranscriptMatches(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    searchTerms(getIncludedTerms(search_terms), k, options, best_matches);
+}
+
+void TfIdfTranscriptSearch::searchTerms(
+    const std::vector<std::string>& search_terms,
+    const unsigned int k,
+    const search_options& options,
+    std::vector<scored_transcript>& best_matches
+) {
+    SearchInterruption interruption(options, std::chrono::steady_clock::now());
+
+    // Check out a connection for this search, and read everything within one transaction so that
+    // the whole search sees a single snapshot of the corpus
+    PooledConnection connection = connection_pool->acquire();
+    SQLite::Transaction snapshot(connection.get());
+
     // Compute the IDF values for each term and gather set of all documents referenced by any search term
     std::unordered_map<std::string, double> search_terms_idfs;
     std::unordered_map<std::string, double> candidate_documents_scores;
-    preprocessTermsCandidates(search_terms, search_terms_idfs, candidate_documents_scores);
+    preprocessTermsCandidates(connection.get(), search_terms, interruption, search_terms_idfs, candidate_documents_scores);
 
     // Calculate the sum of search terms IDF's for each document
-    calculateTfIdfScores(search_terms, search_terms_idfs, candidate_documents_scores);
+    calculateTfIdfScores(connection.get(), search_terms, search_terms_idfs, interruption, candidate_documents_scores);
+
+    // Nothing was written, so ending the transaction just releases the snapshot
+    snapshot.commit();
+    if (options.statistics) {
+        options.statistics->approximate = interruption.isInterrupted() && !interruption.isCancelled();
+        options.statistics->cancelled = interruption.isCancelled();
+    }
 
     // Use the score of each document to pick the K-best documents from the set
     best_matches = getBestDocuments(candidate_documents_scores, k);
@@ -0,0 +1,113 @@
+#include "transcript_database_writer.h"
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+#include <iostream>
+
+// How long a write waits for other writers (e.g. the preprocessing module) to release the database
+static const int busy_timeout_ms = 5000;
+
+TranscriptDatabaseWriter::TranscriptDatabaseWriter(const std::string database_path) {
+    db = std::make_unique<SQLite::Database>(database_path, SQLite::OPEN_READWRITE, busy_timeout_ms);
+    thread = std::thread(&TranscriptDatabaseWriter::run, this);
+}
+
+void TranscriptDatabaseWriter::enqueue(const indexed_document& document, const std::string& normalized_transcript) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({document, normalized_transcript});
+    }
+    queue_changed.notify_one();
+}
+
+void TranscriptDatabaseWriter::run() {
+    while (true) {
+        pending_document pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queue_changed.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            pending = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        // The document stays searchable in memory either way, so report the failure and carry on
+        try {
+            write(pending);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: failed to persist \"" << pending.document.path << "\": " << e.what() << std::endl;
+        }
+    }
+}
+
+void TranscriptDatabaseWriter::write(const pending_document& pending) {
+    const indexed_document& document = pending.document;
+
+    // Serialize the term frequency dict to json
+    rapidjson::StringBuffer term_frequencies_buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> term_frequencies_writer(term_frequencies_buffer);
+    term_frequencies_writer.StartObject();
+    for (auto& [term, frequency] : document.term_frequencies) {
+        term_frequencies_writer.Key(term.c_str(), term.size());
+        term_frequencies_writer.Uint(frequency);
+    }
+    term_frequencies_writer.EndObject();
+
+    SQLite::Transaction transaction(*db);
+
+    SQLite::Statement insert_document(*db, "INSERT INTO documents VALUES (?, ?, ?, ?)");
+    insert_document.bind(1, document.path);
+    insert_document.bind(2, pending.normalized_transcript);
+    insert_document.bind(3, std::string(term_frequencies_buffer.GetString(), term_frequencies_buffer.GetSize()));
+    insert_document.bind(4, static_cast<int>(document.num_terms));
+    insert_document.exec();
+
+    // Add the document to the inverted index entry of each of its terms
+    SQLite::Statement select_term(*db, "SELECT documents FROM terms WHERE term = ?");
+    SQLite::Statement update_term(*db, "UPDATE terms SET documents = ? WHERE term = ?");
+    SQLite::Statement insert_term(*db, "INSERT INTO terms VALUES (?, ?)");
+    for (auto& [term, frequency] : document.term_frequencies) {
+        select_term.reset();
+        select_term.bind(1, term);
+
+        rapidjson::Document documents_json;
+        bool term_exists = select_term.executeStep();
+        if (term_exists) {
+            std::string result = select_term.getColumn(0);
+            documents_json.Parse(result.c_str());
+        } else {
+            documents_json.SetArray();
+        }
+        documents_json.PushBack(rapidjson::Value(document.path.c_str(), documents_json.GetAllocator()), documents_json.GetAllocator());
+
+        rapidjson::StringBuffer documents_buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> documents_writer(documents_buffer);
+        documents_json.Accept(documents_writer);
+        std::string documents_string(documents_buffer.GetString(), documents_buffer.GetSize());
+
+        if (term_exists) {
+            update_term.reset();
+            update_term.bind(1, documents_string);
+            update_term.bind(2, term);
+            update_term.exec();
+        } else {
+            insert_term.reset();
+            insert_term.bind(1, term);
+            insert_term.bind(2, documents_string);
+            insert_term.exec();
+        }
+    }
+
+    transaction.commit();
+}
+
+TranscriptDatabaseWriter::~TranscriptDatabaseWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queue_changed.notify_one();
+    thread.join();
+}
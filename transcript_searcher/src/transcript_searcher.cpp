@@ -1,21 +1,107 @@
 #include "transcript_searcher.h"
+#include "document_partitioned_tf_idf_search.h"
+#include "term_partitioned_tf_idf_search.h"
+#include "shared_nothing_tf_idf_search.h"
+#include "real_time_tf_idf_search.h"
+#include "in_memory_tf_idf_search.h"
+#include "passage_tf_idf_search.h"
+#include "disk_tf_idf_search.h"
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 TranscriptSearcher::TranscriptSearcher(
     const std::string database_path,
     const std::string search_algorithm,
     const unsigned int max_search_terms,
-    const unsigned int num_best_results
-) : max_search_terms(max_search_terms), num_best_results(num_best_results) {
+    const unsigned int num_best_results,
+    const search_options options,
+    const bool show_passages,
+    const buffer_pool_options pool_options,
+    const index_warmup_options warmup_options
+) : max_search_terms(max_search_terms), num_best_results(num_best_results), options(options), show_passages(show_passages) {
     // Initialize a search algorithm
+    transcript_search_algorithm = createSearchAlgorithm(search_algorithm, database_path, 0, pool_options, warmup_options);
+    if (show_passages && !transcript_search_algorithm->searchesPassages()) {
+        delete transcript_search_algorithm;
+        throw std::runtime_error("Error: search algorithm \"" + search_algorithm + "\" does not search passages\n");
+    }
+}
+
+TranscriptSearchAlgorithm* TranscriptSearcher::createSearchAlgorithm(
+    const std::string search_algorithm,
+    const std::string database_path,
+    const unsigned int num_partitions,
+    const buffer_pool_options& pool_options,
+    const index_warmup_options& warmup_options
+) {
+    // Default to one partition per hardware thread
+    unsigned int partitions = num_partitions;
+    if (partitions == 0) {
+        partitions = std::max(1u, std::thread::hardware_concurrency());
+    }
+
     if (search_algorithm == "tf-idf") {
-        transcript_search_algorithm = new TfIdfTranscriptSearch(database_path);
+        return new TfIdfTranscriptSearch(database_path);
+    } else if (search_algorithm == "tf-idf-document-partitioned") {
+        return new DocumentPartitionedTfIdfSearch(database_path, partitions);
+    } else if (search_algorithm == "tf-idf-term-partitioned") {
+        return new TermPartitionedTfIdfSearch(database_path, partitions);
+    } else if (search_algorithm == "tf-idf-shared-nothing") {
+        return new SharedNothingTfIdfSearch(database_path, partitions);
+    } else if (search_algorithm == "tf-idf-realtime") {
+        return new RealTimeTfIdfSearch(database_path);
+    } else if (search_algorithm == "tf-idf-memory") {
+        return new InMemoryTfIdfSearch(database_path, warmup_options);
+    } else if (search_algorithm == "tf-idf-passages") {
+        return new PassageTfIdfSearch(database_path);
+    } else if (search_algorithm == "tf-idf-disk") {
+        return new DiskTfIdfSearch(database_path, partitions, pool_options, warmup_options);
     } else {
         throw std::runtime_error("Error: invalid search algorithm \"" + search_algorithm + "\"\n");
     }
 }
 
+search_strategy TranscriptSearcher::parseSearchStrategy(const std::string& name) {
+    for (int strategy = STRATEGY_AUTOMATIC; strategy <= STRATEGY_SCORE_AT_A_TIME; strategy++) {
+        if (name == search_strategy_names[strategy]) {
+            return static_cast<search_strategy>(strategy);
+        }
+    }
+    throw std::runtime_error("Error: invalid search strategy \"" + name + "\"\n");
+}
+
+// Prints the statistics of the algorithm's buffer pool on stderr, if it has one
+static void printBufferPoolStatistics(TranscriptSearchAlgorithm& algorithm) {
+    buffer_pool_statistics statistics;
+    if (!algorithm.getBufferPoolStatistics(statistics)) {
+        return;
+    }
+    uint64_t requests = statistics.hits + statistics.misses;
+    std::cerr << std::setprecision(1) << std::fixed << "buffer pool: " << 100.0 * statistics.hits / std::max<uint64_t>(1, requests)
+        << "% hits (" << statistics.hits << " of " << requests << " block requests) | " << statistics.evictions << " evictions | "
+        << statistics.readahead_blocks << " blocks read ahead | " << statistics.resident_pages << " of " << statistics.num_pages
+        << " pages used" << std::endl;
+}
+
+// Splits a line of input into search terms, where a "quoted phrase" counts as a single term
+static std::vector<std::string> splitSearchTerms(const std::string& input) {
+    std::vector<std::string> search_terms;
+    std::stringstream input_ss(input);
+    std::string term;
+    while (input_ss >> std::quoted(term)) {
+        search_terms.push_back(term);
+    }
+    return search_terms;
+}
+
 bool TranscriptSearcher::performNewSearch() {
     // Prompt user to continue or exit
     std::cout << "ENTER to continue, \"exit\" to quit" << std::endl;
@@ -39,22 +125,26 @@ bool TranscriptSearcher::readSearchTerms(std::vector<std::string>& search_terms)
     std::string prompt_input;
     std::getline(std::cin, prompt_input);
 
-    // Turn the input into a string stream and read out individual search terms from it
-    std::stringstream prompt_input_ss(prompt_input);
-    std::string term;
-    // Only read up to `max_search_terms`
-    for (unsigned int i = 0; i < max_search_terms; i++) {
-        if (prompt_input_ss >> term) {
-            search_terms.push_back(term);
+    // Read out individual search terms from the input
+    search_terms = splitSearchTerms(prompt_input);
+
+    // Boolean operators and parentheses don't count towards `max_search_terms`
+    size_t num_terms = search_terms.size();
+    if (isBooleanQuery(search_terms)) {
+        try {
+            num_terms = parseBooleanQuery(search_terms).terms.size();
+        } catch (const std::runtime_error& err) {
+            std::cout << std::endl << err.what();
+            return false;
         }
     }
 
-    // If there is data left in the prompt, user entered too many terms
-    if (prompt_input_ss >> term) {
+    // User entered too many terms
+    if (num_terms > max_search_terms) {
         std::cout << std::endl << "Too many terms entered" << std::endl;
         return false;
     // Zero terms is not a valid search
-    } else if (search_terms.empty()) {
+    } else if (num_terms == 0) {
         std::cout << std::endl << "No terms entered" << std::endl;
         return false;
     // User has entered valid number of terms
@@ -70,19 +160,37 @@ void TranscriptSearcher::runSearch() {
             if (readSearchTerms(search_terms)) {
                 // Get only `num_best_results` results
                 std::vector<scored_transcript> best_transcripts;
+                std::vector<scored_passage> best_passages;
+
+                // Collect statistics of this query
+                search_statistics statistics;
+                search_options query_options = options;
+                query_options.statistics = &statistics;
 
                 // Time the search function
                 auto start_time = std::chrono::high_resolution_clock::now();
 
-                // Perform search
-                transcript_search_algorithm->getBestTranscriptMatches(search_terms, num_best_results, best_transcripts);
+                // Perform search, for whole transcripts or for the passages of transcripts
+                if (show_passages) {
+                    transcript_search_algorithm->getBestPassageMatches(search_terms, num_best_results, query_options, best_passages);
+                } else {
+                    transcript_search_algorithm->getBestTranscriptMatches(search_terms, num_best_results, query_options, best_transcripts);
+                }
 
                 // Finish timing search function
                 auto end_time = std::chrono::high_resolution_clock::now();
                 auto duration = end_time - start_time;
 
+                for (auto& passage : best_passages) {
+                    best_transcripts.emplace_back(passage.path, passage.score);
+                }
+
+                // Extract snippets of the results
+                std::vector<std::vector<transcript_snippet>> snippets;
+                transcript_search_algorithm->getTranscriptSnippets(search_terms, best_transcripts, query_options, snippets);
+
                 // Output the results
-                outputResult(best_transcripts, duration);
+                outputResult(best_transcripts, best_passages, snippets, duration, statistics);
             }
         } else {
             // User exit
@@ -91,9 +199,299 @@ void TranscriptSearcher::runSearch() {
     }
 }
 
+void TranscriptSearcher::runTagging(const std::string& queries_path, const unsigned int num_threads) {
+    std::ifstream queries_file(queries_path);
+    if (!queries_file) {
+        throw std::runtime_error("Error: could not open queries file \"" + queries_path + "\"\n");
+    }
+
+    // Read every query, remembering its line number, and check boolean queries before searching any
+    std::vector<std::vector<std::string>> queries;
+    std::vector<size_t> line_numbers;
+    std::string line;
+    for (size_t line_number = 1; std::getline(queries_file, line); line_number++) {
+        auto search_terms = splitSearchTerms(line);
+        if (search_terms.empty()) {
+            continue;
+        }
+        if (isBooleanQuery(search_terms)) {
+            try {
+                parseBooleanQuery(search_terms);
+            } catch (const std::runtime_error& err) {
+                throw std::runtime_error("Error: invalid query on line " + std::to_string(line_number) + "\n" + err.what());
+            }
+        }
+        queries.push_back(std::move(search_terms));
+        line_numbers.push_back(line_number);
+    }
+
+    // Time the whole batch
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::vector<scored_transcript>> best_matches;
+    transcript_search_algorithm->getBatchTranscriptMatches(queries, num_best_results, options, num_threads, best_matches);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+
+    std::cout << std::setprecision(6) << std::fixed;
+    for (size_t q = 0; q < queries.size(); q++) {
+        for (auto& [path, score] : best_matches[q]) {
+            std::cout << line_numbers[q] << "\t" << score << "\t" << path << "\n";
+        }
+    }
+    std::cout.flush();
+
+    // The summary goes to stderr, keeping stdout to the results
+    double seconds = std::max<int64_t>(1, duration_milliseconds.count()) / 1000.0;
+    std::cerr << "Tagged " << queries.size() << " queries in " << duration_milliseconds.count() << " milliseconds ("
+        << static_cast<size_t>(queries.size() / seconds) << " queries per second)." << std::endl;
+    printBufferPoolStatistics(*transcript_search_algorithm);
+}
+
+// Latency percentile (0-100) of a sorted vector of latencies
+static double percentile(const std::vector<double>& sorted_latencies, const double p) {
+    if (sorted_latencies.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>((p / 100.0) * (sorted_latencies.size() - 1) + 0.5);
+    return sorted_latencies[rank];
+}
+
+// Reads an unsigned integer field of a batch query
+static unsigned int getUnsignedField(const rapidjson::Value& value, const char* name) {
+    if (!value.IsUint()) {
+        throw std::runtime_error(std::string("Error: \"") + name + "\" must be an unsigned integer\n");
+    }
+    return value.GetUint();
+}
+
+std::string TranscriptSearcher::runBatchQuery(const std::string& line, const size_t line_number, std::chrono::nanoseconds& duration_ns) {
+    rapidjson::StringBuffer result_buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> result_writer(result_buffer);
+    result_writer.StartObject();
+    result_writer.Key("line");
+    result_writer.Uint64(line_number);
+
+    try {
+        // Read the query, whose fields override the searcher's options
+        rapidjson::Document query;
+        query.Parse(line.c_str());
+        if (query.HasParseError() || !query.IsObject()) {
+            throw std::runtime_error("Error: query is not a JSON object\n");
+        }
+        std::vector<std::string> search_terms;
+        unsigned int k = num_best_results;
+        search_options query_options = options;
+        for (auto& field : query.GetObject()) {
+            std::string name = field.name.GetString();
+            auto& value = field.value;
+            if (name == "terms" && value.IsString()) {
+                search_terms = splitSearchTerms(value.GetString());
+            } else if (name == "terms" && value.IsArray()) {
+                for (auto& term : value.GetArray()) {
+                    if (!term.IsString()) {
+                        throw std::runtime_error("Error: \"terms\" must only hold strings\n");
+                    }
+                    search_terms.push_back(term.GetString());
+                }
+            } else if (name == "terms") {
+                throw std::runtime_error("Error: \"terms\" must be a string or an array of strings\n");
+            } else if (name == "k") {
+                k = getUnsignedField(value, "k");
+            } else if (name == "proximity_boost") {
+                if (!value.IsNumber()) {
+                    throw std::runtime_error("Error: \"proximity_boost\" must be a number\n");
+                }
+                query_options.proximity_boost = value.GetDouble();
+            } else if (name == "snippets") {
+                query_options.max_snippets = getUnsignedField(value, "snippets");
+            } else if (name == "snippet_words") {
+                query_options.snippet_words = getUnsignedField(value, "snippet_words");
+            } else if (name == "fuzzy") {
+                query_options.max_edit_distance = getUnsignedField(value, "fuzzy");
+            } else if (name == "phonetic") {
+                if (!value.IsBool()) {
+                    throw std::runtime_error("Error: \"phonetic\" must be a boolean\n");
+                }
+                query_options.phonetic = value.GetBool();
+            } else if (name == "strategy") {
+                if (!value.IsString()) {
+                    throw std::runtime_error("Error: \"strategy\" must be a string\n");
+                }
+                query_options.strategy = parseSearchStrategy(value.GetString());
+            } else if (name == "latency_budget") {
+                query_options.latency_budget = std::chrono::microseconds(getUnsignedField(value, "latency_budget"));
+            } else if (name == "impact_bits") {
+                query_options.impact_bits = getUnsignedField(value, "impact_bits");
+            } else {
+                throw std::runtime_error("Error: unknown field \"" + name + "\"\n");
+            }
+        }
+        if (search_terms.empty()) {
+            throw std::runtime_error("Error: no terms entered\n");
+        }
+        if (isBooleanQuery(search_terms)) {
+            parseBooleanQuery(search_terms);
+        }
+
+        // Search, like an interactive search does
+        std::vector<scored_transcript> best_transcripts;
+        std::vector<scored_passage> best_passages;
+        search_statistics statistics;
+        query_options.statistics = &statistics;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        if (show_passages) {
+            transcript_search_algorithm->getBestPassageMatches(search_terms, k, query_options, best_passages);
+        } else {
+            transcript_search_algorithm->getBestTranscriptMatches(search_terms, k, query_options, best_transcripts);
+        }
+        std::chrono::nanoseconds search_duration = std::chrono::high_resolution_clock::now() - start_time;
+        for (auto& passage : best_passages) {
+            best_transcripts.emplace_back(passage.path, passage.score);
+        }
+        std::vector<std::vector<transcript_snippet>> snippets;
+        transcript_search_algorithm->getTranscriptSnippets(search_terms, best_transcripts, query_options, snippets);
+
+        result_writer.Key("results");
+        result_writer.StartArray();
+        for (size_t r = 0; r < best_transcripts.size(); r++) {
+            result_writer.StartObject();
+            result_writer.Key("file");
+            result_writer.String(best_transcripts[r].first.c_str(), best_transcripts[r].first.size());
+            result_writer.Key("score");
+            result_writer.Double(best_transcripts[r].second);
+            if (r < best_passages.size() && best_passages[r].timed) {
+                result_writer.Key("start_time");
+                result_writer.Double(best_passages[r].start_time);
+                result_writer.Key("end_time");
+                result_writer.Double(best_passages[r].end_time);
+            }
+            result_writer.Key("snippets");
+            result_writer.StartArray();
+            for (auto& snippet : snippets[r]) {
+                result_writer.StartObject();
+                result_writer.Key("text");
+                result_writer.String(snippet.text.c_str(), snippet.text.size());
+                result_writer.Key("highlights");
+                result_writer.StartArray();
+                for (auto& [begin, end] : snippet.highlights) {
+                    result_writer.StartArray();
+                    result_writer.Uint(begin);
+                    result_writer.Uint(end);
+                    result_writer.EndArray();
+                }
+                result_writer.EndArray();
+                result_writer.EndObject();
+            }
+            result_writer.EndArray();
+            result_writer.EndObject();
+        }
+        result_writer.EndArray();
+        result_writer.Key("duration_us");
+        result_writer.Int64(std::chrono::duration_cast<std::chrono::microseconds>(search_duration).count());
+        result_writer.Key("snippet_duration_us");
+        result_writer.Int64(std::chrono::duration_cast<std::chrono::microseconds>(statistics.snippet_duration).count());
+        result_writer.Key("strategy");
+        result_writer.String(search_strategy_names[statistics.strategy]);
+        result_writer.Key("approximate");
+        result_writer.Bool(statistics.approximate);
+        duration_ns = search_duration;
+    } catch (const std::runtime_error& err) {
+        // Errors end with a newline, for the terminal
+        std::string error = err.what();
+        while (!error.empty() && error.back() == '\n') {
+            error.pop_back();
+        }
+        result_writer.Key("error");
+        result_writer.String(error.c_str(), error.size());
+    }
+
+    result_writer.EndObject();
+    return std::string(result_buffer.GetString(), result_buffer.GetSize());
+}
+
+void TranscriptSearcher::runBatch(const std::string& queries_path, const unsigned int num_threads) {
+    std::ifstream queries_file(queries_path);
+    if (!queries_file) {
+        throw std::runtime_error("Error: could not open queries file \"" + queries_path + "\"\n");
+    }
+
+    // Blank lines are skipped, but still counted in line numbers
+    std::vector<std::string> lines;
+    std::vector<size_t> line_numbers;
+    std::string line;
+    for (size_t line_number = 1; std::getline(queries_file, line); line_number++) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            lines.push_back(line);
+            line_numbers.push_back(line_number);
+        }
+    }
+
+    // Threads take the next query in turn, and results are printed in the order of the file once all are done
+    size_t threads = num_threads != 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, lines.size()));
+    std::vector<std::string> results(lines.size());
+    std::vector<std::chrono::nanoseconds> durations(lines.size(), std::chrono::nanoseconds(-1));
+    std::atomic<size_t> next_query = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> searchers;
+    for (size_t t = 0; t < threads; t++) {
+        searchers.emplace_back([&] {
+            for (size_t q = next_query++; q < lines.size(); q = next_query++) {
+                results[q] = runBatchQuery(lines[q], line_numbers[q], durations[q]);
+            }
+        });
+    }
+    for (auto& searcher : searchers) {
+        searcher.join();
+    }
+    auto run_duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time);
+
+    for (auto& result : results) {
+        std::cout << result << "\n";
+    }
+    std::cout.flush();
+
+    // The summary goes to stderr, keeping stdout to the results
+    std::vector<double> latencies_us;
+    for (auto duration : durations) {
+        if (duration.count() >= 0) {
+            latencies_us.push_back(std::chrono::duration<double, std::micro>(duration).count());
+        }
+    }
+    std::sort(latencies_us.begin(), latencies_us.end());
+    double mean_latency = 0.0;
+    for (auto latency : latencies_us) {
+        mean_latency += latency / latencies_us.size();
+    }
+    std::cerr << std::setprecision(1) << std::fixed;
+    std::cerr << "Searched " << latencies_us.size() << " queries (" << lines.size() - latencies_us.size() << " invalid) in "
+        << run_duration.count() * 1000.0 << " ms on " << threads << (threads == 1 ? " thread: " : " threads: ")
+        << latencies_us.size() / std::max(run_duration.count(), 1e-9) << " queries/s" << std::endl;
+    std::cerr << "latency (us): mean " << mean_latency
+        << " | p50 " << percentile(latencies_us, 50)
+        << " | p95 " << percentile(latencies_us, 95)
+        << " | p99 " << percentile(latencies_us, 99)
+        << " | max " << percentile(latencies_us, 100) << std::endl;
+    printBufferPoolStatistics(*transcript_search_algorithm);
+}
+
+// Formats a time within a recording as hh:mm:ss
+static std::string formatTimestamp(const double seconds) {
+    unsigned int total_seconds = static_cast<unsigned int>(seconds);
+    std::stringstream timestamp;
+    timestamp << std::setfill('0') << std::setw(2) << total_seconds / 3600 << ":"
+        << std::setw(2) << (total_seconds / 60) % 60 << ":" << std::setw(2) << total_seconds % 60;
+    return timestamp.str();
+}
+
 void TranscriptSearcher::outputResult(
     const std::vector<scored_transcript>& result,
-    const std::chrono::nanoseconds duration_ns
+    const std::vector<scored_passage>& passages,
+    const std::vector<std::vector<transcript_snippet>>& snippets,
+    const std::chrono::nanoseconds duration_ns,
+    const search_statistics& statistics
 ) {
     // Format
     std::cout << std::setprecision(2) << std::fixed;
@@ -101,9 +499,36 @@ void TranscriptSearcher::outputResult(
     // Output elapsed time
     auto duration_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration_ns);
     std::cout << "Search took " << std::to_string(duration_microseconds.count()) << " microseconds." << std::endl;
+    // Only algorithms which keep transcripts extract snippets
+    bool has_snippets = std::any_of(snippets.begin(), snippets.end(), [](auto& result_snippets) { return !result_snippets.empty(); });
+    if (options.max_snippets > 0 && has_snippets) {
+        auto snippet_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(statistics.snippet_duration);
+        std::cout << "Snippets took " << std::to_string(snippet_microseconds.count()) << " microseconds." << std::endl;
+    }
+    if (statistics.strategy != STRATEGY_AUTOMATIC) {
+        std::cout << "Evaluated with " << search_strategy_names[statistics.strategy] << "." << std::endl;
+    }
+    if (statistics.approximate) {
+        std::cout << "Ran out of time: these are the best results found so far." << std::endl;
+    }
 
-    // Output each of the results
-    for (auto& element : result) {
-        std::cout << "Score: " << std::setw(5) << std::left << element.second << " | File: " << element.first << std::endl;
+    // Output each of the results, and its snippets with the matches in brackets
+    for (size_t r = 0; r < result.size(); r++) {
+        auto& element = result[r];
+        std::cout << "Score: " << std::setw(5) << std::left << element.second << " | File: " << element.first;
+        if (r < passages.size() && passages[r].timed) {
+            std::cout << " | " << formatTimestamp(passages[r].start_time) << " - " << formatTimestamp(passages[r].end_time);
+        }
+        std::cout << std::endl;
+        for (auto& snippet : snippets[r]) {
+            std::string highlighted;
+            uint32_t position = 0;
+            for (auto& [begin, end] : snippet.highlights) {
+                highlighted += snippet.text.substr(position, begin - position) + "[" + snippet.text.substr(begin, end - begin) + "]";
+                position = end;
+            }
+            highlighted += snippet.text.substr(position);
+            std::cout << "    ..." << highlighted << "..." << std::endl;
+        }
     }
 }
@@ -9,25 +9,100 @@
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 class TranscriptSearcherSocketIoClient {
     public:
-        TranscriptSearcherSocketIoClient(std::string database_path) {
+        TranscriptSearcherSocketIoClient(
+            std::string database_path,
+            std::string search_algorithm,
+            search_options options,
+            index_warmup_options warmup_options
+        ) : options(options) {
             client.set_open_listener(std::bind(&TranscriptSearcherSocketIoClient::on_connected, this));
             client.set_close_listener(std::bind(&TranscriptSearcherSocketIoClient::on_close, this, std::placeholders::_1));
             client.set_fail_listener(std::bind(&TranscriptSearcherSocketIoClient::on_fail, this));
             client.connect("http://127.0.0.1:8081");
+            transcript_search_algorithm = TranscriptSearcher::createSearchAlgorithm(search_algorithm, database_path, 0, buffer_pool_options(), warmup_options);
+            search_thread = std::thread(&TranscriptSearcherSocketIoClient::search_worker, this);
             bind_events();
-            transcript_search_algorithm = new TfIdfTranscriptSearch(database_path);
         }
 
         void perform_search(
             const std::vector<std::string>& search_terms,
             const unsigned int num_best_results,
-            std::vector<scored_transcript>& best_transcripts) {
-            transcript_search_algorithm->getBestTranscriptMatches(search_terms, num_best_results, best_transcripts);
+            const CancellationToken& cancellation,
+            std::vector<scored_transcript>& best_transcripts,
+            std::vector<std::vector<transcript_snippet>>& snippets,
+            search_statistics& statistics) {
+            search_options query_options = options;
+            query_options.statistics = &statistics;
+            query_options.cancellation = &cancellation;
+            transcript_search_algorithm->getBestTranscriptMatches(search_terms, num_best_results, query_options, best_transcripts);
+            if (!statistics.cancelled) {
+                transcript_search_algorithm->getTranscriptSnippets(search_terms, best_transcripts, query_options, snippets);
+            }
+        }
+
+        void search_worker() {
+            // Searches run here rather than on the socket's thread, so that a newer search can cancel the running one
+            std::unique_lock<std::mutex> lock(search_mutex);
+            while (true) {
+                search_ready.wait(lock, [this] { return stopping || pending_search.has_value(); });
+                if (stopping) {
+                    return;
+                }
+                std::vector<std::string> search_terms = std::move(*pending_search);
+                pending_search.reset();
+                auto cancellation = std::make_shared<CancellationToken>();
+                running_cancellation = cancellation;
+                lock.unlock();
+
+                unsigned int num_best_results = 3;
+                std::vector<scored_transcript> best_transcripts;
+                std::vector<std::vector<transcript_snippet>> snippets;
+                search_statistics statistics;
+
+                // Time the search function
+                auto start_time = std::chrono::high_resolution_clock::now();
+
+                perform_search(search_terms, num_best_results, *cancellation, best_transcripts, snippets, statistics);
+
+                // Finish timing search function
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto duration = end_time - start_time;
+
+                // The results of a cancelled search are superseded by those of the newer one
+                if (!statistics.cancelled) {
+                    std::string json_response = jsonify_results(best_transcripts, snippets, duration, statistics);
+                    std::cout << json_response << std::endl;
+                    client.socket()->emit("results", sio::string_message::create(json_response));
+                } else {
+                    std::cout << "Search cancelled by a newer one" << std::endl;
+                }
+
+                lock.lock();
+                running_cancellation.reset();
+            }
         }
     
+        bool validate_query(const std::vector<std::string>& search_terms) {
+            // A malformed boolean query is reported back instead of searched
+            if (isBooleanQuery(search_terms)) {
+                try {
+                    parseBooleanQuery(search_terms);
+                } catch (const std::runtime_error& err) {
+                    std::cerr << err.what();
+                    client.socket()->emit("query_error", sio::string_message::create(err.what()));
+                    return false;
+                }
+            }
+            return true;
+        }
+
         void on_connected() {
             std::cout << "on_connected" << std::endl;
         }
@@ -40,7 +115,32 @@ class TranscriptSearcherSocketIoClient {
             std::cout << "Connection Failed" << std::endl;
         }
 
-        std::string jsonify_results(std::vector<scored_transcript>& results, const std::chrono::nanoseconds duration_ns) {
+        std::string jsonify_snippets(const std::vector<transcript_snippet>& snippets) {
+            // Snippets are cut from normalized transcripts, which hold no quotes or backslashes to escape
+            std::string snippets_json = "[";
+            for (unsigned int i = 0; i < snippets.size(); i++) {
+                snippets_json += "{\"text\": \"" + snippets[i].text + "\", \"highlights\": [";
+                for (unsigned int h = 0; h < snippets[i].highlights.size(); h++) {
+                    auto& [begin, end] = snippets[i].highlights[h];
+                    snippets_json += "[" + std::to_string(begin) + ", " + std::to_string(end) + "]";
+                    if (h != snippets[i].highlights.size() - 1) {
+                        snippets_json += ", ";
+                    }
+                }
+                snippets_json += "]}";
+                if (i != snippets.size() - 1) {
+                    snippets_json += ", ";
+                }
+            }
+            snippets_json += "]";
+            return snippets_json;
+        }
+
+        std::string jsonify_results(
+            std::vector<scored_transcript>& results,
+            const std::vector<std::vector<transcript_snippet>>& snippets,
+            const std::chrono::nanoseconds duration_ns,
+            const search_statistics& statistics) {
             auto duration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration_ns);
             std::string results_json = "{\n\t\"videos\": [\n";
             for (unsigned int i = 0; i < results.size(); i++) {
@@ -49,7 +149,8 @@ class TranscriptSearcherSocketIoClient {
                 std::replace(element.first.begin(), element.first.end(), '\\', '/');
                 results_json += "\t\t{\n";
                 results_json += "\t\t\t\"file\": \"" + element.first + "\",\n";
-                results_json += "\t\t\t\"score\": " + std::to_string(element.second) + "\n";
+                results_json += "\t\t\t\"score\": " + std::to_string(element.second) + ",\n";
+                results_json += "\t\t\t\"snippets\": " + jsonify_snippets(snippets[i]) + "\n";
                 results_json += "\t\t}\n";
                 if (i != results.size() - 1) {
                     results_json += ",";
@@ -58,39 +159,192 @@ class TranscriptSearcherSocketIoClient {
             results_json += "\t],\n";
             results_json += "\t\"duration\": {\n\t\t\"count\": " + std::to_string(duration_milliseconds.count()) + ",\n";
             results_json += "\t\t\"unit\": \"ms\"\n";
-            results_json += "\t}\n";
+            results_json += "\t},\n";
+            auto snippet_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(statistics.snippet_duration);
+            results_json += "\t\"snippet_duration\": {\n\t\t\"count\": " + std::to_string(snippet_microseconds.count()) + ",\n";
+            results_json += "\t\t\"unit\": \"us\"\n";
+            results_json += "\t},\n";
+            results_json += "\t\"strategy\": \"" + std::string(search_strategy_names[statistics.strategy]) + "\",\n";
+            results_json += "\t\"approximate\": " + std::string(statistics.approximate ? "true" : "false") + "\n";
             results_json += "}";
             return results_json;
         }
 
         void perform_search_handler(std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
             if (data->get_flag() == sio::message::flag::flag_array) {
+                // An element with several words is searched as a phrase, and elements may also be boolean operators
                 std::vector<std::string> search_terms;
                 for (auto& message : data->get_vector()) {
                     search_terms.push_back(message->get_string());
                 }
+                if (!validate_query(search_terms)) {
+                    return;
+                }
+
+                // Typing ahead makes the running search useless, and replaces one still waiting to run
+                std::lock_guard<std::mutex> lock(search_mutex);
+                if (running_cancellation) {
+                    running_cancellation->cancel();
+                }
+                pending_search = std::move(search_terms);
+                search_ready.notify_one();
+            }
+        }
+
+        std::string jsonify_passages(std::vector<scored_passage>& passages, const std::chrono::nanoseconds duration_ns) {
+            auto duration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration_ns);
+            std::string results_json = "{\n\t\"passages\": [\n";
+            for (unsigned int i = 0; i < passages.size(); i++) {
+                auto& passage = passages[i];
+                std::replace(passage.path.begin(), passage.path.end(), '\\', '/');
+                results_json += "\t\t{\n";
+                results_json += "\t\t\t\"file\": \"" + passage.path + "\",\n";
+                if (passage.timed) {
+                    results_json += "\t\t\t\"start_time\": " + std::to_string(passage.start_time) + ",\n";
+                    results_json += "\t\t\t\"end_time\": " + std::to_string(passage.end_time) + ",\n";
+                }
+                results_json += "\t\t\t\"score\": " + std::to_string(passage.score) + "\n";
+                results_json += "\t\t}\n";
+                if (i != passages.size() - 1) {
+                    results_json += ",";
+                }
+            }
+            results_json += "\t],\n";
+            results_json += "\t\"duration\": {\n\t\t\"count\": " + std::to_string(duration_milliseconds.count()) + ",\n";
+            results_json += "\t\t\"unit\": \"ms\"\n";
+            results_json += "\t}\n";
+            results_json += "}";
+            return results_json;
+        }
+
+        void perform_passage_search_handler(std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+            if (data->get_flag() == sio::message::flag::flag_array) {
+                std::vector<std::string> search_terms;
+                for (auto& message : data->get_vector()) {
+                    search_terms.push_back(message->get_string());
+                }
+                if (!validate_query(search_terms)) {
+                    return;
+                }
+                if (!transcript_search_algorithm->searchesPassages()) {
+                    std::cerr << "Error: the search algorithm does not search passages" << std::endl;
+                    return;
+                }
                 unsigned int num_best_results = 3;
-                std::vector<scored_transcript> best_transcripts;
+                std::vector<scored_passage> best_passages;
 
                 // Time the search function
                 auto start_time = std::chrono::high_resolution_clock::now();
 
-                perform_search(search_terms, num_best_results, best_transcripts);
+                transcript_search_algorithm->getBestPassageMatches(search_terms, num_best_results, options, best_passages);
 
                 // Finish timing search function
                 auto end_time = std::chrono::high_resolution_clock::now();
                 auto duration = end_time - start_time;
 
-                std::string json_response = jsonify_results(best_transcripts, duration);
+                std::string json_response = jsonify_passages(best_passages, duration);
                 std::cout << json_response << std::endl;
-                client.socket()->emit("results", sio::string_message::create(json_response));
+                client.socket()->emit("passage_results", sio::string_message::create(json_response));
+            }
+        }
+
+        void index_document_handler(std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+            // Accept either {"path": ..., "transcript": ...} or [path, transcript]
+            std::string path;
+            std::string transcript;
+            if (data->get_flag() == sio::message::flag::flag_object) {
+                auto& fields = data->get_map();
+                if (!fields.count("path") || !fields.count("transcript")) {
+                    return;
+                }
+                path = fields["path"]->get_string();
+                transcript = fields["transcript"]->get_string();
+            } else if (data->get_flag() == sio::message::flag::flag_array && data->get_vector().size() == 2) {
+                path = data->get_vector()[0]->get_string();
+                transcript = data->get_vector()[1]->get_string();
+            } else {
+                return;
+            }
+
+            // Time the indexing
+            auto start_time = std::chrono::high_resolution_clock::now();
+
+            bool indexed = transcript_search_algorithm->indexDocument(path, transcript);
+
+            // Finish timing indexing
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+
+            std::replace(path.begin(), path.end(), '\\', '/');
+            std::string json_response = "{\n\t\"file\": \"" + path + "\",\n";
+            json_response += "\t\"indexed\": " + std::string(indexed ? "true" : "false") + ",\n";
+            json_response += "\t\"duration\": {\n\t\t\"count\": " + std::to_string(duration_microseconds.count()) + ",\n";
+            json_response += "\t\t\"unit\": \"us\"\n";
+            json_response += "\t}\n";
+            json_response += "}";
+            std::cout << json_response << std::endl;
+            client.socket()->emit("document_indexed", sio::string_message::create(json_response));
+        }
+
+        void autocomplete_handler(std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+            // Accept either {"prefix": ..., "count": ...} or just the prefix
+            std::string prefix;
+            unsigned int num_completions = 5;
+            if (data->get_flag() == sio::message::flag::flag_object) {
+                auto& fields = data->get_map();
+                if (!fields.count("prefix")) {
+                    return;
+                }
+                prefix = fields["prefix"]->get_string();
+                if (fields.count("count") && fields["count"]->get_flag() == sio::message::flag::flag_integer) {
+                    num_completions = static_cast<unsigned int>(fields["count"]->get_int());
+                }
+            } else if (data->get_flag() == sio::message::flag::flag_string) {
+                prefix = data->get_string();
+            } else {
+                return;
             }
+
+            // Time the completion
+            auto start_time = std::chrono::high_resolution_clock::now();
+
+            std::vector<term_completion> completions;
+            transcript_search_algorithm->getCompletions(prefix, num_completions, completions);
+
+            // Finish timing completion
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+
+            // Terms are normalized, so they hold no quotes or backslashes to escape
+            std::string json_response = "{\n\t\"completions\": [\n";
+            for (unsigned int i = 0; i < completions.size(); i++) {
+                json_response += "\t\t{\"term\": \"" + completions[i].term + "\", \"documents\": " + std::to_string(completions[i].document_frequency) + "}";
+                if (i != completions.size() - 1) {
+                    json_response += ",";
+                }
+                json_response += "\n";
+            }
+            json_response += "\t],\n";
+            json_response += "\t\"duration\": {\n\t\t\"count\": " + std::to_string(duration_microseconds.count()) + ",\n";
+            json_response += "\t\t\"unit\": \"us\"\n";
+            json_response += "\t}\n";
+            json_response += "}";
+            client.socket()->emit("completions", sio::string_message::create(json_response));
         }
 
         void bind_events() {
             client.socket()->on("perform_search", sio::socket::event_listener_aux([&](std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
                 perform_search_handler(name, data, isAck, ack_resp);
             }));
+            client.socket()->on("perform_passage_search", sio::socket::event_listener_aux([&](std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+                perform_passage_search_handler(name, data, isAck, ack_resp);
+            }));
+            client.socket()->on("autocomplete", sio::socket::event_listener_aux([&](std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+                autocomplete_handler(name, data, isAck, ack_resp);
+            }));
+            client.socket()->on("index_document", sio::socket::event_listener_aux([&](std::string const& name, sio::message::ptr const& data, bool isAck, sio::message::list &ack_resp) {
+                index_document_handler(name, data, isAck, ack_resp);
+            }));
         }
 
         void close() {
@@ -99,12 +353,31 @@ class TranscriptSearcherSocketIoClient {
         }
 
         ~TranscriptSearcherSocketIoClient() {
+            {
+                std::lock_guard<std::mutex> lock(search_mutex);
+                stopping = true;
+                if (running_cancellation) {
+                    running_cancellation->cancel();
+                }
+                search_ready.notify_one();
+            }
+            search_thread.join();
             delete transcript_search_algorithm;
         }
 
     private:
         sio::client client;
         TranscriptSearchAlgorithm* transcript_search_algorithm = nullptr;
+        search_options options;
+        // Guards the search waiting to run, the token of the running one, and `stopping`
+        std::mutex search_mutex;
+        std::condition_variable search_ready;
+        // Search terms of the latest search not yet started, if any
+        std::optional<std::vector<std::string>> pending_search;
+        // Token of the running search, cancelled when a newer search arrives
+        std::shared_ptr<CancellationToken> running_cancellation;
+        bool stopping = false;
+        std::thread search_thread;
 };
 
 int main (int argc, char** argv) {
@@ -112,6 +385,18 @@ int main (int argc, char** argv) {
     // Configure the CLI
     argparse::ArgumentParser program("transcript_searcher_socketio_client");
     program.add_argument("database_path").default_value(std::string{"application.db"});
+    program.add_argument("-a", "--search_algorithm").default_value(std::string{"tf-idf"});
+    program.add_argument("--proximity_boost").default_value(0.0).scan<'g', double>();
+    program.add_argument("--snippets").help("number of snippets sent per result").default_value(1u).scan<'u', unsigned int>();
+    program.add_argument("--snippet_words").default_value(16u).scan<'u', unsigned int>();
+    program.add_argument("--fuzzy").help("largest edit distance at which search terms match mis-spelled terms (0 to 2, with tf-idf-memory)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--phonetic").help("also match the terms which sound like each search word (with tf-idf-memory)").default_value(false).implicit_value(true);
+    program.add_argument("--latency_budget").help("microseconds after which a search returns its best results so far, flagged as approximate (with tf-idf-memory, 0 for no limit)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--impact_bits").help("rank by impacts quantized to 8 or 16 bits, faster but approximate (with tf-idf-memory, 0 for exact ranking)").default_value(0u).scan<'u', unsigned int>();
+    program.add_argument("--warmup").help("bring the hot sections of the index files into memory at startup: none, prefault or lock (with tf-idf-memory and tf-idf-disk)").default_value(std::string{"none"});
+    program.add_argument("--warmup_background").help("warm up the index files on a background thread, searching meanwhile").default_value(false).implicit_value(true);
+    program.add_argument("--madvise").help("advise the kernel of how each section of the index files is read").default_value(false).implicit_value(true);
+    program.add_argument("--huge_pages").help("copy the dictionary of the index files into transparent huge pages").default_value(false).implicit_value(true);
     try {
         program.parse_args(argc, argv);
     }
@@ -122,8 +407,32 @@ int main (int argc, char** argv) {
     }
 
     std::string database_path = program.get<std::string>("database_path");
+    std::string search_algorithm = program.get<std::string>("--search_algorithm");
+    search_options options;
+    options.proximity_boost = program.get<double>("--proximity_boost");
+    options.max_snippets = program.get<unsigned int>("--snippets");
+    options.snippet_words = program.get<unsigned int>("--snippet_words");
+    options.max_edit_distance = program.get<unsigned int>("--fuzzy");
+    options.phonetic = program.get<bool>("--phonetic");
+    options.latency_budget = std::chrono::microseconds(program.get<unsigned int>("--latency_budget"));
+    options.impact_bits = program.get<unsigned int>("--impact_bits");
+    if (options.impact_bits != 0 && options.impact_bits != 8 && options.impact_bits != 16) {
+        std::cerr << "Error: --impact_bits must be 0, 8 or 16" << std::endl;
+        std::exit(1);
+    }
+
+    index_warmup_options warmup_options;
+    warmup_options.background = program.get<bool>("--warmup_background");
+    warmup_options.advise = program.get<bool>("--madvise");
+    warmup_options.huge_pages = program.get<bool>("--huge_pages");
+    try {
+        warmup_options.mode = parseWarmupMode(program.get<std::string>("--warmup"));
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::exit(1);
+    }
 
-    TranscriptSearcherSocketIoClient client(database_path);
+    TranscriptSearcherSocketIoClient client(database_path, search_algorithm, options, warmup_options);
     while (true) {
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
@@ -0,0 +1,94 @@
+#include "trigram_index.h"
+#include "galloping_search.h"
+#include <algorithm>
+#include <cctype>
+#include <span>
+
+// Number of characters in a trigram
+static const size_t trigram_length = 3;
+
+// Packs the (lower cased) trigram starting at a position of a string
+static uint32_t packTrigram(std::string_view text, const size_t position) {
+    uint32_t trigram = 0;
+    for (size_t c = 0; c < trigram_length; c++) {
+        trigram = (trigram << 8) | static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(text[position + c])));
+    }
+    return trigram;
+}
+
+// Collects the distinct trigrams of a string, sorted
+static void collectTrigrams(std::string_view text, std::vector<uint32_t>& text_trigrams) {
+    text_trigrams.clear();
+    for (size_t position = 0; position + trigram_length <= text.size(); position++) {
+        text_trigrams.push_back(packTrigram(text, position));
+    }
+    std::sort(text_trigrams.begin(), text_trigrams.end());
+    text_trigrams.erase(std::unique(text_trigrams.begin(), text_trigrams.end()), text_trigrams.end());
+}
+
+TrigramIndex::TrigramIndex(const size_t num_strings, std::function<std::string_view(uint32_t)> get_string)
+    : get_string(std::move(get_string)) {
+    // Pair each trigram with the string containing it in a single integer, so that one sort groups them by trigram
+    std::vector<uint64_t> entries;
+    std::vector<uint32_t> text_trigrams;
+    for (uint32_t id = 0; id < num_strings; id++) {
+        collectTrigrams(this->get_string(id), text_trigrams);
+        for (auto trigram : text_trigrams) {
+            entries.push_back((static_cast<uint64_t>(trigram) << 32) | id);
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    string_ids.reserve(entries.size());
+    for (auto entry : entries) {
+        uint32_t trigram = static_cast<uint32_t>(entry >> 32);
+        if (trigrams.empty() || trigrams.back() != trigram) {
+            trigrams.push_back(trigram);
+            offsets.push_back(string_ids.size());
+        }
+        string_ids.push_back(static_cast<uint32_t>(entry));
+    }
+    offsets.push_back(string_ids.size());
+}
+
+void TrigramIndex::findSubstring(std::string_view substring, std::vector<uint32_t>& matches) const {
+    matches.clear();
+    if (substring.size() < trigram_length) {
+        return;
+    }
+
+    // The list of every trigram of the substring, rarest first
+    std::vector<uint32_t> substring_trigrams;
+    collectTrigrams(substring, substring_trigrams);
+    std::vector<std::span<const uint32_t>> lists;
+    for (auto trigram : substring_trigrams) {
+        auto it = std::lower_bound(trigrams.begin(), trigrams.end(), trigram);
+        if (it == trigrams.end() || *it != trigram) {
+            return;
+        }
+        size_t t = it - trigrams.begin();
+        lists.emplace_back(string_ids.data() + offsets[t], string_ids.data() + offsets[t + 1]);
+    }
+    std::sort(lists.begin(), lists.end(), [](auto& a, auto& b) { return a.size() < b.size(); });
+
+    // Candidates contain every trigram, and are then checked for the substring itself
+    std::vector<uint32_t> cursors(lists.size(), 0);
+    auto equal_ignoring_case = [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    };
+    for (auto id : lists[0]) {
+        bool in_all = true;
+        for (size_t l = 1; l < lists.size() && in_all; l++) {
+            auto it = gallopLowerBound(lists[l].begin() + cursors[l], lists[l].end(), id);
+            cursors[l] = it - lists[l].begin();
+            in_all = it != lists[l].end() && *it == id;
+        }
+        if (!in_all) {
+            continue;
+        }
+        std::string_view text = get_string(id);
+        if (std::search(text.begin(), text.end(), substring.begin(), substring.end(), equal_ignoring_case) != text.end()) {
+            matches.push_back(id);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#include "worker_thread.h"
+
+WorkerThread::WorkerThread() : thread(&WorkerThread::run, this) {}
+
+void WorkerThread::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    tasks_available.notify_one();
+}
+
+void WorkerThread::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            tasks_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                // Stopping and nothing left to do
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+WorkerThread::~WorkerThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    tasks_available.notify_one();
+    thread.join();
+}
@@ -40,7 +40,7 @@ class TfIdfTranscriptPreprocessor(TranscriptPreprocessor):
         self.__conn = sqlite3.connect(db_path)
         self.__cur = self.__conn.cursor()
 
-    def preprocess(self, path, transcript):
+    def preprocess(self, path, transcript, segments=None):
         """Preprocess the transcript for a given path according to the supported search algorithm
 
         Args:
@@ -48,9 +48,11 @@ class TfIdfTranscriptPreprocessor(TranscriptPreprocessor):
                 Path of source file from which the transcript was generated
             transcript: String
                 Text transcript of speech in source file
+            segments: List
+                Timed segments of the transcript (dicts with "start", "end" and "text"), if known
         """
         # Clean up transcript by removing punctuation and converting to lowercase
-        transcript = transcript.translate(str.maketrans(dict.fromkeys(string.punctuation))).lower()
+        transcript = self.__clean(transcript)
 
         # Generate document term frequencies
         term_frequencies = self.__get_term_frequencies(transcript)
@@ -59,6 +61,22 @@ class TfIdfTranscriptPreprocessor(TranscriptPreprocessor):
         self.__insert_document(path, transcript, json.dumps(term_frequencies), len(term_frequencies))
         self.__update_terms(path, term_frequencies)
 
+        # Store the timed segments, cleaned up the same way, for passage-level search
+        if segments:
+            self.__insert_segments(path, segments)
+
+    def __clean(self, text):
+        """Remove punctuation from text and convert it to lowercase
+
+        Args:
+            text: String
+                Text to clean up
+
+        Returns:
+            Cleaned up text
+        """
+        return text.translate(str.maketrans(dict.fromkeys(string.punctuation))).lower()
+
     def __get_term_frequencies(self, transcript):
         """Generate a dictionary of terms and their number of appearances in a transcript
 
@@ -93,6 +111,19 @@ class TfIdfTranscriptPreprocessor(TranscriptPreprocessor):
         self.__cur.execute("INSERT INTO documents VALUES (?, ?, ?, ?)", data)
         self.__conn.commit()
 
+    def __insert_segments(self, path, segments):
+        """Insert the timed segments of a document's transcript into the database
+
+        Args:
+            path: String
+                Path to this document's original file location (from which transcript was generated)
+            segments: List
+                Timed segments of the transcript (dicts with "start" and "end" in seconds, and "text")
+        """
+        data = [(path, segment["start"], segment["end"], self.__clean(segment["text"])) for segment in segments]
+        self.__cur.executemany("INSERT INTO segments VALUES (?, ?, ?, ?)", data)
+        self.__conn.commit()
+
     def __update_terms(self, document, term_frequencies):
         """Update the database's global state for the terms which appear in a document
 
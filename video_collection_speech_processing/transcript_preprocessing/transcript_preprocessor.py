@@ -8,7 +8,7 @@ class TranscriptPreprocessor(ABC):
     """
     
     @abstractmethod
-    def preprocess(self, path, transcript):
+    def preprocess(self, path, transcript, segments=None):
         """Preprocess a source file given its transcript
 
         Args:
@@ -16,6 +16,8 @@ class TranscriptPreprocessor(ABC):
                 Path to source file of the transcript
             transcript: String
                 Corresponding transcript to the source file
+            segments: List
+                Timed segments of the transcript (dicts with "start", "end" and "text"), if known
         """
         pass
 
@@ -56,10 +56,10 @@ class VideoCollectionSpeechProcessor:
             if not self.__transcript_preprocessor.exists(video_abspath):
                 # Update counter
                 counter += 1
-                # Get raw text transcript
-                transcript = self.__video_transcriber.transcribe_source(video_abspath)
+                # Get raw text transcript, and its timed segments
+                transcript, segments = self.__video_transcriber.transcribe_source(video_abspath)
                 # Perform preprocessing (algorithm dependent)
-                self.__transcript_preprocessor.preprocess(video_abspath, transcript)
+                self.__transcript_preprocessor.preprocess(video_abspath, transcript, segments)
         return counter
 
 
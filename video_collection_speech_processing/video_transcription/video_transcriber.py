@@ -27,20 +27,21 @@ class VideoTranscriber:
                 Path of file to be transcribed
 
         Returns:
-            Text transcription of the speech detected in the source file
+            Text transcription of the speech detected in the source file, and the list of timed
+            segments it is made of (dicts with "start" and "end" in seconds, and "text")
         """
         # Split audio from video into a temporary audio file
         audio_path = tempfile.NamedTemporaryFile().name + ".mp3"
         self.__extract_audio(path, audio_path)
 
         # Perform speech-to-text
-        transcript = self.__speech_to_text(audio_path)
+        transcript, segments = self.__speech_to_text(audio_path)
 
         # Remove the temporary audio file used as speech to text input
         if os.path.isfile(audio_path):
             os.remove(audio_path)
 
-        return transcript
+        return transcript, segments
 
     def __extract_audio(self, video_path, audio_path):
         """
@@ -63,7 +64,13 @@ class VideoTranscriber:
                 Path to source audio file
 
         Returns:
-            Text transcription of the speech detected in the source audio file
+            Text transcription of the speech detected in the source audio file, and the list of timed
+            segments it is made of (dicts with "start" and "end" in seconds, and "text")
         """
         result = self.__speech_model.transcribe(audio_path, language="english")
-        return result["text"]
+        # Keep Whisper's segment timings so that search results can point into the recording
+        segments = [
+            {"start": segment["start"], "end": segment["end"], "text": segment["text"]}
+            for segment in result["segments"]
+        ]
+        return result["text"], segments